@@ -0,0 +1,368 @@
+//-----------------------------------------------------------------------------
+// Our main() function for the regeneration benchmark, which loads each model
+// of a corpus, and times the loading, regeneration, Booleans, triangulation
+// and exports of it separately; the results are written as JSON lines, one
+// per model and phase, so that runs can be compared by a script.
+//-----------------------------------------------------------------------------
+#include <chrono>
+#include <dirent.h>
+#include <errno.h>
+#include <limits.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "solvespace.h"
+#include "headless.h"
+
+using namespace SolveSpace;
+
+struct Model {
+    std::string name;
+    std::string path;
+    std::string scratchDir;
+};
+
+typedef std::chrono::steady_clock Clock;
+
+static double MillisecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// Each phase performs its operation once on the loaded model, and returns how
+// long that took, in milliseconds; the setup that it needs isn't timed.
+typedef double (*PhaseFunction)(const Model &model);
+
+static bool LoadModel(const Model &model, double *loadTime, double *linkTime) {
+    SS.saveFile = model.path;
+
+    Clock::time_point start = Clock::now();
+    bool loaded = SS.LoadFromFile(model.path);
+    *loadTime = MillisecondsSince(start);
+    if(!loaded) return false;
+
+    start = Clock::now();
+    bool linked = SS.ReloadAllImported(/*canCancel=*/true);
+    *linkTime = MillisecondsSince(start);
+    return linked;
+}
+
+static double Regenerate(const Model &) {
+    Clock::time_point start = Clock::now();
+    SS.GenerateAll(SolveSpaceUI::Generate::ALL);
+    return MillisecondsSince(start);
+}
+
+// Regenerate the whole model, with the display items of the active group, and
+// return how long the profiler saw regeneration spend in the given phase, for
+// all groups and wherever that phase was nested; so we time just what the
+// real regeneration does, and no copy of it. A phase that never ran, like
+// the Booleans of an assembly of linked parts, takes no time.
+static double ProfiledPhase(Profiler::Phase phase) {
+    SS.profiler.Clear();
+    SS.GenerateAll(SolveSpaceUI::Generate::ALL);
+    SK.GetGroup(SS.GW.activeGroup)->GenerateDisplayItems();
+    return SS.profiler.TotalForPhase(phase).time;
+}
+
+static double Booleans(const Model &) {
+    return ProfiledPhase(Profiler::Phase::BOOLEAN);
+}
+
+static double Triangulate(const Model &) {
+    return ProfiledPhase(Profiler::Phase::TRIANGULATE);
+}
+
+static double DisplayItems(const Model &) {
+    for(int i = 0; i < SK.groupOrder.n; i++) {
+        SK.GetGroup(SK.groupOrder.elem[i])->displayDirty = true;
+    }
+    Group *g = SK.GetGroup(SS.GW.activeGroup);
+
+    Clock::time_point start = Clock::now();
+    g->GenerateDisplayItems();
+    return MillisecondsSince(start);
+}
+
+static std::string ScratchFile(const Model &model, const std::string &ext) {
+    return model.scratchDir + "/export." + ext;
+}
+
+// The exports report failure only through Error(), so a phase whose export
+// failed is marked with a negative time, to be reported as such.
+static double Finish(Clock::time_point start, const std::string &filename) {
+    double elapsed = MillisecondsSince(start);
+    remove(filename.c_str());
+    if(TakeHeadlessErrorCount() > 0) return -1;
+    return elapsed;
+}
+
+static double ExportMesh(const Model &model, const std::string &ext) {
+    std::string filename = ScratchFile(model, ext);
+    Clock::time_point start = Clock::now();
+    SS.ExportMeshTo(filename);
+    return Finish(start, filename);
+}
+
+static double ExportSurfaces(const Model &model, const std::string &ext) {
+    std::string filename = ScratchFile(model, ext);
+    Clock::time_point start = Clock::now();
+    StepFileWriter sfw = {};
+    sfw.ExportSurfacesTo(filename);
+    return Finish(start, filename);
+}
+
+static double ExportView(const Model &model, const std::string &ext, bool wireframe) {
+    std::string filename = ScratchFile(model, ext);
+    Clock::time_point start = Clock::now();
+    SS.ExportViewOrWireframeTo(filename, wireframe);
+    return Finish(start, filename);
+}
+
+static const struct {
+    const char    *name;
+    PhaseFunction  function;
+} Phases[] = {
+    { "regenerate",     Regenerate   },
+    { "boolean",        Booleans     },
+    { "triangulate",    Triangulate  },
+    { "display",        DisplayItems },
+    { "export-stl",     [](const Model &m) { return ExportMesh(m, "stl"); } },
+    { "export-obj",     [](const Model &m) { return ExportMesh(m, "obj"); } },
+    { "export-js",      [](const Model &m) { return ExportMesh(m, "js"); } },
+    { "export-step",    [](const Model &m) { return ExportSurfaces(m, "step"); } },
+    { "export-svg",     [](const Model &m) { return ExportView(m, "svg", false); } },
+    { "export-pdf",     [](const Model &m) { return ExportView(m, "pdf", false); } },
+    { "export-dxf",     [](const Model &m) { return ExportView(m, "dxf", false); } },
+    { "export-wireframe-step",
+                        [](const Model &m) { return ExportView(m, "step", true); } },
+};
+
+/* Results */
+
+static std::string JsonString(const std::string &s) {
+    std::string out = "\"";
+    for(char c : s) {
+        if(c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if((unsigned char)c < 0x20) {
+            char buf[8];
+            sprintf(buf, "\\u%04x", c);
+            out += buf;
+        } else {
+            out += c;
+        }
+    }
+    return out + "\"";
+}
+
+static void Report(FILE *out, const Model &model, const char *phase,
+                   std::vector<double> times) {
+    bool ok = !times.empty();
+    for(double t : times) {
+        if(t < 0) ok = false;
+    }
+
+    fprintf(out, "{\"model\":%s,\"phase\":%s,\"ok\":%s",
+            JsonString(model.name).c_str(), JsonString(phase).c_str(),
+            ok ? "true" : "false");
+    if(ok) {
+        std::sort(times.begin(), times.end());
+        fprintf(out, ",\"runs\":%d,\"min_ms\":%.3f,\"median_ms\":%.3f,\"max_ms\":%.3f",
+                (int)times.size(), times.front(), times[times.size() / 2], times.back());
+    }
+    fprintf(out, "}\n");
+    fflush(out);
+}
+
+/* Corpus */
+
+static bool EndsWith(const std::string &s, const std::string &suffix) {
+    return s.size() >= suffix.size() &&
+           s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+// A directory stands for all of the models directly inside it, in name order,
+// so that the results of two runs line up.
+static bool AddModels(const std::string &arg, std::vector<Model> *models) {
+    struct stat st;
+    if(stat(arg.c_str(), &st)) {
+        fprintf(stderr, "%s: %s\n", arg.c_str(), strerror(errno));
+        return false;
+    }
+
+    std::vector<std::string> paths;
+    if(S_ISDIR(st.st_mode)) {
+        DIR *dir = opendir(arg.c_str());
+        if(!dir) {
+            fprintf(stderr, "%s: %s\n", arg.c_str(), strerror(errno));
+            return false;
+        }
+        while(struct dirent *entry = readdir(dir)) {
+            std::string name = entry->d_name;
+            if(EndsWith(name, ".slvs")) paths.push_back(arg + "/" + name);
+        }
+        closedir(dir);
+        std::sort(paths.begin(), paths.end());
+    } else {
+        paths.push_back(arg);
+    }
+
+    for(const std::string &path : paths) {
+        char absolute[PATH_MAX];
+        if(!realpath(path.c_str(), absolute)) {
+            fprintf(stderr, "%s: %s\n", path.c_str(), strerror(errno));
+            return false;
+        }
+
+        Model model = {};
+        model.name = path.substr(path.rfind('/') + 1);
+        model.path = absolute;
+        models->push_back(model);
+    }
+    return true;
+}
+
+static bool RunModel(FILE *out, const Model &model, int runs,
+                     const std::vector<std::string> &phases) {
+    auto selected = [&](const char *phase) {
+        return phases.empty() ||
+               std::find(phases.begin(), phases.end(), phase) != phases.end();
+    };
+
+    // Loading replaces the whole sketch, so each run loads from scratch.
+    std::vector<double> loadTimes, linkTimes;
+    for(int i = 0; i < runs; i++) {
+        double loadTime, linkTime;
+        TakeHeadlessErrorCount();
+        if(!LoadModel(model, &loadTime, &linkTime)) {
+            fprintf(stderr, "%s: cannot load model\n", model.path.c_str());
+            Report(out, model, "load", {});
+            SS.saveFile = "";
+            SS.NewFile();
+            SS.AfterNewFile();
+            return false;
+        }
+        loadTimes.push_back(loadTime);
+        linkTimes.push_back(linkTime);
+    }
+    if(selected("load")) Report(out, model, "load", loadTimes);
+    if(selected("link")) Report(out, model, "link", linkTimes);
+
+    SS.AfterNewFile();
+    TakeHeadlessErrorCount();
+
+    for(const auto &phase : Phases) {
+        if(!selected(phase.name)) continue;
+
+        std::vector<double> times;
+        for(int i = 0; i < runs; i++) {
+            times.push_back(phase.function(model));
+        }
+        Report(out, model, phase.name, times);
+    }
+    return true;
+}
+
+static void ShowUsage(const char *argv0) {
+    fprintf(stderr,
+"Usage: %s [OPTION]... MODEL...\n"
+"Time the loading, regeneration and export of each MODEL, which is either\n"
+"a .slvs file or a directory of them; the results are written as one line\n"
+"of JSON per model and phase.\n"
+"\n"
+"  -n, --runs N         time each phase N times, and report the minimum,\n"
+"                       median and maximum (default: 5)\n"
+"  -p, --phase NAME     time only the phase NAME; may be given more than once\n"
+"  -l, --list           list the phases and exit\n"
+"  -o, --output FILE    write the results to FILE instead of stdout\n"
+"  -h, --help           show this help\n",
+        argv0);
+}
+
+int main(int argc, char **argv) {
+    // Our file format must have a period as the decimal separator no matter
+    // what the user's locale is.
+    setlocale(LC_ALL, "C");
+
+    InitHeadless(argv[0]);
+
+    std::vector<Model> models;
+    std::vector<std::string> phases;
+    std::string outputFile;
+    int runs = 5;
+
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto needValue = [&]() -> std::string {
+            if(i + 1 >= argc) {
+                fprintf(stderr, "%s: option '%s' requires an argument\n",
+                        argv[0], arg.c_str());
+                exit(2);
+            }
+            return argv[++i];
+        };
+
+        if(arg == "-h" || arg == "--help") {
+            ShowUsage(argv[0]);
+            return 0;
+        } else if(arg == "-l" || arg == "--list") {
+            printf("load\nlink\n");
+            for(const auto &phase : Phases) printf("%s\n", phase.name);
+            return 0;
+        } else if(arg == "-n" || arg == "--runs") {
+            runs = atoi(needValue().c_str());
+            if(runs < 1) {
+                fprintf(stderr, "%s: number of runs must be at least 1\n", argv[0]);
+                return 2;
+            }
+        } else if(arg == "-p" || arg == "--phase") {
+            phases.push_back(needValue());
+        } else if(arg == "-o" || arg == "--output") {
+            outputFile = needValue();
+        } else if(arg.size() > 1 && arg[0] == '-') {
+            fprintf(stderr, "%s: unrecognized option '%s'\n", argv[0], arg.c_str());
+            ShowUsage(argv[0]);
+            return 2;
+        } else if(!AddModels(arg, &models)) {
+            return 1;
+        }
+    }
+
+    if(models.empty()) {
+        ShowUsage(argv[0]);
+        return 2;
+    }
+
+    FILE *out = stdout;
+    if(!outputFile.empty()) {
+        out = ssfopen(outputFile, "w");
+        if(!out) {
+            fprintf(stderr, "%s: %s\n", outputFile.c_str(), strerror(errno));
+            return 1;
+        }
+    }
+
+    char scratchDir[] = "/tmp/solvespace-benchmark.XXXXXX";
+    if(!mkdtemp(scratchDir)) {
+        fprintf(stderr, "%s: cannot create a scratch directory: %s\n",
+                argv[0], strerror(errno));
+        return 1;
+    }
+
+    SS.Init();
+
+    bool success = true;
+    for(Model &model : models) {
+        model.scratchDir = scratchDir;
+        if(!RunModel(out, model, runs, phases)) success = false;
+    }
+
+    rmdir(scratchDir);
+    if(out != stdout) fclose(out);
+
+    SK.Clear();
+    SS.Clear();
+
+    return success ? 0 : 1;
+}
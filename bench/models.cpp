@@ -0,0 +1,261 @@
+//-----------------------------------------------------------------------------
+// Our main() function for generating the stress models of the benchmark: the
+// ones that are too big to keep in the repository, and those that are made to
+// push one part of regeneration much harder than a typical model does. Each
+// is built through the same calls that the UI makes, and then saved.
+//-----------------------------------------------------------------------------
+#include "solvespace.h"
+#include "headless.h"
+
+using namespace SolveSpace;
+
+static std::string OutputDir;
+
+static Vector V(double x, double y) {
+    return Vector::From(x, y, 0);
+}
+
+static hRequest Line(Vector a, Vector b) {
+    hRequest hr = SS.GW.AddRequest(Request::Type::LINE_SEGMENT, /*rememberForUndo=*/false);
+    SK.GetEntity(hr.entity(1))->PointForceTo(a);
+    SK.GetEntity(hr.entity(2))->PointForceTo(b);
+    return hr;
+}
+
+static hRequest Circle(Vector c, double r) {
+    hRequest hr = SS.GW.AddRequest(Request::Type::CIRCLE, /*rememberForUndo=*/false);
+    SK.GetEntity(hr.entity(1))->PointForceTo(c);
+    SK.GetEntity(hr.entity(64))->DistanceForceTo(r);
+    return hr;
+}
+
+static hConstraint Constrain(Constraint::Type type, hEntity ptA, hEntity ptB,
+                             hEntity entityA, hEntity entityB = Entity::NO_ENTITY,
+                             double valA = 0.0) {
+    hConstraint hc = Constraint::Constrain(type, ptA, ptB, entityA, entityB,
+                                           /*other=*/false, /*other2=*/false);
+    SK.GetConstraint(hc)->valA = valA;
+    return hc;
+}
+
+static void NewFile() {
+    SS.saveFile = "";
+    SS.NewFile();
+    SS.AfterNewFile();
+}
+
+static void NewWorkplaneThrough(hEntity point) {
+    SS.GW.ClearSelection();
+    SS.GW.MakeSelected(point);
+    Group::MenuGroup(Command::GROUP_WRKPL);
+    SS.GW.ClearSelection();
+}
+
+static void Extrude(Group::CombineAs how, double depth) {
+    Group::MenuGroup(Command::GROUP_EXTRUDE);
+    Group *g = SK.GetGroup(SS.GW.activeGroup);
+    g->meshCombine = how;
+    if(how == Group::CombineAs::DIFFERENCE) g->subtype = Group::Subtype::TWO_SIDED;
+    SS.GenerateAll(SolveSpaceUI::Generate::ALL);
+    SK.GetGroup(SS.GW.activeGroup)->ExtrusionForceVectorTo(Vector::From(0, 0, depth));
+}
+
+static void Lathe(hRequest axis) {
+    SS.GW.ClearSelection();
+    SS.GW.MakeSelected(axis.entity(0));
+    Group::MenuGroup(Command::GROUP_LATHE);
+    SS.GW.ClearSelection();
+    SS.GenerateAll(SolveSpaceUI::Generate::ALL);
+}
+
+static bool Save(const std::string &name) {
+    std::string filename = OutputDir + "/" + name;
+    SS.saveFile = filename;
+    SS.GenerateAll(SolveSpaceUI::Generate::ALL);
+    if(!SS.SaveToFile(filename)) {
+        fprintf(stderr, "%s: cannot save\n", filename.c_str());
+        return false;
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// A large 2d sketch that's fully dimensioned, for the constraint solver: a
+// row of rectangles in each of several workplanes, each with a circle at its
+// middle. Neighbouring rectangles share a corner and have equal heights, so
+// that each workplane makes one big system, but small enough to be solved.
+//-----------------------------------------------------------------------------
+static bool MakeConstrainedSketch() {
+    const int    WORKPLANES = 4;
+    const int    CELLS      = 100;
+    const double HEIGHT     = 10;
+
+    NewFile();
+    hEntity origin;
+    for(int w = 0; w < WORKPLANES; w++) {
+        if(w > 0) NewWorkplaneThrough(origin);
+
+        double y0 = 2 * HEIGHT * w, y1 = y0 + HEIGHT;
+        double x0 = 0;
+        hRequest prevBottom, prevLeft;
+        for(int i = 0; i < CELLS; i++) {
+            double width = 5 + (i % 7), x1 = x0 + width;
+            hRequest bottom = Line(V(x0, y0), V(x1, y0)),
+                     right  = Line(V(x1, y0), V(x1, y1)),
+                     top    = Line(V(x1, y1), V(x0, y1)),
+                     left   = Line(V(x0, y1), V(x0, y0));
+            hRequest diagonal = Line(V(x0, y0), V(x1, y1));
+            SK.GetRequest(diagonal)->construction = true;
+            hRequest circle = Circle(V((x0 + x1) / 2, (y0 + y1) / 2), width / 4);
+            if(w == 0 && i == 0) origin = bottom.entity(1);
+
+            Constraint::ConstrainCoincident(bottom.entity(2), right.entity(1));
+            Constraint::ConstrainCoincident(right.entity(2),  top.entity(1));
+            Constraint::ConstrainCoincident(top.entity(2),    left.entity(1));
+            Constraint::ConstrainCoincident(left.entity(2),   bottom.entity(1));
+            Constraint::ConstrainCoincident(diagonal.entity(1), bottom.entity(1));
+            Constraint::ConstrainCoincident(diagonal.entity(2), top.entity(1));
+            Constrain(Constraint::Type::HORIZONTAL, Entity::NO_ENTITY, Entity::NO_ENTITY,
+                      bottom.entity(0));
+            Constrain(Constraint::Type::HORIZONTAL, Entity::NO_ENTITY, Entity::NO_ENTITY,
+                      top.entity(0));
+            Constrain(Constraint::Type::VERTICAL, Entity::NO_ENTITY, Entity::NO_ENTITY,
+                      left.entity(0));
+            Constrain(Constraint::Type::VERTICAL, Entity::NO_ENTITY, Entity::NO_ENTITY,
+                      right.entity(0));
+            Constrain(Constraint::Type::PT_PT_DISTANCE, bottom.entity(1), bottom.entity(2),
+                      Entity::NO_ENTITY, Entity::NO_ENTITY, width);
+            Constrain(Constraint::Type::AT_MIDPOINT, circle.entity(1), Entity::NO_ENTITY,
+                      diagonal.entity(0));
+            Constrain(Constraint::Type::DIAMETER, Entity::NO_ENTITY, Entity::NO_ENTITY,
+                      circle.entity(0), Entity::NO_ENTITY, width / 2);
+            if(i == 0) {
+                Constrain(Constraint::Type::PT_PT_DISTANCE, left.entity(1), left.entity(2),
+                          Entity::NO_ENTITY, Entity::NO_ENTITY, HEIGHT);
+                if(w == 0) {
+                    Constrain(Constraint::Type::WHERE_DRAGGED, bottom.entity(1),
+                              Entity::NO_ENTITY, Entity::NO_ENTITY);
+                }
+            } else {
+                Constraint::ConstrainCoincident(bottom.entity(1), prevBottom.entity(2));
+                Constrain(Constraint::Type::EQUAL_LENGTH_LINES, Entity::NO_ENTITY,
+                          Entity::NO_ENTITY, left.entity(0), prevLeft.entity(0));
+            }
+
+            prevBottom = bottom;
+            prevLeft   = left;
+            x0 = x1;
+        }
+    }
+    if(!Save("constrained.slvs")) return false;
+
+    for(int i = 0; i < SK.groupOrder.n; i++) {
+        Group *g = SK.GetGroup(SK.groupOrder.elem[i]);
+        if(g->solved.how != SolveResult::OKAY) {
+            fprintf(stderr, "constrained.slvs: group '%s' doesn't solve\n",
+                    g->DescriptionString().c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// An extruded profile with very many line segments, like a fine gear.
+//-----------------------------------------------------------------------------
+static bool MakeGear() {
+    const int SEGMENTS = 1200;
+
+    NewFile();
+    std::vector<Vector> points;
+    for(int i = 0; i < SEGMENTS; i++) {
+        double t = 2*PI*i/SEGMENTS, r = (i % 2) ? 50 : 47;
+        points.push_back(V(r*cos(t), r*sin(t)));
+    }
+    for(int i = 0; i < SEGMENTS; i++) {
+        Line(points[i], points[(i + 1) % SEGMENTS]);
+    }
+    Extrude(Group::CombineAs::UNION, 10);
+    return Save("gear.slvs");
+}
+
+//-----------------------------------------------------------------------------
+// A torus with holes drilled through it, finely curved everywhere; and an
+// assembly of many instances of it.
+//-----------------------------------------------------------------------------
+static bool MakeTorus() {
+    NewFile();
+    hRequest base = Line(V(0, 0), V(1, 0));
+    SK.GetRequest(base)->construction = true;
+    hRequest axis = Line(V(50, 120), V(50, 160));
+    SK.GetRequest(axis)->construction = true;
+    Circle(V(70, 140), 6);
+    Lathe(axis);
+    for(int k = 0; k < 6; k++) {
+        NewWorkplaneThrough(base.entity(1));
+        Circle(V(50 + 20*cos(k), 140 + 20*sin(k)), 3);
+        Extrude(Group::CombineAs::DIFFERENCE, 30);
+    }
+    return Save("torus.slvs");
+}
+
+static bool MakeAssembly(int instances) {
+    NewFile();
+    for(int i = 0; i < instances; i++) {
+        RecentFile[0] = OutputDir + "/torus.slvs";
+        Group::MenuGroup(Command::RECENT_LINK);
+        SK.GetGroup(SS.GW.activeGroup)->TransformImportedBy(
+            Vector::From((i % 10) * 60.0, (i / 10) * 60.0, 0), Quaternion::IDENTITY);
+    }
+    return Save(ssprintf("assembly-%d.slvs", instances));
+}
+
+//-----------------------------------------------------------------------------
+// Several tori that cut through each other, forced to triangle meshes, for
+// the mesh Booleans.
+//-----------------------------------------------------------------------------
+static bool MakeTori() {
+    NewFile();
+    hRequest base = Line(V(0, 0), V(1, 0));
+    SK.GetRequest(base)->construction = true;
+    for(int k = 0; k < 4; k++) {
+        if(k > 0) NewWorkplaneThrough(base.entity(1));
+        double x = 50 + 9*k, y = 120 + 4*k;
+        hRequest axis = Line(V(x, y), V(x, y + 40));
+        SK.GetRequest(axis)->construction = true;
+        Circle(V(x + 20, y + 20), 6);
+        Lathe(axis);
+        SK.GetGroup(SS.GW.activeGroup)->forceToMesh = true;
+    }
+    return Save("tori.slvs");
+}
+
+int main(int argc, char **argv) {
+    // Our file format must have a period as the decimal separator no matter
+    // what the user's locale is.
+    setlocale(LC_ALL, "C");
+
+    if(argc != 2) {
+        fprintf(stderr,
+"Usage: %s DIRECTORY\n"
+"Generate the stress models of the benchmark into DIRECTORY.\n",
+            argv[0]);
+        return 2;
+    }
+    OutputDir = argv[1];
+
+    InitHeadless(argv[0]);
+    SS.Init();
+
+    bool success = MakeConstrainedSketch() &&
+                   MakeGear() &&
+                   MakeTorus() &&
+                   MakeAssembly(60) &&
+                   MakeAssembly(200) &&
+                   MakeTori();
+
+    SK.Clear();
+    SS.Clear();
+
+    return success ? 0 : 1;
+}
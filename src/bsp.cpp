@@ -20,13 +20,10 @@ SBsp3 *SBsp3::FromMesh(SMesh *m) {
         mc.AddTriangle(&(m->l.elem[i]));
     }
 
-    srand(0); // Let's be deterministic, at least!
-    int n = mc.l.n;
-    while(n > 1) {
-        int k = rand() % n;
-        n--;
+    // Let's be deterministic, at least!
+    ShuffleDeterministically(mc.l.n, [&](int k, int n) {
         swap(mc.l.elem[k], mc.l.elem[n]);
-    }
+    });
 
     for(i = 0; i < mc.l.n; i++) {
         bsp3 = InsertOrCreate(bsp3, &(mc.l.elem[i]), NULL);
@@ -151,6 +151,7 @@ void GraphicsWindow::PasteClipboard(Vector trans, double theta, double scale) {
            n = wrkpln->NormalN(),
            p = SK.GetEntity(wrkpl->point[0])->PointGetNum();
 
+    BeginBatch();
     ClipboardRequest *cr;
     for(cr = SS.clipboard.r.First(); cr; cr = SS.clipboard.r.NextAfter(cr)) {
         hRequest hr = AddRequest(cr->type, /*rememberForUndo=*/false);
@@ -162,7 +163,7 @@ void GraphicsWindow::PasteClipboard(Vector trans, double theta, double scale) {
         r->construction = cr->construction;
         // Need to regen to get the right number of points, if extraPoints
         // changed.
-        SS.GenerateAll(SolveSpaceUI::Generate::REGEN);
+        GenerateNewRequest(hr);
         SS.MarkGroupDirty(r->group);
         bool hasDistance;
         int i, pts;
@@ -220,6 +221,7 @@ void GraphicsWindow::PasteClipboard(Vector trans, double theta, double scale) {
             MakeSelected(hc);
         }
     }
+    EndBatch();
 
     SS.ScheduleGenerateAll();
 }
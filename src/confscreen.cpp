@@ -346,6 +346,7 @@ bool TextWindow::EditControlDoneForConfiguration(const char *s) {
         }
         case Edit::MAX_SEGMENTS: {
             if(edit.i == 0) {
+                SS.CancelRegeneration();
                 SS.maxSegments = min(1000, max(7, atoi(s)));
                 SS.GenerateAll(SolveSpaceUI::Generate::ALL);
             } else {
@@ -285,8 +285,83 @@ void GraphicsWindow::GroupSelection() {
     }
 }
 
+void GraphicsWindow::HitTestGrid::Build(double width, double height) {
+    cols   = max(1, (int)ceil(width  / CELL_SIZE));
+    rows   = max(1, (int)ceil(height / CELL_SIZE));
+    left   = -width  / 2;
+    bottom = -height / 2;
+    cells.clear();
+    cells.resize(cols * rows);
+    unbounded = {};
+
+    // The lists are built in the same order as the sketch, so that hit
+    // testing breaks ties between equally close items in the same way.
+    for(int i = 0; i < SK.entity.n; i++) {
+        Entity *e = &(SK.entity.elem[i]);
+        bool hasBBox;
+        BBox box = e->GetOrGenerateScreenBBox(&hasBBox);
+        if(!hasBBox) {
+            unbounded.entities.push_back(e->h);
+            continue;
+        }
+
+        int col0, row0, col1, row1;
+        CellRange(box, &col0, &row0, &col1, &row1);
+        for(int row = row0; row <= row1; row++) {
+            for(int col = col0; col <= col1; col++) {
+                cells[row * cols + col].entities.push_back(e->h);
+            }
+        }
+    }
+    for(int i = 0; i < SK.constraint.n; i++) {
+        Constraint *c = &(SK.constraint.elem[i]);
+        bool hasBBox;
+        BBox box = c->GetScreenBBox(&hasBBox);
+        // A hidden constraint measures no distance at all, but it might be
+        // shown without anything else changing.
+        if(!hasBBox) {
+            unbounded.constraints.push_back(c->h);
+            continue;
+        }
+
+        int col0, row0, col1, row1;
+        CellRange(box, &col0, &row0, &col1, &row1);
+        for(int row = row0; row <= row1; row++) {
+            for(int col = col0; col <= col1; col++) {
+                cells[row * cols + col].constraints.push_back(c->h);
+            }
+        }
+    }
+
+    entityCount     = SK.entity.n;
+    constraintCount = SK.constraint.n;
+    valid = true;
+}
+
+// The cells that a bounding box overlaps, once grown by the selection radius.
+// Anything off the screen is assigned to the nearest cells at its edge, since
+// the mouse could be there too, if it's captured.
+void GraphicsWindow::HitTestGrid::CellRange(const BBox &box, int *col0, int *row0,
+                                            int *col1, int *row1) {
+    *col0 = (int)floor((box.minp.x - SELECTION_RADIUS - left)   / CELL_SIZE);
+    *col1 = (int)floor((box.maxp.x + SELECTION_RADIUS - left)   / CELL_SIZE);
+    *row0 = (int)floor((box.minp.y - SELECTION_RADIUS - bottom) / CELL_SIZE);
+    *row1 = (int)floor((box.maxp.y + SELECTION_RADIUS - bottom) / CELL_SIZE);
+    *col0 = max(0, min(cols - 1, *col0));
+    *col1 = max(0, min(cols - 1, *col1));
+    *row0 = max(0, min(rows - 1, *row0));
+    *row1 = max(0, min(rows - 1, *row1));
+}
+
+GraphicsWindow::HitTestGrid::Cell *GraphicsWindow::HitTestGrid::CellAt(Point2d p) {
+    int col = (int)floor((p.x - left)   / CELL_SIZE),
+        row = (int)floor((p.y - bottom) / CELL_SIZE);
+    col = max(0, min(cols - 1, col));
+    row = max(0, min(rows - 1, row));
+    return &cells[row * cols + col];
+}
+
 void GraphicsWindow::HitTestMakeSelection(Point2d mp) {
-    int i;
     double d, dmin = 1e12;
     Selection s = {};
 
@@ -302,12 +377,32 @@ void GraphicsWindow::HitTestMakeSelection(Point2d mp) {
         for(Entity *e = SK.entity.First(); e; e = SK.entity.NextAfter(e)) {
             e->screenBBoxValid = false;
         }
+        hitTestGrid.valid = false;
     }
 
+    // Entities and constraints get added and removed without regenerating,
+    // before the paint that would tell us so.
+    if(!hitTestGrid.valid ||
+            hitTestGrid.entityCount != SK.entity.n ||
+            hitTestGrid.constraintCount != SK.constraint.n) {
+        hitTestGrid.Build(width, height);
+    }
+
+    // Merge what's near the mouse with what we can't tell is not, and
+    // restore the order of the sketch.
+    HitTestGrid::Cell *cell = hitTestGrid.CellAt(mp);
+    std::vector<hEntity> entities;
+    std::merge(cell->entities.begin(), cell->entities.end(),
+               hitTestGrid.unbounded.entities.begin(),
+               hitTestGrid.unbounded.entities.end(),
+               std::back_inserter(entities),
+               [](const hEntity &a, const hEntity &b) { return a.v < b.v; });
+
     // Always do the entities; we might be dragging something that should
     // be auto-constrained, and we need the hover for that.
-    for(i = 0; i < SK.entity.n; i++) {
-        Entity *e = &(SK.entity.elem[i]);
+    for(hEntity he : entities) {
+        Entity *e = SK.entity.FindByIdNoOops(he);
+        if(!e) continue;
         // Don't hover whatever's being dragged.
         if(e->h.request().v == pending.point.request().v) {
             // The one exception is when we're creating a new cubic; we
@@ -332,11 +427,20 @@ void GraphicsWindow::HitTestMakeSelection(Point2d mp) {
     // The constraints and faces happen only when nothing's in progress.
     if(pending.operation == Pending::NONE) {
         // Constraints
-        for(i = 0; i < SK.constraint.n; i++) {
-            d = SK.constraint.elem[i].GetDistance(mp);
+        std::vector<hConstraint> constraints;
+        std::merge(cell->constraints.begin(), cell->constraints.end(),
+                   hitTestGrid.unbounded.constraints.begin(),
+                   hitTestGrid.unbounded.constraints.end(),
+                   std::back_inserter(constraints),
+                   [](const hConstraint &a, const hConstraint &b) { return a.v < b.v; });
+
+        for(hConstraint hc : constraints) {
+            Constraint *c = SK.constraint.FindByIdNoOops(hc);
+            if(!c) continue;
+            d = c->GetDistance(mp);
             if(d < SELECTION_RADIUS && d < dmin) {
                 s = {};
-                s.constraint = SK.constraint.elem[i].h;
+                s.constraint = c->h;
                 dmin = d;
             }
         }
@@ -344,9 +448,7 @@ void GraphicsWindow::HitTestMakeSelection(Point2d mp) {
         // Faces, from the triangle mesh; these are lowest priority
         if(s.constraint.v == 0 && s.entity.v == 0 && showShaded && showFaces) {
             Group *g = SK.GetGroup(activeGroup);
-            SMesh *m = &(g->displayMesh);
-
-            uint32_t v = m->FirstIntersectionWith(mp);
+            uint32_t v = g->displayBvh.FirstIntersectionWith(&(g->displayMesh), mp);
             if(v) {
                 s.entity.v = v;
             }
@@ -355,6 +457,7 @@ void GraphicsWindow::HitTestMakeSelection(Point2d mp) {
 
     if(!s.Equals(&hover)) {
         hover = s;
+        hitTestGrid.paintIsForHover = true;
         PaintGraphics();
     }
 }
@@ -453,6 +556,11 @@ void GraphicsWindow::Paint() {
     int i;
     havePainted = true;
 
+    // Whatever made us paint, other than a new hover, might have moved
+    // or resized something on the screen.
+    if(!hitTestGrid.paintIsForHover) hitTestGrid.valid = false;
+    hitTestGrid.paintIsForHover = false;
+
     int w, h;
     GetGraphicsWindowSize(&w, &h);
     width = w; height = h;
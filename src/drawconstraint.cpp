@@ -30,9 +30,20 @@ void Constraint::LineDrawOrGetDistance(Vector a, Vector b) {
 
         double d = dogd.mp.DistanceToLine(ap, bp.Minus(ap), /*asSegment=*/true);
         dogd.dmin = min(dogd.dmin, d);
+        IncludeInScreenBBox(ap);
+        IncludeInScreenBBox(bp);
     }
 }
 
+void Constraint::IncludeInScreenBBox(Point2d p, double r) {
+    Vector v = Vector::From(p.x, p.y, 0);
+    if(!dogd.hasScreenBBox) {
+        dogd.screenBBox = BBox::From(v, v);
+        dogd.hasScreenBBox = true;
+    }
+    dogd.screenBBox.Include(v, max(r, 0.0));
+}
+
 static void LineCallback(void *fndata, Vector a, Vector b)
 {
     Constraint *c = (Constraint *)fndata;
@@ -112,6 +123,8 @@ void Constraint::DoLabel(Vector ref, Vector *labelPos, Vector gr, Vector gu) {
         double d = dogd.mp.DistanceToLine(a, b.Minus(a), /*asSegment=*/true);
 
         dogd.dmin = min(dogd.dmin, d - (th / 2));
+        IncludeInScreenBBox(a, th / 2);
+        IncludeInScreenBBox(b, th / 2);
     }
 }
 
@@ -670,6 +683,7 @@ void Constraint::DrawOrGetDistance(Vector *labelPos, Vector *refps) {
                     // same center; so if the point is visible, then this
                     // constraint cannot be selected. But that's okay.
                     dogd.dmin = min(dogd.dmin, pp.DistanceTo(dogd.mp) - 3);
+                    IncludeInScreenBBox(pp, 3);
                 }
                 return;
             }
@@ -936,6 +950,7 @@ void Constraint::DrawOrGetDistance(Vector *labelPos, Vector *refps) {
                 if(refps) refps[0] = refps[1] = textAt;
                 Point2d ref = SS.GW.ProjectPoint(textAt);
                 dogd.dmin = min(dogd.dmin, ref.DistanceTo(dogd.mp)-10);
+                IncludeInScreenBBox(ref, 10);
             }
             return;
         }
@@ -1136,6 +1151,7 @@ s:
                     if(refps) refps[0] = refps[1] = m.Plus(offset);
                     Point2d ref = SS.GW.ProjectPoint(m.Plus(offset));
                     dogd.dmin = min(dogd.dmin, ref.DistanceTo(dogd.mp)-10);
+                    IncludeInScreenBBox(ref, 10);
                 }
             } else {
                 Vector a = SK.GetEntity(ptA)->PointGetNum();
@@ -1170,6 +1186,7 @@ s:
                         if(refps) refps[0] = refps[1] = c;
                         Point2d ref = SS.GW.ProjectPoint(c);
                         dogd.dmin = min(dogd.dmin, ref.DistanceTo(dogd.mp)-6);
+                        IncludeInScreenBBox(ref, 6);
                     }
                 }
             }
@@ -1213,12 +1230,22 @@ double Constraint::GetDistance(Point2d mp) {
     dogd.sel = NULL;
     dogd.mp = mp;
     dogd.dmin = 1e12;
+    dogd.hasScreenBBox = false;
 
     DrawOrGetDistance(NULL, NULL);
 
     return dogd.dmin;
 }
 
+BBox Constraint::GetScreenBBox(bool *hasBBox) {
+    // Wherever the mouse is, it's no closer to the constraint than to this
+    // box; so we don't need to hit test unless it's within the box.
+    GetDistance(Point2d::From(0, 0));
+
+    *hasBBox = dogd.hasScreenBBox;
+    return dogd.screenBBox;
+}
+
 Vector Constraint::GetLabelPos() {
     dogd.drawing = false;
     dogd.sel = NULL;
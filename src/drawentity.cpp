@@ -39,67 +39,216 @@ void Entity::LineDrawOrGetDistance(Vector a, Vector b, bool maybeFat, int data)
     }
 }
 
-void Entity::DrawAll(bool drawAsHidden) {
-    // This handles points as a special case, because I seem to be able
-    // to get a huge speedup that way, by consolidating stuff to gl.
-    int i;
-    if(SS.GW.showPoints) {
-        double s = 3.5/SS.GW.scale;
-        Vector r = SS.GW.projRight.ScaledBy(s);
-        Vector d = SS.GW.projUp.ScaledBy(s);
-        ssglColorRGB(Style::Color(Style::DATUM));
-        ssglDepthRangeOffset(6);
-        glBegin(GL_QUADS);
-        for(i = 0; i < SK.entity.n; i++) {
-            Entity *e = &(SK.entity.elem[i]);
-            if(!e->IsPoint()) continue;
-            if(!(SK.GetGroup(e->group)->IsVisible())) continue;
-            if(e->forceHidden) continue;
+// The pattern that a line in this style is drawn with, either normally or as
+// a hidden line.
+static void GetStipple(hStyle hs, bool drawAsHidden,
+                       StipplePattern *stippleType, double *stippleScale) {
+    if(drawAsHidden) {
+        *stippleType = Style::PatternType({ Style::HIDDEN_EDGE });
+        *stippleScale = Style::StippleScaleMm({ Style::HIDDEN_EDGE });
+    } else {
+        *stippleType = Style::PatternType(hs);
+        *stippleScale = Style::StippleScaleMm(hs);
+    }
+}
+
+// Narrow lines in a pattern of dashes are the same in model coordinates
+// however we look at them, so those are the ones that we can cache.
+static bool IsCacheableLine(double lineWidth, StipplePattern stippleType) {
+    return lineWidth <= 3.0 && ssglStippleIsViewIndependent(stippleType);
+}
+
+void EntityDisplayCache::Clear() {
+    valid = false;
+    vertex.Clear();
+    run.Clear();
+    point.Clear();
+    uncached.Clear();
+}
+
+bool EntityDisplayCache::IsStale(bool drawAsHidden) const {
+    if(!valid) return true;
+    if(activeGroup.v != SS.GW.activeGroup.v) return true;
+    if(!EXACT(chordTol == SS.ChordTolMm())) return true;
+
+    for(const Run &r : run) {
+        StipplePattern stippleType;
+        double stippleScale;
+        GetStipple(r.hs, drawAsHidden, &stippleType, &stippleScale);
+        if(!IsCacheableLine(Style::Width(r.hs), stippleType)) return true;
+        if(stippleType != r.stippleType) return true;
+        if(stippleType != StipplePattern::CONTINUOUS &&
+           !EXACT(stippleScale == r.stippleScale)) return true;
+    }
+    return false;
+}
+
+static void AddLineCallback(void *fndata, Vector a, Vector b) {
+    EntityDisplayCache *edc = (EntityDisplayCache *)fndata;
+    for(Vector v : { a, b }) {
+        float f[3] = { (float)v.x, (float)v.y, (float)v.z };
+        for(float c : f) edc->vertex.Add(&c);
+    }
+    edc->run.elem[edc->run.n - 1].count += 2;
+}
 
-            Vector v = e->PointGetNum();
+void EntityDisplayCache::Generate(hGroup hg, bool drawAsHidden) {
+    Clear();
+    valid       = true;
+    activeGroup = SS.GW.activeGroup;
+    chordTol    = SS.ChordTolMm();
+
+    for(int i = 0; i < SK.entity.n; i++) {
+        Entity *e = &(SK.entity.elem[i]);
+        if(e->group.v != hg.v) continue;
+
+        if(e->IsPoint()) {
+            if(e->forceHidden) continue;
 
             // If we're analyzing the sketch to show the degrees of freedom,
             // then we draw big colored squares over the points that are
             // free to move.
-            bool free = false;
-            if(e->type == Type::POINT_IN_3D) {
+            Point pt = {};
+            pt.p = e->PointGetNum();
+            if(e->type == Entity::Type::POINT_IN_3D) {
                 Param *px = SK.GetParam(e->param[0]),
                       *py = SK.GetParam(e->param[1]),
                       *pz = SK.GetParam(e->param[2]);
 
-                free = (px->free) || (py->free) || (pz->free);
-            } else if(e->type == Type::POINT_IN_2D) {
+                pt.free = (px->free) || (py->free) || (pz->free);
+            } else if(e->type == Entity::Type::POINT_IN_2D) {
                 Param *pu = SK.GetParam(e->param[0]),
                       *pv = SK.GetParam(e->param[1]);
 
-                free = (pu->free) || (pv->free);
-            }
-            if(free) {
-                Vector re = r.ScaledBy(2.5), de = d.ScaledBy(2.5);
-
-                ssglColorRGB(Style::Color(Style::ANALYZE));
-                ssglVertex3v(v.Plus (re).Plus (de));
-                ssglVertex3v(v.Plus (re).Minus(de));
-                ssglVertex3v(v.Minus(re).Minus(de));
-                ssglVertex3v(v.Minus(re).Plus (de));
-                ssglColorRGB(Style::Color(Style::DATUM));
+                pt.free = (pu->free) || (pv->free);
             }
+            point.Add(&pt);
+            continue;
+        }
 
-            ssglVertex3v(v.Plus (r).Plus (d));
-            ssglVertex3v(v.Plus (r).Minus(d));
-            ssglVertex3v(v.Minus(r).Minus(d));
-            ssglVertex3v(v.Minus(r).Plus (d));
+        bool isCurve = false;
+        switch(e->type) {
+            case Entity::Type::LINE_SEGMENT:
+            case Entity::Type::CIRCLE:
+            case Entity::Type::ARC_OF_CIRCLE:
+            case Entity::Type::CUBIC:
+            case Entity::Type::CUBIC_PERIODIC:
+            case Entity::Type::TTF_TEXT:
+                isCurve = true;
+                break;
+
+            default:
+                break;
         }
-        glEnd();
+
+        hStyle hs = Style::ForEntity(e->h);
+        StipplePattern stippleType;
+        double stippleScale;
+        GetStipple(hs, drawAsHidden, &stippleType, &stippleScale);
+        if(!isCurve || !IsCacheableLine(Style::Width(hs), stippleType)) {
+            uncached.Add(&e->h);
+            continue;
+        }
+        // The visibility of the group and of the style get checked when we
+        // draw, since neither of those needs us to regenerate.
+        if(e->forceHidden) continue;
+
+        bool styled = (e->style.v != 0);
+        Run *last = (run.n > 0) ? &run.elem[run.n - 1] : NULL;
+        if(!last || last->hs.v != hs.v || last->styled != styled) {
+            Run r = {};
+            r.hs           = hs;
+            r.styled       = styled;
+            r.stippleType  = stippleType;
+            r.stippleScale = stippleScale;
+            r.first        = vertex.n / 3;
+            run.Add(&r);
+        }
+
+        SEdgeList *sel = e->GetOrGenerateEdges();
+        for(const SEdge &se : sel->l) {
+            ssglStippledLine(se.a, se.b, stippleType, stippleScale,
+                             AddLineCallback, this);
+        }
+    }
+}
+
+void EntityDisplayCache::DrawPoints() const {
+    double s = 3.5/SS.GW.scale;
+    Vector r = SS.GW.projRight.ScaledBy(s);
+    Vector d = SS.GW.projUp.ScaledBy(s);
+    for(const Point &pt : point) {
+        Vector v = pt.p;
+        if(pt.free) {
+            Vector re = r.ScaledBy(2.5), de = d.ScaledBy(2.5);
+
+            ssglColorRGB(Style::Color(Style::ANALYZE));
+            ssglVertex3v(v.Plus (re).Plus (de));
+            ssglVertex3v(v.Plus (re).Minus(de));
+            ssglVertex3v(v.Minus(re).Minus(de));
+            ssglVertex3v(v.Minus(re).Plus (de));
+            ssglColorRGB(Style::Color(Style::DATUM));
+        }
+
+        ssglVertex3v(v.Plus (r).Plus (d));
+        ssglVertex3v(v.Plus (r).Minus(d));
+        ssglVertex3v(v.Minus(r).Minus(d));
+        ssglVertex3v(v.Minus(r).Plus (d));
+    }
+}
+
+void EntityDisplayCache::Draw(hGroup hg, bool drawAsHidden) const {
+    if(run.n > 0 && SK.GetGroup(hg)->IsVisible()) {
+        // Draw lines from active group in front of those from previous
+        ssglDepthRangeOffset((hg.v == SS.GW.activeGroup.v) ? 4 : 3);
+        glEnableClientState(GL_VERTEX_ARRAY);
+        glVertexPointer(3, GL_FLOAT, 0, vertex.elem);
+        for(const Run &r : run) {
+            if(r.styled && !Style::Get(r.hs)->visible) continue;
+            ssglLineWidth((float)Style::Width(r.hs));
+            ssglColorRGB(Style::Color(r.hs));
+            glDrawArrays(GL_LINES, r.first, r.count);
+        }
+        glDisableClientState(GL_VERTEX_ARRAY);
         ssglDepthRangeOffset(0);
     }
 
-    for(i = 0; i < SK.entity.n; i++) {
-        Entity *e = &(SK.entity.elem[i]);
-        if(e->IsPoint()) {
-            continue; // already handled
+    for(hEntity he : uncached) {
+        SK.GetEntity(he)->Draw(drawAsHidden);
+    }
+}
+
+void Entity::DrawAll(bool drawAsHidden) {
+    // Make sure that the cached lines and points of each group that we'll
+    // draw are current; the reference normals are always shown, even when
+    // their group is hidden.
+    std::vector<std::pair<Group *, EntityDisplayCache *>> caches;
+    for(int i = 0; i < SK.groupOrder.n; i++) {
+        Group *g = SK.GetGroup(SK.groupOrder.elem[i]);
+        if(!g->IsVisible() && g->h.v != Group::HGROUP_REFERENCES.v) continue;
+
+        EntityDisplayCache *edc =
+            drawAsHidden ? &g->displayHiddenEntities : &g->displayEntities;
+        if(edc->IsStale(drawAsHidden)) edc->Generate(g->h, drawAsHidden);
+        caches.emplace_back(g, edc);
+    }
+
+    // This handles points as a special case, because I seem to be able
+    // to get a huge speedup that way, by consolidating stuff to gl.
+    if(SS.GW.showPoints) {
+        ssglColorRGB(Style::Color(Style::DATUM));
+        ssglDepthRangeOffset(6);
+        glBegin(GL_QUADS);
+        for(auto &gc : caches) {
+            if(!gc.first->IsVisible()) continue;
+            gc.second->DrawPoints();
         }
-        e->Draw(drawAsHidden);
+        glEnd();
+        ssglDepthRangeOffset(0);
+    }
+
+    for(auto &gc : caches) {
+        gc.second->Draw(gc.first->h, drawAsHidden);
     }
 }
 
@@ -157,8 +306,10 @@ SEdgeList *Entity::GetOrGenerateEdges() {
 BBox Entity::GetOrGenerateScreenBBox(bool *hasBBox) {
     SBezierList *sbl = GetOrGenerateBezierCurves();
 
-    // We don't bother with bounding boxes for workplanes, etc.
+    // We don't bother with bounding boxes for workplanes, etc. The reference
+    // normals are drawn again in the corner of the screen, so skip them too.
     *hasBBox = (IsPoint() || IsNormal() || sbl->l.n > 0);
+    if(IsNormal() && group.v == Group::HGROUP_REFERENCES.v) *hasBBox = false;
     if(!*hasBBox) return {};
 
     if(screenBBoxValid)
@@ -168,8 +319,20 @@ BBox Entity::GetOrGenerateScreenBBox(bool *hasBBox) {
         Vector proj = SS.GW.ProjectPoint3(PointGetNum());
         screenBBox = BBox::From(proj, proj);
     } else if(IsNormal()) {
-        Vector proj = SK.GetEntity(point[0])->PointGetNum();
+        // The arrow that we draw for the normal, from its point; and one
+        // more pixel, since it's easier to select in the active group.
+        Quaternion q = NormalGetNum();
+        Vector tail = SK.GetEntity(point[0])->PointGetNum();
+        Vector v = (q.RotationN()).WithMagnitude(50/SS.GW.scale);
+        Vector tip = tail.Plus(v);
+        v = v.WithMagnitude(12/SS.GW.scale);
+        Vector axis = q.RotationV();
+        Vector proj = SS.GW.ProjectPoint3(tail);
         screenBBox = BBox::From(proj, proj);
+        screenBBox.Include(proj, 1);
+        screenBBox.Include(SS.GW.ProjectPoint3(tip), 1);
+        screenBBox.Include(SS.GW.ProjectPoint3(tip.Minus(v.RotatedAbout(axis, 0.6))), 1);
+        screenBBox.Include(SS.GW.ProjectPoint3(tip.Minus(v.RotatedAbout(axis, -0.6))), 1);
     } else if(sbl->l.n > 0) {
         Vector first = SS.GW.ProjectPoint3(sbl->l.elem[0].ctrl[0]);
         screenBBox = BBox::From(first, first);
@@ -547,7 +710,7 @@ void Entity::GenerateBezierCurves(SBezierList *sbl) const {
 void Entity::DrawOrGetDistance() {
     // If we're about to perform hit testing on an entity, consider
     // whether the pointer is inside its bounding box first.
-    if(!dogd.drawing && !IsNormal()) {
+    if(!dogd.drawing) {
         bool hasBBox;
         BBox box = GetOrGenerateScreenBBox(&hasBBox);
         if(hasBBox && !box.Contains(dogd.mp, SELECTION_RADIUS))
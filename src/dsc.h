@@ -152,9 +152,9 @@ public:
     int  n;
     int  elemsAllocated;
 
-    void AllocForOneMore() {
-        if(n >= elemsAllocated) {
-            elemsAllocated = (elemsAllocated + 32)*2;
+    void ReserveMore(int howMuch) {
+        if(n + howMuch > elemsAllocated) {
+            elemsAllocated = n + howMuch;
             T *newElem = (T *)MemAlloc((size_t)elemsAllocated*sizeof(elem[0]));
             for(int i = 0; i < n; i++) {
                 new(&newElem[i]) T(std::move(elem[i]));
@@ -165,6 +165,12 @@ public:
         }
     }
 
+    void AllocForOneMore() {
+        if(n >= elemsAllocated) {
+            ReserveMore((elemsAllocated + 32)*2 - n);
+        }
+    }
+
     void Add(const T *t) {
         AllocForOneMore();
         new(&elem[n++]) T(*t);
@@ -261,13 +267,8 @@ public:
     int   elemsAllocated;
 
     uint32_t MaximumId() {
-        uint32_t id = 0;
-
-        int i;
-        for(i = 0; i < n; i++) {
-            id = max(id, elem[i].h.v);
-        }
-        return id;
+        // We're sorted, so that's just the last one.
+        return (n == 0) ? 0 : elem[n - 1].h.v;
     }
 
     H AddAndAssignId(T *t) {
@@ -401,6 +402,31 @@ public:
         RemoveTagged();
     }
 
+    // Remove every element whose handle lies in [first, last]; since we're
+    // sorted, those are all together, and everything after them just moves
+    // down.
+    void RemoveRange(H first, H last) {
+        int lo = 0, hi = n;
+        while(lo < hi) {
+            int mid = (lo + hi)/2;
+            if(elem[mid].h.v < first.v) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        int end = lo;
+        while(end < n && elem[end].h.v <= last.v) end++;
+        if(end == lo) return;
+
+        for(int i = lo; i < end; i++)
+            elem[i].Clear();
+        std::move(elem + end, elem + n, elem + lo);
+        for(int i = n - (end - lo); i < n; i++)
+            elem[i].~T();
+        n -= (end - lo);
+    }
+
     void MoveSelfInto(IdList<T,H> *l) {
         l->Clear();
         *l = *this;
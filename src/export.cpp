@@ -13,6 +13,8 @@
 #include <png.h>
 
 void SolveSpaceUI::ExportSectionTo(const std::string &filename) {
+    FinishRegeneration(/*wait=*/true);
+
     Vector gn = (SS.GW.projRight).Cross(SS.GW.projUp);
     gn = gn.WithMagnitude(1);
 
@@ -81,9 +83,11 @@ void SolveSpaceUI::ExportSectionTo(const std::string &filename) {
     g->runningMesh.MakeEdgesInPlaneInto(&el, n, d);
 
     // If there's a shell, then grab the edges and possibly Beziers.
-    g->runningShell.MakeSectionEdgesInto(n, d,
+    SShell assembled = {};
+    g->GetRunningShell(&assembled)->MakeSectionEdgesInto(n, d,
        &el,
        (SS.exportPwlCurves || fabs(SS.exportOffset) > LENGTH_EPS) ? NULL : &bl);
+    assembled.Clear();
 
     // All of these are solid model edges, so use the appropriate style.
     SEdge *se;
@@ -118,6 +122,8 @@ void SolveSpaceUI::ExportViewOrWireframeTo(const std::string &filename, bool exp
     VectorFileWriter *out = VectorFileWriter::ForFile(filename);
     if(!out) return;
 
+    // Nothing else may be regenerating with the display's tolerances.
+    CancelRegeneration();
     SS.exportMode = true;
     GenerateAll(Generate::ALL);
 
@@ -726,6 +732,8 @@ void VectorFileWriter::BezierAsNonrationalCubic(SBezier *sb, int depth) {
 // Export a triangle mesh, in the requested format.
 //-----------------------------------------------------------------------------
 void SolveSpaceUI::ExportMeshTo(const std::string &filename) {
+    // Nothing else may be regenerating with the display's tolerances.
+    CancelRegeneration();
     SS.exportMode = true;
     GenerateAll(Generate::ALL);
 
@@ -743,6 +751,10 @@ void SolveSpaceUI::ExportMeshTo(const std::string &filename) {
         Error("Couldn't write to '%s'", filename.c_str());
         return;
     }
+    // Big meshes make for big files, written in many small pieces; so give
+    // the stream a buffer that's big enough to make that cheap.
+    std::vector<char> buffer(1 << 20);
+    setvbuf(f, buffer.data(), _IOFBF, buffer.size());
 
     if(FilenameHasExtension(filename, ".stl")) {
         ExportMeshAsStlTo(f, m);
@@ -781,21 +793,32 @@ void SolveSpaceUI::ExportMeshAsStlTo(FILE *f, SMesh *sm) {
     for(i = 0; i < sm->l.n; i++) {
         STriangle *tr = &(sm->l.elem[i]);
         Vector n = tr->Normal().WithMagnitude(1);
-        float w;
-        w = (float)n.x;           fwrite(&w, 4, 1, f);
-        w = (float)n.y;           fwrite(&w, 4, 1, f);
-        w = (float)n.z;           fwrite(&w, 4, 1, f);
-        w = (float)((tr->a.x)/s); fwrite(&w, 4, 1, f);
-        w = (float)((tr->a.y)/s); fwrite(&w, 4, 1, f);
-        w = (float)((tr->a.z)/s); fwrite(&w, 4, 1, f);
-        w = (float)((tr->b.x)/s); fwrite(&w, 4, 1, f);
-        w = (float)((tr->b.y)/s); fwrite(&w, 4, 1, f);
-        w = (float)((tr->b.z)/s); fwrite(&w, 4, 1, f);
-        w = (float)((tr->c.x)/s); fwrite(&w, 4, 1, f);
-        w = (float)((tr->c.y)/s); fwrite(&w, 4, 1, f);
-        w = (float)((tr->c.z)/s); fwrite(&w, 4, 1, f);
-        fputc(0, f);
-        fputc(0, f);
+        // Each record is the normal, the three vertices, and a zero
+        // attribute byte count; assemble it and write it all at once.
+        float w[12] = {
+            (float)n.x,           (float)n.y,           (float)n.z,
+            (float)((tr->a.x)/s), (float)((tr->a.y)/s), (float)((tr->a.z)/s),
+            (float)((tr->b.x)/s), (float)((tr->b.y)/s), (float)((tr->b.z)/s),
+            (float)((tr->c.x)/s), (float)((tr->c.y)/s), (float)((tr->c.z)/s),
+        };
+        uint8_t record[50] = {};
+        memcpy(record, w, sizeof(w));
+        fwrite(record, sizeof(record), 1, f);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Reduce all the identical vertices of the mesh to the same identifier, in
+// order of first appearance, and return the three vertex indices for each
+// triangle. This is a single pass through the spatial hash.
+//-----------------------------------------------------------------------------
+static void WeldMeshVertices(SMesh *sm, SPointHash *sph,
+                             std::vector<int> *indices) {
+    indices->reserve(3 * (size_t)sm->l.n);
+    for(const STriangle &tr : sm->l) {
+        indices->push_back(sph->IndexForPointOrAdd(tr.a));
+        indices->push_back(sph->IndexForPointOrAdd(tr.b));
+        indices->push_back(sph->IndexForPointOrAdd(tr.c));
     }
 }
 
@@ -804,33 +827,26 @@ void SolveSpaceUI::ExportMeshAsStlTo(FILE *f, SMesh *sm) {
 // identical vertices to the same identifier, so do that first.
 //-----------------------------------------------------------------------------
 void SolveSpaceUI::ExportMeshAsObjTo(FILE *f, SMesh *sm) {
-    SPointList spl = {};
-    STriangle *tr;
-    for(tr = sm->l.First(); tr; tr = sm->l.NextAfter(tr)) {
-        spl.IncrementTagFor(tr->a);
-        spl.IncrementTagFor(tr->b);
-        spl.IncrementTagFor(tr->c);
-    }
+    SPointHash sph = {};
+    std::vector<int> indices;
+    WeldMeshVertices(sm, &sph, &indices);
 
     // Output all the vertices.
-    SPoint *sp;
-    for(sp = spl.l.First(); sp; sp = spl.l.NextAfter(sp)) {
+    for(const Vector &p : sph.points) {
         fprintf(f, "v %.10f %.10f %.10f\r\n",
-                        sp->p.x / SS.exportScale,
-                        sp->p.y / SS.exportScale,
-                        sp->p.z / SS.exportScale);
+                        p.x / SS.exportScale,
+                        p.y / SS.exportScale,
+                        p.z / SS.exportScale);
     }
 
     // And now all the triangular faces, in terms of those vertices. The
     // file format counts from 1, not 0.
-    for(tr = sm->l.First(); tr; tr = sm->l.NextAfter(tr)) {
+    for(size_t i = 0; i < indices.size(); i += 3) {
         fprintf(f, "f %d %d %d\r\n",
-                        spl.IndexForPoint(tr->a) + 1,
-                        spl.IndexForPoint(tr->b) + 1,
-                        spl.IndexForPoint(tr->c) + 1);
+                        indices[i] + 1,
+                        indices[i + 1] + 1,
+                        indices[i + 2] + 1);
     }
-
-    spl.Clear();
 }
 
 //-----------------------------------------------------------------------------
@@ -839,7 +855,8 @@ void SolveSpaceUI::ExportMeshAsObjTo(FILE *f, SMesh *sm) {
 void SolveSpaceUI::ExportMeshAsThreeJsTo(FILE *f, const std::string &filename,
                                          SMesh *sm, SEdgeList *sel)
 {
-    SPointList spl = {};
+    SPointHash sph = {};
+    std::vector<int> indices;
     STriangle *tr;
     SEdge *e;
     Vector bndl, bndh;
@@ -947,32 +964,27 @@ void SolveSpaceUI::ExportMeshAsThreeJsTo(FILE *f, const std::string &filename,
     fprintf(f, "    ],\n"
                "    a: %f\n", SS.ambientIntensity);
 
-    for(tr = sm->l.First(); tr; tr = sm->l.NextAfter(tr)) {
-        spl.IncrementTagFor(tr->a);
-        spl.IncrementTagFor(tr->b);
-        spl.IncrementTagFor(tr->c);
-    }
+    WeldMeshVertices(sm, &sph, &indices);
 
     // Output all the vertices.
-    SPoint *sp;
     fputs("  },\n"
           "  points: [\n", f);
-    for(sp = spl.l.First(); sp; sp = spl.l.NextAfter(sp)) {
+    for(const Vector &p : sph.points) {
         fprintf(f, "    [%f, %f, %f],\n",
-                sp->p.x / SS.exportScale,
-                sp->p.y / SS.exportScale,
-                sp->p.z / SS.exportScale);
+                p.x / SS.exportScale,
+                p.y / SS.exportScale,
+                p.z / SS.exportScale);
     }
 
     fputs("  ],\n"
           "  faces: [\n", f);
     // And now all the triangular faces, in terms of those vertices.
     // This time we count from zero.
-    for(tr = sm->l.First(); tr; tr = sm->l.NextAfter(tr)) {
+    for(size_t i = 0; i < indices.size(); i += 3) {
         fprintf(f, "    [%d, %d, %d],\n",
-                spl.IndexForPoint(tr->a),
-                spl.IndexForPoint(tr->b),
-                spl.IndexForPoint(tr->c));
+                indices[i],
+                indices[i + 1],
+                indices[i + 2]);
     }
 
     // Output face normals.
@@ -1012,8 +1024,6 @@ void SolveSpaceUI::ExportMeshAsThreeJsTo(FILE *f, const std::string &filename,
                 CO(SS.GW.offset),
                 CO(SS.GW.projUp),
                 CO(SS.GW.projRight));
-
-    spl.Clear();
 }
 
 //-----------------------------------------------------------------------------
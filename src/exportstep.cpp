@@ -293,8 +293,11 @@ void StepFileWriter::WriteFooter() {
 }
 
 void StepFileWriter::ExportSurfacesTo(const std::string &filename) {
+    SS.FinishRegeneration(/*wait=*/true);
+
     Group *g = SK.GetGroup(SS.GW.activeGroup);
-    SShell *shell = &(g->runningShell);
+    SShell assembled = {};
+    SShell *shell = g->GetRunningShell(&assembled);
 
     if(shell->surface.n == 0) {
         Error("The model does not contain any surfaces to export.%s",
@@ -308,6 +311,7 @@ void StepFileWriter::ExportSurfacesTo(const std::string &filename) {
     f = ssfopen(filename, "wb");
     if(!f) {
         Error("Couldn't write to '%s'", filename.c_str());
+        assembled.Clear();
         return;
     }
 
@@ -352,6 +356,7 @@ void StepFileWriter::ExportSurfacesTo(const std::string &filename) {
 
     fclose(f);
     advancedFaces.Clear();
+    assembled.Clear();
 }
 
 void StepFileWriter::WriteWireframe() {
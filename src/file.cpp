@@ -11,12 +11,15 @@ static int StrStartsWith(const char *str, const char *start) {
     return memcmp(str, start, strlen(start)) == 0;
 }
 
+static void ClearLinkedFiles();
+
 //-----------------------------------------------------------------------------
 // Clear and free all the dynamic memory associated with our currently-loaded
 // sketch. This does not leave the program in an acceptable state (with the
 // references created, and so on), so anyone calling this must fix that later.
 //-----------------------------------------------------------------------------
 void SolveSpaceUI::ClearExisting() {
+    CancelRegeneration();
     UndoClearStack(&redo);
     UndoClearStack(&undo);
 
@@ -33,6 +36,11 @@ void SolveSpaceUI::ClearExisting() {
 
     SK.entity.Clear();
     SK.param.Clear();
+
+    // Nothing refers to the linked files that we read any more.
+    ClearLinkedFiles();
+
+    profiler.Clear();
 }
 
 hGroup SolveSpaceUI::CreateDefaultDrawingGroup() {
@@ -99,6 +107,7 @@ const SolveSpaceUI::SaveTable SolveSpaceUI::SAVED[] = {
     { 'g',  "Group.skipFirst",          'b',    &(SS.sv.g.skipFirst)          },
     { 'g',  "Group.meshCombine",        'd',    &(SS.sv.g.meshCombine)        },
     { 'g',  "Group.forceToMesh",        'd',    &(SS.sv.g.forceToMesh)        },
+    { 'g',  "Group.cutMeshes",          'b',    &(SS.sv.g.cutMeshes)          },
     { 'g',  "Group.predef.q.w",         'f',    &(SS.sv.g.predef.q.w)         },
     { 'g',  "Group.predef.q.vx",        'f',    &(SS.sv.g.predef.q.vx)        },
     { 'g',  "Group.predef.q.vy",        'f',    &(SS.sv.g.predef.q.vy)        },
@@ -323,7 +332,8 @@ bool SolveSpaceUI::SaveToFile(const std::string &filename) {
             CO(tr->a), CO(tr->b), CO(tr->c));
     }
 
-    SShell *s = &g->runningShell;
+    SShell assembled = {};
+    SShell *s = g->GetRunningShell(&assembled);
     SSurface *srf;
     for(srf = s->surface.First(); srf; srf = s->surface.NextAfter(srf)) {
         fprintf(fh, "Surface %08x %08x %08x %d %d\n",
@@ -365,6 +375,7 @@ bool SolveSpaceUI::SaveToFile(const std::string &filename) {
 
         fprintf(fh, "AddCurve\n");
     }
+    assembled.Clear();
 
     fclose(fh);
 
@@ -372,10 +383,27 @@ bool SolveSpaceUI::SaveToFile(const std::string &filename) {
 }
 
 void SolveSpaceUI::LoadUsingTable(char *key, char *val) {
+    auto readLine = [&](char *line, int size) {
+        return fgets(line, size, fh) != NULL;
+    };
+    if(!LoadUsingTable(readLine, &sv, key, val)) {
+        fileLoadError = true;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// The table points into SS.sv, but we may be loading into some other set of
+// variables, so that more than one file can be read at once; find the same
+// field in those. Returns false if the key isn't in the table. Values that
+// span more than one line read the rest through readLine.
+//-----------------------------------------------------------------------------
+bool SolveSpaceUI::LoadUsingTable(const std::function<bool(char *, int)> &readLine,
+                                  SaveVariables *sv, char *key, char *val) {
     int i;
     for(i = 0; SAVED[i].type != 0; i++) {
         if(strcmp(SAVED[i].desc, key)==0) {
-            SAVEDptr *p = (SAVEDptr *)SAVED[i].ptr;
+            size_t offset = (char *)SAVED[i].ptr - (char *)&SS.sv;
+            SAVEDptr *p = (SAVEDptr *)((char *)sv + offset);
             unsigned int u = 0;
             switch(SAVED[i].fmt) {
                 case 'S': p->S() = val;                     break;
@@ -402,7 +430,7 @@ void SolveSpaceUI::LoadUsingTable(char *key, char *val) {
                     for(;;) {
                         EntityMap em;
                         char line2[1024];
-                        if (fgets(line2, (int)sizeof(line2), fh) == NULL)
+                        if(!readLine(line2, (int)sizeof(line2)))
                             break;
                         if(sscanf(line2, "%d %x %d", &(em.h.v), &(em.input.v),
                                                      &(em.copyNumber)) == 3)
@@ -420,9 +448,7 @@ void SolveSpaceUI::LoadUsingTable(char *key, char *val) {
             break;
         }
     }
-    if(SAVED[i].type == 0) {
-        fileLoadError = true;
-    }
+    return (SAVED[i].type != 0);
 }
 
 bool SolveSpaceUI::LoadFromFile(const std::string &filename) {
@@ -515,25 +541,144 @@ bool SolveSpaceUI::LoadFromFile(const std::string &filename) {
     return true;
 }
 
+//-----------------------------------------------------------------------------
+// Readers for the numbers in the mesh and shell records of a file, which is
+// where nearly all of the time goes when loading a linked part. Each one
+// skips leading spaces, advances *s past what it read, and returns false if
+// there was no number there.
+//-----------------------------------------------------------------------------
+static bool ReadHex(const char **s, uint32_t *v) {
+    char *end;
+    *v = (uint32_t)strtoul(*s, &end, 16);
+    if(end == *s) return false;
+    *s = end;
+    return true;
+}
+
+static bool ReadInt(const char **s, int *v) {
+    char *end;
+    *v = (int)strtol(*s, &end, 10);
+    if(end == *s) return false;
+    *s = end;
+    return true;
+}
+
+static bool ReadWord(const char **s, const char *word) {
+    const char *p = *s;
+    while(*p == ' ') p++;
+    size_t len = strlen(word);
+    if(strncmp(p, word, len) != 0) return false;
+    *s = p + len;
+    return true;
+}
+
+// We write doubles with %.20f, and once the trailing zeros are dropped most
+// of them have few enough digits to be converted exactly with one divide by
+// a power of ten. Everything else, like a real 20 digit fraction or an
+// exponent, goes through strtod; either way the result is the correctly
+// rounded one, same as sscanf would give.
+static bool ReadDouble(const char **s, double *v) {
+    static const double Pow10[] = {
+        1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    const char *p = *s;
+    while(*p == ' ') p++;
+    const char *start = p;
+
+    bool negative = (*p == '-');
+    if(*p == '-' || *p == '+') p++;
+
+    const char *intStart = p;
+    while(*p >= '0' && *p <= '9') p++;
+    const char *intEnd = p;
+    const char *fracStart = p, *fracEnd = p;
+    if(*p == '.') {
+        fracStart = ++p;
+        while(*p >= '0' && *p <= '9') p++;
+        fracEnd = p;
+    }
+
+    bool fast = (intEnd != intStart || fracEnd != fracStart) &&
+                (*p == '\0' || *p == ' ');
+    if(fast) {
+        while(fracEnd > fracStart && *(fracEnd - 1) == '0') fracEnd--;
+        while(intStart < intEnd && *intStart == '0') intStart++;
+        int exponent = (int)(fracEnd - fracStart);
+        if(intStart == intEnd) {
+            while(fracStart < fracEnd && *fracStart == '0') fracStart++;
+        }
+
+        uint64_t mantissa = 0;
+        int digits = (int)(intEnd - intStart) + (int)(fracEnd - fracStart);
+        if(digits <= 15 && exponent <= 22) {
+            for(const char *d = intStart; d < intEnd; d++) {
+                mantissa = mantissa * 10 + (uint64_t)(*d - '0');
+            }
+            for(const char *d = fracStart; d < fracEnd; d++) {
+                mantissa = mantissa * 10 + (uint64_t)(*d - '0');
+            }
+            double r = (double)mantissa / Pow10[exponent];
+            *v = negative ? -r : r;
+            *s = p;
+            return true;
+        }
+    }
+
+    char *end;
+    *v = strtod(start, &end);
+    if(end == start) return false;
+    *s = end;
+    return true;
+}
+
+static bool ReadVector(const char **s, Vector *v) {
+    return ReadDouble(s, &v->x) && ReadDouble(s, &v->y) && ReadDouble(s, &v->z);
+}
+
 bool SolveSpaceUI::LoadEntitiesFromFile(const std::string &filename, EntityList *le,
                                         SMesh *m, SShell *sh)
 {
     SSurface srf = {};
     SCurve crv = {};
 
-    fh = ssfopen(filename, "rb");
-    if(!fh) return false;
+    // This may run on several threads at once, one for each linked file, so
+    // use our own variables and not SS.sv. The file is mapped and not read
+    // through stdio, since a linked part may carry a large mesh.
+    size_t size;
+    const char *data = (const char *)ssmmap(filename, &size);
+    if(!data) return false;
+    const char *pos = data, *end = data + size;
+
+    // Reserve the mesh up front, so that it's filled in a single pass.
+    int triangles = 0;
+    for(const char *p = data; p < end; p++) {
+        if(end - p >= 9 && memcmp(p, "Triangle ", 9) == 0) triangles++;
+        p = (const char *)memchr(p, '\n', end - p);
+        if(!p) break;
+    }
+    m->l.ReserveMore(triangles);
+
+    std::function<bool(char *, int)> readLine = [&](char *line, int lineSize) {
+        if(pos >= end) return false;
+        const char *eol = (const char *)memchr(pos, '\n', end - pos);
+        if(!eol) eol = end;
+        size_t len = std::min((size_t)(eol - pos), (size_t)lineSize - 1);
+        memcpy(line, pos, len);
+        line[len] = '\0';
+        pos = (eol < end) ? eol + 1 : end;
+        return true;
+    };
 
     le->Clear();
-    sv = {};
+    SaveVariables sv = {};
 
     char line[1024];
-    while(fgets(line, (int)sizeof(line), fh)) {
-        char *s = strchr(line, '\n');
-        if(s) *s = '\0';
+    while(readLine(line, (int)sizeof(line))) {
         // We should never get files with \r characters in them, but mailers
         // will sometimes mangle attachments.
-        s = strchr(line, '\r');
+        char *s = strchr(line, '\r');
         if(s) *s = '\0';
 
         if(*line == '\0') continue;
@@ -542,7 +687,7 @@ bool SolveSpaceUI::LoadEntitiesFromFile(const std::string &filename, EntityList
         if(e) {
             *e = '\0';
             char *key = line, *val = e+1;
-            LoadUsingTable(key, val);
+            LoadUsingTable(readLine, &sv, key, val);
         } else if(strcmp(line, "AddGroup")==0) {
             // Don't leak memory; these get allocated whether we want them
             // or not.
@@ -562,16 +707,13 @@ bool SolveSpaceUI::LoadEntitiesFromFile(const std::string &filename, EntityList
 
         } else if(StrStartsWith(line, "Triangle ")) {
             STriangle tr = {};
-            unsigned int rgba = 0;
-            if(sscanf(line, "Triangle %x %x  "
-                             "%lf %lf %lf  %lf %lf %lf  %lf %lf %lf",
-                &(tr.meta.face), &rgba,
-                &(tr.a.x), &(tr.a.y), &(tr.a.z),
-                &(tr.b.x), &(tr.b.y), &(tr.b.z),
-                &(tr.c.x), &(tr.c.y), &(tr.c.z)) != 11) {
+            uint32_t rgba = 0;
+            const char *p = line + strlen("Triangle ");
+            if(!(ReadHex(&p, &tr.meta.face) && ReadHex(&p, &rgba) &&
+                 ReadVector(&p, &tr.a) && ReadVector(&p, &tr.b) && ReadVector(&p, &tr.c))) {
                 ssassert(false, "Unexpected Triangle format");
             }
-            tr.meta.color = RgbaColor::FromPackedInt((uint32_t)rgba);
+            tr.meta.color = RgbaColor::FromPackedInt(rgba);
             m->AddTriangle(&tr);
         } else if(StrStartsWith(line, "Surface ")) {
             unsigned int rgba = 0;
@@ -585,9 +727,9 @@ bool SolveSpaceUI::LoadEntitiesFromFile(const std::string &filename, EntityList
             int i, j;
             Vector c;
             double w;
-            if(sscanf(line, "SCtrl %d %d %lf %lf %lf Weight %lf",
-                                &i, &j, &(c.x), &(c.y), &(c.z), &w) != 6)
-            {
+            const char *p = line + strlen("SCtrl ");
+            if(!(ReadInt(&p, &i) && ReadInt(&p, &j) && ReadVector(&p, &c) &&
+                 ReadWord(&p, "Weight") && ReadDouble(&p, &w))) {
                 ssassert(false, "Unexpected SCtrl format");
             }
             srf.ctrl[i][j] = c;
@@ -595,11 +737,9 @@ bool SolveSpaceUI::LoadEntitiesFromFile(const std::string &filename, EntityList
         } else if(StrStartsWith(line, "TrimBy ")) {
             STrimBy stb = {};
             int backwards;
-            if(sscanf(line, "TrimBy %x %d  %lf %lf %lf  %lf %lf %lf",
-                &(stb.curve.v), &backwards,
-                &(stb.start.x), &(stb.start.y), &(stb.start.z),
-                &(stb.finish.x), &(stb.finish.y), &(stb.finish.z)) != 8)
-            {
+            const char *p = line + strlen("TrimBy ");
+            if(!(ReadHex(&p, &stb.curve.v) && ReadInt(&p, &backwards) &&
+                 ReadVector(&p, &stb.start) && ReadVector(&p, &stb.finish))) {
                 ssassert(false, "Unexpected TrimBy format");
             }
             stb.backwards = (backwards != 0);
@@ -622,9 +762,9 @@ bool SolveSpaceUI::LoadEntitiesFromFile(const std::string &filename, EntityList
             int i;
             Vector c;
             double w;
-            if(sscanf(line, "CCtrl %d %lf %lf %lf Weight %lf",
-                                &i, &(c.x), &(c.y), &(c.z), &w) != 5)
-            {
+            const char *p = line + strlen("CCtrl ");
+            if(!(ReadInt(&p, &i) && ReadVector(&p, &c) &&
+                 ReadWord(&p, "Weight") && ReadDouble(&p, &w))) {
                 ssassert(false, "Unexpected CCtrl format");
             }
             crv.exact.ctrl[i] = c;
@@ -632,10 +772,8 @@ bool SolveSpaceUI::LoadEntitiesFromFile(const std::string &filename, EntityList
         } else if(StrStartsWith(line, "CurvePt ")) {
             SCurvePt scpt;
             int vertex;
-            if(sscanf(line, "CurvePt %d %lf %lf %lf",
-                &vertex,
-                &(scpt.p.x), &(scpt.p.y), &(scpt.p.z)) != 4)
-            {
+            const char *p = line + strlen("CurvePt ");
+            if(!(ReadInt(&p, &vertex) && ReadVector(&p, &scpt.p))) {
                 ssassert(false, "Unexpected CurvePt format");
             }
             scpt.vertex = (vertex != 0);
@@ -645,8 +783,9 @@ bool SolveSpaceUI::LoadEntitiesFromFile(const std::string &filename, EntityList
             crv = {};
         } else ssassert(false, "Unexpected operation");
     }
+    sv.g.remap.Clear();
 
-    fclose(fh);
+    ssmunmap(data, size);
     return true;
 }
 
@@ -777,12 +916,139 @@ static std::string PathSepUNIXToPlatform(const std::string &filename)
 #endif
 }
 
+//-----------------------------------------------------------------------------
+// The linked files that we've already read, newest first. A part that's
+// linked many times (like a fastener in an assembly) is read only once, and
+// so is one that hasn't changed since the last time we reloaded. A file that
+// has changed is read into a new entry, since the groups still point into
+// the old one; that's freed once no group uses it any more.
+//-----------------------------------------------------------------------------
+struct LinkedFile {
+    std::string filename; // absolute path
+    int64_t     mtime;
+    int64_t     size;
+    EntityList  entity;
+    SMesh       mesh;
+    SShell      shell;
+
+    void Clear() {
+        entity.Clear();
+        mesh.Clear();
+        shell.Clear();
+    }
+};
+static std::list<LinkedFile> LinkedFileCache;
+
+// The newest entry for the given file, if it's still what's on disk.
+static LinkedFile *FindLinkedFile(const std::string &filename, int64_t mtime, int64_t size) {
+    for(LinkedFile &lf : LinkedFileCache) {
+        if(lf.filename != filename) continue;
+        if(lf.mtime == mtime && lf.size == size) return &lf;
+        break;
+    }
+    return NULL;
+}
+
+static LinkedFile *CacheLinkedFile(const std::string &filename, LinkedFile *lf) {
+    lf->filename = filename;
+    LinkedFileCache.push_front(*lf);
+    return &LinkedFileCache.front();
+}
+
+static bool LinkedFileInUse(const LinkedFile &lf) {
+    for(int i = 0; i < SK.group.n; i++) {
+        Group *g = &(SK.group.elem[i]);
+        if(g->impEntity == &lf.entity || g->impMesh == &lf.mesh ||
+           g->impShell == &lf.shell) return true;
+        // The groups that haven't been regenerated since we reloaded may
+        // still assemble the old version.
+        for(const PartInstance &pi : g->runningInstances) {
+            if(pi.shell == &lf.shell) return true;
+        }
+    }
+    return false;
+}
+
+static void PruneLinkedFiles() {
+    auto it = LinkedFileCache.begin();
+    while(it != LinkedFileCache.end()) {
+        if(LinkedFileInUse(*it)) {
+            ++it;
+        } else {
+            it->Clear();
+            it = LinkedFileCache.erase(it);
+        }
+    }
+}
+
+static void ClearLinkedFiles() {
+    for(LinkedFile &lf : LinkedFileCache) {
+        lf.Clear();
+    }
+    LinkedFileCache.clear();
+}
+
+//-----------------------------------------------------------------------------
+// Read all of the given files that aren't already in the cache, each on its
+// own thread.
+//-----------------------------------------------------------------------------
+static void PreloadLinkedFiles(const std::vector<std::string> &filenames) {
+    std::vector<std::string> toLoad;
+    std::vector<LinkedFile> loaded;
+    for(const std::string &filename : filenames) {
+        if(std::find(toLoad.begin(), toLoad.end(), filename) != toLoad.end()) continue;
+
+        LinkedFile lf = {};
+        if(!ssstat(filename, &lf.mtime, &lf.size)) continue;
+        if(FindLinkedFile(filename, lf.mtime, lf.size)) continue;
+        toLoad.push_back(filename);
+        loaded.push_back(lf);
+    }
+
+    std::vector<char> ok(toLoad.size());
+    ParallelFor((int)toLoad.size(), [&](int i) {
+        LinkedFile *lf = &loaded[i];
+        ok[i] = SolveSpaceUI::LoadEntitiesFromFile(toLoad[i],
+                    &lf->entity, &lf->mesh, &lf->shell);
+    });
+
+    for(size_t i = 0; i < toLoad.size(); i++) {
+        if(ok[i]) {
+            CacheLinkedFile(toLoad[i], &loaded[i]);
+        } else {
+            loaded[i].Clear();
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Get the contents of a linked file, from the cache if it hasn't changed since
+// we last read it. Every group that links the file shares those, until the
+// next time that we reload.
+//-----------------------------------------------------------------------------
+static LinkedFile *LoadLinkedFile(const std::string &filename) {
+    LinkedFile lf = {};
+    if(!ssstat(filename, &lf.mtime, &lf.size)) return NULL;
+    LinkedFile *cached = FindLinkedFile(filename, lf.mtime, lf.size);
+    if(cached) return cached;
+
+    if(!SolveSpaceUI::LoadEntitiesFromFile(filename, &lf.entity, &lf.mesh, &lf.shell)) {
+        lf.Clear();
+        return NULL;
+    }
+    return CacheLinkedFile(filename, &lf);
+}
+
 bool SolveSpaceUI::ReloadAllImported(bool canCancel)
 {
+    // The linked files that we're about to reload may be in use in the
+    // background.
+    CancelRegeneration();
     std::map<std::string, std::string> linkMap;
     allConsistent = false;
 
     int i;
+    std::vector<std::string> linkFiles;
     for(i = 0; i < SK.group.n; i++) {
         Group *g = &(SK.group.elem[i]);
         if(g->type != Group::Type::LINKED) continue;
@@ -794,16 +1060,6 @@ bool SolveSpaceUI::ReloadAllImported(bool canCancel)
             PathSepNormalize(g->linkFileRel);
         }
 
-        g->impEntity.Clear();
-        g->impMesh.Clear();
-        g->impShell.Clear();
-
-        if(linkMap.count(g->linkFile)) {
-            std::string newPath = linkMap[g->linkFile];
-            if(!newPath.empty())
-                g->linkFile = newPath;
-        }
-
         // In a newly created group we only have an absolute path.
         if(!g->linkFileRel.empty()) {
             std::string rel = PathSepUNIXToPlatform(g->linkFileRel);
@@ -819,10 +1075,33 @@ bool SolveSpaceUI::ReloadAllImported(bool canCancel)
                 // updated below.
             }
         }
+        linkFiles.push_back(g->linkFile);
+    }
+
+    // Read all the files that we'll need at once, before we start asking
+    // the user about the ones we can't find.
+    PreloadLinkedFiles(linkFiles);
+
+    for(i = 0; i < SK.group.n; i++) {
+        Group *g = &(SK.group.elem[i]);
+        if(g->type != Group::Type::LINKED) continue;
+
+        g->impEntity = NULL;
+        g->impMesh = NULL;
+        g->impShell = NULL;
+
+        if(linkMap.count(g->linkFile)) {
+            std::string newPath = linkMap[g->linkFile];
+            if(!newPath.empty())
+                g->linkFile = newPath;
+        }
 
 try_load_file:
-        if(LoadEntitiesFromFile(g->linkFile, &(g->impEntity), &(g->impMesh), &(g->impShell)))
-        {
+        LinkedFile *lf = LoadLinkedFile(g->linkFile);
+        if(lf) {
+            g->impEntity = &lf->entity;
+            g->impMesh = &lf->mesh;
+            g->impShell = &lf->shell;
             if(!SS.saveFile.empty()) {
                 // Record the linked file's name relative to our filename;
                 // if the entire tree moves, then everything will still work
@@ -862,6 +1141,10 @@ try_load_file:
         }
     }
 
+    // And forget the files that nothing links any more, and the versions
+    // of them that nothing uses.
+    PruneLinkedFiles();
+
     return true;
 }
 
@@ -7,6 +7,8 @@
 // Copyright 2008-2013 Jonathan Westhues.
 //-----------------------------------------------------------------------------
 #include "solvespace.h"
+#include <atomic>
+#include <thread>
 
 void SolveSpaceUI::MarkGroupDirtyByEntity(hEntity he) {
     Entity *e = SK.GetEntity(he);
@@ -142,8 +144,20 @@ bool SolveSpaceUI::PruneConstraints(hGroup hg) {
 }
 
 void SolveSpaceUI::GenerateAll(Generate type, bool andFindFree, bool genForBBox) {
+    Profiler::Scope scope(Profiler::Phase::REGENERATE);
     int first, last, i, j;
 
+    // Whatever's being regenerated in the background is out of date now; the
+    // groups that it was for are still marked, so they'll get done again.
+    CancelRegeneration();
+    // And this regenerates whatever was left undone while dragging.
+    solvedForDrag = false;
+    // The shells and meshes take longest to regenerate. If they're just for
+    // display, then the user can keep working while that's done in the
+    // background; otherwise, we need them now.
+    bool inBackground = (type == Generate::DIRTY || type == Generate::REGEN) &&
+                        !exportMode && !genForBBox;
+
     SK.groupOrder.Clear();
     for(int i = 0; i < SK.group.n; i++)
         SK.groupOrder.Add(&SK.group.elem[i].h);
@@ -265,7 +279,7 @@ void SolveSpaceUI::GenerateAll(Generate type, bool andFindFree, bool genForBBox)
                     SolveGroup(g->h, andFindFree);
                 } else {
                     g->GenerateLoops();
-                    g->GenerateShellAndMesh();
+                    g->shellDirty = true;
                     g->clean = true;
                 }
             } else {
@@ -282,6 +296,25 @@ void SolveSpaceUI::GenerateAll(Generate type, bool andFindFree, bool genForBBox)
         }
     }
 
+    // The shells and meshes come last, now that every group is solved.
+    if(!genForBBox && !inBackground) {
+        for(i = 0; i < SK.groupOrder.n; i++) {
+            Group *g = SK.GetGroup(SK.groupOrder.elem[i]);
+            if(!g->shellDirty) continue;
+
+            bool prevBooleanFailed = g->booleanFailed,
+                 prevMeshCutFailed = g->meshCutFailed;
+            g->GenerateShellAndMesh();
+            g->shellDirty = false;
+            // If the Boolean failed, then we should note that in the text
+            // screen for this group.
+            if(g->booleanFailed != prevBooleanFailed ||
+               g->meshCutFailed != prevMeshCutFailed) {
+                ScheduleShowTW();
+            }
+        }
+    }
+
     // And update any reference dimensions with their new values
     for(i = 0; i < SK.constraint.n; i++) {
         Constraint *c = &(SK.constraint.elem[i]);
@@ -301,6 +334,14 @@ void SolveSpaceUI::GenerateAll(Generate type, bool andFindFree, bool genForBBox)
     }
 
     prev.Clear();
+    GW.hitTestGrid.valid = false;
+    // All the entities were generated again, so the lines and points that
+    // we kept for drawing them are out of date too.
+    for(i = 0; i < SK.group.n; i++) {
+        Group *g = &(SK.group.elem[i]);
+        g->displayEntities.valid = false;
+        g->displayHiddenEntities.valid = false;
+    }
     InvalidateGraphics();
 
     // Remove nonexistent selection items, for same reason we waited till
@@ -346,6 +387,9 @@ void SolveSpaceUI::GenerateAll(Generate type, bool andFindFree, bool genForBBox)
 
     FreeAllTemporary();
     allConsistent = true;
+    if(inBackground) {
+        StartRegeneration();
+    }
     return;
 
 pruned:
@@ -356,6 +400,290 @@ pruned:
     GenerateAll(type, andFindFree, genForBBox);
 }
 
+//-----------------------------------------------------------------------------
+// Dragging changes only the params of the group being dragged, so if nothing
+// else is dirty, we can solve that group again without generating any
+// entities; they read their new positions from the params when drawn. The
+// loops, shells and meshes are left as they were, and the group stays dirty,
+// so that they're regenerated properly once the drag is over.
+//-----------------------------------------------------------------------------
+void SolveSpaceUI::GenerateForDrag() {
+    int i;
+    Group *g = NULL;
+    if(allConsistent && !later.generateAll) {
+        for(i = 0; i < SK.groupOrder.n; i++) {
+            Group *gi = SK.group.FindByIdNoOops(SK.groupOrder.elem[i]);
+            if(gi == NULL) break;
+            if(gi->h.v == GW.activeGroup.v) {
+                g = gi;
+                break;
+            }
+            if(!gi->clean || !gi->IsSolvedOkay()) break;
+        }
+    }
+    if(g == NULL || g->h.v == Group::HGROUP_REFERENCES.v) {
+        GenerateAll();
+        return;
+    }
+
+    Profiler::Scope scope(Profiler::Phase::REGENERATE);
+    CancelRegeneration();
+    SolveGroup(g->h, /*andFindFree=*/false);
+
+    // The entities are the same ones, but whatever we cached from their old
+    // positions is out of date.
+    for(i = 0; i < SK.entity.n; i++) {
+        Entity *e = &(SK.entity.elem[i]);
+        if(e->group.v != g->h.v) continue;
+        e->Clear();
+        e->screenBBoxValid = false;
+    }
+    g->displayEntities.valid = false;
+    g->displayHiddenEntities.valid = false;
+    GW.hitTestGrid.valid = false;
+
+    for(i = 0; i < SK.constraint.n; i++) {
+        Constraint *c = &(SK.constraint.elem[i]);
+        if(c->reference) {
+            c->ModifyToSatisfy();
+        }
+    }
+    if(traced.point.v) {
+        Entity *pt = SK.GetEntity(traced.point);
+        traced.path.AddPoint(pt->PointGetNum());
+    }
+    InvalidateGraphics();
+
+    if(!solvedForDrag) SetTimerFor(DRAG_PAUSE_MS);
+    solvedForDrag   = true;
+    solvedForDragAt = GetMilliseconds();
+}
+
+void SolveSpaceUI::GenerateAfterDrag(bool onlyIfPaused) {
+    if(!solvedForDrag) return;
+    if(onlyIfPaused) {
+        int64_t since = GetMilliseconds() - solvedForDragAt;
+        if(since < DRAG_PAUSE_MS) {
+            // Still moving, so look again once it might have stopped.
+            SetTimerFor((int)(DRAG_PAUSE_MS - since));
+            return;
+        }
+    }
+
+    solvedForDrag = false;
+    ScheduleGenerateAll();
+}
+
+//-----------------------------------------------------------------------------
+// Regenerating the shells and meshes is usually what takes longest, so when
+// that's only for display, it's done on a thread of its own. That thread works
+// on a copy of the parts of the sketch that it needs, so the user can keep on
+// editing meanwhile; and if the sketch changes before it's done, we just give
+// up on it, and start again.
+//-----------------------------------------------------------------------------
+class SolveSpace::Regeneration {
+public:
+    Sketch              sketch;
+    // The groups to regenerate, in order.
+    std::vector<hGroup> groups;
+    Profiler            profiler;
+    SEdgeList           nakedEdges;
+
+    std::atomic<bool>   cancelled;
+    std::atomic<bool>   finished;
+    std::thread         thread;
+
+    void Run();
+    void Clear();
+};
+
+bool SolveSpace::RegenerationCancelled() {
+    return RegenerationInUse && RegenerationInUse->cancelled;
+}
+
+void Regeneration::Run() {
+    SketchInUse       = &sketch;
+    ProfilerInUse     = &profiler;
+    NakedEdgesInUse   = &nakedEdges;
+    RegenerationInUse = this;
+
+    {
+        Profiler::Scope scope(Profiler::Phase::REGENERATE);
+        for(hGroup hg : groups) {
+            if(cancelled) break;
+            SK.GetGroup(hg)->GenerateShellAndMesh();
+        }
+    }
+
+    finished = true;
+    // And the UI thread will put our results into use when it next can.
+    if(!cancelled) ScheduleLater();
+}
+
+void Regeneration::Clear() {
+    for(Group &g : sketch.group) {
+        g.Clear();
+    }
+    sketch.Clear();
+    nakedEdges.Clear();
+}
+
+void SolveSpaceUI::StartRegeneration() {
+    int i;
+    std::vector<hGroup> groups;
+    for(i = 0; i < SK.groupOrder.n; i++) {
+        Group *g = SK.GetGroup(SK.groupOrder.elem[i]);
+        if(g->shellDirty) groups.push_back(g->h);
+    }
+    if(groups.empty()) return;
+
+    Regeneration *r = new Regeneration();
+    r->groups    = groups;
+    r->cancelled = false;
+    r->finished  = false;
+
+    // Copy the groups the same way as for undo, without anything that we
+    // generate from them; below, we copy what's needed from the groups that
+    // we're not regenerating. The linked files are shared, since those can
+    // only be reloaded after we've been cancelled.
+    Sketch *sk = &(r->sketch);
+    for(i = 0; i < SK.group.n; i++) {
+        Group *src = &(SK.group.elem[i]);
+        Group dest = *src;
+        dest.tag = 0;
+        dest.solved = {};
+        dest.polyLoops = {};
+        dest.bezierLoops = {};
+        dest.bezierOpens = {};
+        dest.thisMesh = {};
+        dest.runningMesh = {};
+        dest.thisShell = {};
+        dest.runningShell = {};
+        dest.runningInstances = {};
+        dest.displayMesh = {};
+        dest.displayBuffers = {};
+        dest.displayBvh = {};
+        dest.displayEdges = {};
+        dest.displayOutlines = {};
+        dest.displayEntities = {};
+        dest.displayHiddenEntities = {};
+
+        dest.remap = {};
+        src->remap.DeepCopyInto(&(dest.remap));
+        sk->group.Add(&dest);
+    }
+    for(i = 0; i < SK.groupOrder.n; i++) {
+        sk->groupOrder.Add(&(SK.groupOrder.elem[i]));
+    }
+
+    enum { COPIED_LOOPS = 1, COPIED_THIS = 2, COPIED_RUNNING = 4 };
+    for(hGroup hg : groups) {
+        Group *g = SK.GetGroup(hg);
+        if(g->type == Group::Type::EXTRUDE || g->type == Group::Type::LATHE) {
+            Group *src = SK.GetGroup(g->opA), *dest = sk->GetGroup(g->opA);
+            if(!(dest->tag & COPIED_LOOPS)) {
+                dest->bezierLoops.MakeFromCopyOf(&(src->bezierLoops));
+                dest->tag |= COPIED_LOOPS;
+            }
+        }
+
+        // What a step and repeat repeats, and what we're combined with.
+        Group *srcg = g;
+        if(g->type == Group::Type::TRANSLATE || g->type == Group::Type::ROTATE) {
+            srcg = SK.GetGroup(g->opA);
+            Group *dest = sk->GetGroup(srcg->h);
+            if(!srcg->shellDirty && !(dest->tag & COPIED_THIS)) {
+                dest->thisShell.MakeFromCopyOf(&(srcg->thisShell));
+                dest->thisMesh.MakeFromCopyOf(&(srcg->thisMesh));
+                dest->tag |= COPIED_THIS;
+            }
+        }
+        Group *prevg = srcg->RunningMeshGroup();
+        if(prevg && !prevg->shellDirty) {
+            Group *dest = sk->GetGroup(prevg->h);
+            if(!(dest->tag & COPIED_RUNNING)) {
+                dest->runningShell.MakeFromCopyOf(&(prevg->runningShell));
+                dest->runningMesh.MakeFromCopyOf(&(prevg->runningMesh));
+                for(PartInstance &pi : prevg->runningInstances) {
+                    dest->runningInstances.Add(&pi);
+                }
+                dest->tag |= COPIED_RUNNING;
+            }
+        }
+    }
+
+    for(i = 0; i < SK.entity.n; i++) {
+        Entity e = SK.entity.elem[i];
+        e.beziers = {};
+        e.edges = {};
+        sk->entity.Add(&e);
+    }
+    for(i = 0; i < SK.param.n; i++) {
+        sk->param.Add(&(SK.param.elem[i]));
+    }
+
+    // That thread allocates from the temporary heap too; which is fine, since
+    // that's only freed in GenerateAll() and below, once the thread is done.
+    regeneration = r;
+    r->thread = std::thread([r] { r->Run(); });
+}
+
+void SolveSpaceUI::CancelRegeneration() {
+    if(!regeneration) return;
+
+    regeneration->cancelled = true;
+    FinishRegeneration(/*wait=*/true);
+}
+
+void SolveSpaceUI::FinishRegeneration(bool wait) {
+    Regeneration *r = regeneration;
+    if(!r) return;
+    if(!wait && !r->finished) return;
+
+    r->thread.join();
+    regeneration = NULL;
+
+    if(!r->cancelled) {
+        for(hGroup hg : r->groups) {
+            Group *g = SK.group.FindByIdNoOops(hg);
+            if(!g || !g->shellDirty) continue;
+
+            Group *rg = r->sketch.GetGroup(hg);
+            swap(g->thisShell, rg->thisShell);
+            swap(g->thisMesh, rg->thisMesh);
+            swap(g->runningShell, rg->runningShell);
+            swap(g->runningMesh, rg->runningMesh);
+            swap(g->runningInstances, rg->runningInstances);
+            // The faces might have needed some new entity handles.
+            if(rg->remap.n > g->remap.n) {
+                swap(g->remap, rg->remap);
+                memcpy(g->remapCache, rg->remapCache, sizeof(g->remapCache));
+            }
+
+            if(g->booleanFailed != rg->booleanFailed ||
+               g->meshCutFailed != rg->meshCutFailed) {
+                g->booleanFailed = rg->booleanFailed;
+                g->meshCutFailed = rg->meshCutFailed;
+                ScheduleShowTW();
+            }
+            g->shellDirty = false;
+            g->displayDirty = true;
+        }
+
+        for(SEdge &se : r->nakedEdges.l) {
+            nakedEdges.l.Add(&se);
+        }
+        profiler.AddFrom(r->profiler);
+        InvalidateGraphics();
+    }
+
+    // What we've replaced goes with the rest of that copy of the sketch, and
+    // anything that thread allocated from the temporary heap is garbage too.
+    r->Clear();
+    delete r;
+    FreeAllTemporary();
+}
+
 void SolveSpaceUI::ForceReferences() {
     // Force the values of the parameters that define the three reference
     // coordinate systems.
@@ -454,6 +782,7 @@ void SolveSpaceUI::MarkDraggedParams() {
 }
 
 void SolveSpaceUI::SolveGroup(hGroup hg, bool andFindFree) {
+    Profiler::Scope scope(hg, Profiler::Phase::SOLVE);
     int i;
     // Clear out the system to be solved.
     sys.entity.Clear();
@@ -114,29 +114,39 @@ void ssglPoint(Vector p, double pixelSize)
     }
 }
 
-void ssglStippledLine(Vector a, Vector b, double width,
-                      StipplePattern stippleType, double stippleScale, bool maybeFat)
-{
-    const char *stipplePattern;
+static const char *StipplePatternString(StipplePattern stippleType) {
     switch(stippleType) {
-        case StipplePattern::CONTINUOUS:    ssglLine(a, b, width, maybeFat); return;
-        case StipplePattern::SHORT_DASH:    stipplePattern = "-  "; break;
-        case StipplePattern::DASH:          stipplePattern = "- ";  break;
-        case StipplePattern::LONG_DASH:     stipplePattern = "_ ";  break;
-        case StipplePattern::DASH_DOT:      stipplePattern = "-.";  break;
-        case StipplePattern::DASH_DOT_DOT:  stipplePattern = "-.."; break;
-        case StipplePattern::DOT:           stipplePattern = ".";   break;
-        case StipplePattern::FREEHAND:      stipplePattern = "~";   break;
-        case StipplePattern::ZIGZAG:        stipplePattern = "~__"; break;
+        case StipplePattern::CONTINUOUS:    return NULL;
+        case StipplePattern::SHORT_DASH:    return "-  ";
+        case StipplePattern::DASH:          return "- ";
+        case StipplePattern::LONG_DASH:     return "_ ";
+        case StipplePattern::DASH_DOT:      return "-.";
+        case StipplePattern::DASH_DOT_DOT:  return "-..";
+        case StipplePattern::DOT:           return ".";
+        case StipplePattern::FREEHAND:      return "~";
+        case StipplePattern::ZIGZAG:        return "~__";
     }
-    ssglStippledLine(a, b, width, stipplePattern, stippleScale, maybeFat);
+    ssassert(false, "Unexpected stipple pattern");
 }
 
-void ssglStippledLine(Vector a, Vector b, double width,
-                      const char *stipplePattern, double stippleScale, bool maybeFat)
+// Break a line into the pieces of a stipple pattern. These are drawn, unless
+// fn is given; then they're passed to fn instead, which works only for the
+// patterns that are made of dashes, since dots and freehand strokes are built
+// to face the viewer.
+static void StippledLine(Vector a, Vector b, double width,
+                         const char *stipplePattern, double stippleScale, bool maybeFat,
+                         ssglLineFn *fn, void *fndata)
 {
     ssassert(stipplePattern != NULL, "Unexpected stipple pattern");
 
+    auto line = [&](Vector p, Vector q) {
+        if(fn) {
+            fn(fndata, p, q);
+        } else {
+            ssglLine(p, q, width, maybeFat);
+        }
+    };
+
     Vector dir = b.Minus(a);
     double len = dir.Magnitude();
     dir = dir.WithMagnitude(1.0);
@@ -155,16 +165,17 @@ void ssglStippledLine(Vector a, Vector b, double width,
                 start = max(start - 0.5 * ss, 0.0);
                 end = max(start - 2.0 * ss, 0.0);
                 if(start == end) break;
-                ssglLine(a.Plus(dir.ScaledBy(start)), a.Plus(dir.ScaledBy(end)), width, maybeFat);
+                line(a.Plus(dir.ScaledBy(start)), a.Plus(dir.ScaledBy(end)));
                 end = max(end - 0.5 * ss, 0.0);
                 break;
 
             case '_':
                 end = max(end - 4.0 * ss, 0.0);
-                ssglLine(a.Plus(dir.ScaledBy(start)), a.Plus(dir.ScaledBy(end)), width, maybeFat);
+                line(a.Plus(dir.ScaledBy(start)), a.Plus(dir.ScaledBy(end)));
                 break;
 
             case '.':
+                ssassert(fn == NULL, "Dots depend on the view");
                 end = max(end - 0.5 * ss, 0.0);
                 if(end == 0.0) break;
                 ssglPoint(a.Plus(dir.ScaledBy(end)), width);
@@ -172,6 +183,7 @@ void ssglStippledLine(Vector a, Vector b, double width,
                 break;
 
             case '~': {
+                ssassert(fn == NULL, "Freehand strokes depend on the view");
                 Vector ab  = b.Minus(a);
                 Vector gn = (SS.GW.projRight).Cross(SS.GW.projUp);
                 Vector abn = (ab.Cross(gn)).WithMagnitude(1);
@@ -182,7 +194,7 @@ void ssglStippledLine(Vector a, Vector b, double width,
                 Vector aa = a.Plus(dir.ScaledBy(start));
                 Vector bb = a.Plus(dir.ScaledBy(end))
                              .Plus(abn.ScaledBy(pws * (start - end) / (0.5 * ss)));
-                ssglLine(aa, bb, width, maybeFat);
+                line(aa, bb);
                 if(end == 0.0) break;
 
                 start = end;
@@ -190,7 +202,7 @@ void ssglStippledLine(Vector a, Vector b, double width,
                 aa = a.Plus(dir.ScaledBy(end))
                       .Plus(abn.ScaledBy(pws))
                       .Minus(abn.ScaledBy(2.0 * pws * (start - end) / ss));
-                ssglLine(bb, aa, width, maybeFat);
+                line(bb, aa);
                 if(end == 0.0) break;
 
                 start = end;
@@ -198,7 +210,7 @@ void ssglStippledLine(Vector a, Vector b, double width,
                 bb = a.Plus(dir.ScaledBy(end))
                       .Minus(abn.ScaledBy(pws))
                       .Plus(abn.ScaledBy(pws * (start - end) / (0.5 * ss)));
-                ssglLine(aa, bb, width, maybeFat);
+                line(aa, bb);
                 break;
             }
 
@@ -208,6 +220,39 @@ void ssglStippledLine(Vector a, Vector b, double width,
     } while(end > 0.0);
 }
 
+void ssglStippledLine(Vector a, Vector b, double width,
+                      StipplePattern stippleType, double stippleScale, bool maybeFat)
+{
+    if(stippleType == StipplePattern::CONTINUOUS) {
+        ssglLine(a, b, width, maybeFat);
+        return;
+    }
+    StippledLine(a, b, width, StipplePatternString(stippleType), stippleScale, maybeFat,
+                 NULL, NULL);
+}
+
+void ssglStippledLine(Vector a, Vector b, double width,
+                      const char *stipplePattern, double stippleScale, bool maybeFat)
+{
+    StippledLine(a, b, width, stipplePattern, stippleScale, maybeFat, NULL, NULL);
+}
+
+bool ssglStippleIsViewIndependent(StipplePattern stippleType) {
+    const char *stipplePattern = StipplePatternString(stippleType);
+    return stipplePattern == NULL || strpbrk(stipplePattern, ".~") == NULL;
+}
+
+void ssglStippledLine(Vector a, Vector b, StipplePattern stippleType, double stippleScale,
+                      ssglLineFn *fn, void *fndata)
+{
+    if(stippleType == StipplePattern::CONTINUOUS) {
+        fn(fndata, a, b);
+        return;
+    }
+    StippledLine(a, b, /*width=*/0, StipplePatternString(stippleType), stippleScale,
+                 /*maybeFat=*/false, fn, fndata);
+}
+
 void ssglFatLine(Vector a, Vector b, double width)
 {
     if(a.EqualsExactly(b)) return;
@@ -292,79 +337,63 @@ static void Stipple(bool forSelection)
     }
 }
 
-static void StippleTriangle(STriangle *tr, bool forSelection, RgbaColor rgb)
-{
-    glEnd();
-    glDisable(GL_LIGHTING);
-    ssglColorRGB(rgb);
-    Stipple(forSelection);
-    glBegin(GL_TRIANGLES);
-        ssglVertex3v(tr->a);
-        ssglVertex3v(tr->b);
-        ssglVertex3v(tr->c);
-    glEnd();
-    glEnable(GL_LIGHTING);
-    glDisable(GL_POLYGON_STIPPLE);
-    glBegin(GL_TRIANGLES);
-}
-
 void ssglFillMesh(bool useSpecColor, RgbaColor specColor,
-                  SMesh *m, uint32_t h, uint32_t s1, uint32_t s2)
+                  SMesh *m, SMeshBuffers *mb, uint32_t h, uint32_t s1, uint32_t s2)
 {
+    // The buffers are built along with the display items, but a mesh that's
+    // been changed or swapped in since then would need them built again.
+    if(mb->index.n != m->l.n * 3) mb->Build(m);
+    if(m->l.n == 0) return;
+
     RgbaColor rgbHovered  = Style::Color(Style::HOVERED),
              rgbSelected = Style::Color(Style::SELECTED);
 
     glEnable(GL_NORMALIZE);
-    bool hasMaterial = false;
-    RgbaColor prevColor;
-    glBegin(GL_TRIANGLES);
-    for(int i = 0; i < m->l.n; i++) {
-        STriangle *tr = &(m->l.elem[i]);
+    glInterleavedArrays(GL_N3F_V3F, 0, mb->vertex.elem);
+    for(int i = 0; i < mb->run.n; i++) {
+        SMeshBuffers::Run *r = &(mb->run.elem[i]);
+        // With a single color, there's no reason to draw in runs.
+        int count = useSpecColor ? mb->index.n : r->count;
+
+        RgbaColor color = useSpecColor ? specColor : r->color;
+        GLfloat mpf[] = { color.redF(), color.greenF(), color.blueF(), color.alphaF() };
+        glMaterialfv(GL_FRONT, GL_AMBIENT_AND_DIFFUSE, mpf);
+        glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_INT, &(mb->index.elem[r->first]));
+
+        if(useSpecColor) break;
+    }
 
-        RgbaColor color;
-        if(useSpecColor) {
-            color = specColor;
-        } else {
-            color = tr->meta.color;
-        }
-        if(!hasMaterial || !color.Equals(prevColor)) {
-            GLfloat mpf[] = { color.redF(), color.greenF(), color.blueF(), color.alphaF() };
-            glEnd();
-            glMaterialfv(GL_FRONT, GL_AMBIENT_AND_DIFFUSE, mpf);
-            prevColor = color;
-            hasMaterial = true;
-            glBegin(GL_TRIANGLES);
+    // And the selected and hovered faces are stippled on top of that, which
+    // is just a few triangles, drawn from the same vertices.
+    std::vector<GLuint> selected, hovered;
+    for(int i = 0; i < m->l.n; i++) {
+        uint32_t face = m->l.elem[i].meta.face;
+        uint32_t *tri = &(mb->index.elem[i*3]);
+        if((s1 != 0 && face == s1) || (s2 != 0 && face == s2)) {
+            selected.insert(selected.end(), tri, tri + 3);
         }
-
-        if(tr->an.EqualsExactly(Vector::From(0, 0, 0))) {
-            // Compute the normal from the vertices
-            Vector n = tr->Normal();
-            glNormal3d(n.x, n.y, n.z);
-            ssglVertex3v(tr->a);
-            ssglVertex3v(tr->b);
-            ssglVertex3v(tr->c);
-        } else {
-            // Use the exact normals that are specified
-            glNormal3d((tr->an).x, (tr->an).y, (tr->an).z);
-            ssglVertex3v(tr->a);
-
-            glNormal3d((tr->bn).x, (tr->bn).y, (tr->bn).z);
-            ssglVertex3v(tr->b);
-
-            glNormal3d((tr->cn).x, (tr->cn).y, (tr->cn).z);
-            ssglVertex3v(tr->c);
+        if(h != 0 && face == h) {
+            hovered.insert(hovered.end(), tri, tri + 3);
         }
-
-        if((s1 != 0 && tr->meta.face == s1) ||
-           (s2 != 0 && tr->meta.face == s2))
-        {
-            StippleTriangle(tr, /*forSelection=*/true, rgbSelected);
+    }
+    if(!selected.empty() || !hovered.empty()) {
+        glDisable(GL_LIGHTING);
+        if(!selected.empty()) {
+            ssglColorRGB(rgbSelected);
+            Stipple(/*forSelection=*/true);
+            glDrawElements(GL_TRIANGLES, (GLsizei)selected.size(), GL_UNSIGNED_INT, &selected[0]);
         }
-        if(h != 0 && tr->meta.face == h) {
-            StippleTriangle(tr, /*forSelection=*/false, rgbHovered);
+        if(!hovered.empty()) {
+            ssglColorRGB(rgbHovered);
+            Stipple(/*forSelection=*/false);
+            glDrawElements(GL_TRIANGLES, (GLsizei)hovered.size(), GL_UNSIGNED_INT, &hovered[0]);
         }
+        glDisable(GL_POLYGON_STIPPLE);
+        glEnable(GL_LIGHTING);
     }
-    glEnd();
+
+    glDisableClientState(GL_NORMAL_ARRAY);
+    glDisableClientState(GL_VERTEX_ARRAY);
 }
 
 static void SSGL_CALLBACK Vertex(Vector *p)
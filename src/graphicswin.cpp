@@ -232,6 +232,7 @@ void GraphicsWindow::Init() {
     ShowTextWindow(showTextWindow);
 
     showSnapGrid = false;
+    batchDepth = 0;
     context.active = false;
 
     // Do this last, so that all the menus get updated correctly.
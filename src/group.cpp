@@ -27,12 +27,17 @@ void Group::Clear() {
     runningMesh.Clear();
     thisShell.Clear();
     runningShell.Clear();
+    runningInstances.Clear();
     displayMesh.Clear();
+    displayBuffers.Clear();
+    displayBvh.Clear();
     displayEdges.Clear();
     displayOutlines.Clear();
-    impMesh.Clear();
-    impShell.Clear();
-    impEntity.Clear();
+    displayEntities.Clear();
+    displayHiddenEntities.Clear();
+    impMesh = NULL;
+    impShell = NULL;
+    impEntity = NULL;
     // remap is the only one that doesn't get recreated when we regen
     remap.Clear();
 }
@@ -542,8 +547,9 @@ void Group::Generate(IdList<Entity,hEntity> *entity,
             AddParam(param, h.param(5), 0);
             AddParam(param, h.param(6), 0);
 
-            for(i = 0; i < impEntity.n; i++) {
-                Entity *ie = &(impEntity.elem[i]);
+            if(!impEntity) return;
+            for(i = 0; i < impEntity->n; i++) {
+                Entity *ie = &(impEntity->elem[i]);
                 CopyEntity(entity, ie, 0, 0,
                     h.param(0), h.param(1), h.param(2),
                     h.param(3), h.param(4), h.param(5), h.param(6),
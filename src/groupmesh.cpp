@@ -54,6 +54,7 @@ void Group::AssembleLoops(bool *allClosed,
 }
 
 void Group::GenerateLoops() {
+    Profiler::Scope scope(h, Profiler::Phase::LOOPS);
     polyLoops.Clear();
     bezierLoops.Clear();
     bezierOpens.Clear();
@@ -104,6 +105,35 @@ void SMesh::RemapFaces(Group *g, int remap) {
     }
 }
 
+// Shells are always combined the same way; meshes may be combined by cutting
+// them where they intersect instead of with a BSP, if the group asks for it.
+static void MakeBooleanInto(SShell *outs, SShell *a, SShell *b, Group::CombineAs how,
+                            bool cutMeshes, bool *cutFailed) {
+    if(how == Group::CombineAs::UNION) {
+        outs->MakeFromUnionOf(a, b);
+    } else if(how == Group::CombineAs::DIFFERENCE) {
+        outs->MakeFromDifferenceOf(a, b);
+    } else {
+        outs->MakeFromAssemblyOf(a, b);
+    }
+}
+
+static void MakeBooleanInto(SMesh *outs, SMesh *a, SMesh *b, Group::CombineAs how,
+                            bool cutMeshes, bool *cutFailed) {
+    if(cutMeshes && how != Group::CombineAs::ASSEMBLE) {
+        if(outs->MakeFromCutBooleanOf(a, b, how == Group::CombineAs::DIFFERENCE)) return;
+        *cutFailed = true;
+    }
+
+    if(how == Group::CombineAs::UNION) {
+        outs->MakeFromUnionOf(a, b);
+    } else if(how == Group::CombineAs::DIFFERENCE) {
+        outs->MakeFromDifferenceOf(a, b);
+    } else {
+        outs->MakeFromAssemblyOf(a, b);
+    }
+}
+
 template<class T>
 void Group::GenerateForStepAndRepeat(T *steps, T *outs) {
     T workA, workB;
@@ -117,6 +147,9 @@ void Group::GenerateForStepAndRepeat(T *steps, T *outs) {
     }
     int a;
     for(a = a0; a < n; a++) {
+        // Every step is another Boolean, so check in between.
+        if(RegenerationCancelled()) break;
+
         int ap = a*2 - (subtype == Subtype::ONE_SIDED ? 0 : (n-1));
         int remap = (a == (n - 1)) ? REMAP_LAST : a;
 
@@ -144,7 +177,9 @@ void Group::GenerateForStepAndRepeat(T *steps, T *outs) {
         if(soFar->IsEmpty()) {
             scratch->MakeFromCopyOf(&transd);
         } else {
-            scratch->MakeFromUnionOf(soFar, &transd);
+            Profiler::Scope scope(h, Profiler::Phase::BOOLEAN);
+            MakeBooleanInto(scratch, soFar, &transd, CombineAs::UNION, cutMeshes,
+                            &meshCutFailed);
         }
 
         swap(scratch, soFar);
@@ -166,20 +201,245 @@ void Group::GenerateForBoolean(T *prevs, T *thiss, T *outs, Group::CombineAs how
         return;
     }
 
+    Profiler::Scope scope(h, Profiler::Phase::BOOLEAN);
+
     // So our group's shell appears in thisShell. Combine this with the
     // previous group's shell, using the requested operation.
-    if(how == CombineAs::UNION) {
-        outs->MakeFromUnionOf(prevs, thiss);
-    } else if(how == CombineAs::DIFFERENCE) {
-        outs->MakeFromDifferenceOf(prevs, thiss);
-    } else {
-        outs->MakeFromAssemblyOf(prevs, thiss);
+    MakeBooleanInto(outs, prevs, thiss, how, cutMeshes, &meshCutFailed);
+}
+
+//-----------------------------------------------------------------------------
+// A linked part that's only assembled with the rest of the model doesn't
+// need a copy of its shell; we hold it as an instance of what we read from
+// its file instead. A part that's a mesh is still copied.
+//-----------------------------------------------------------------------------
+bool Group::IsLinkedInstance() {
+    if(type != Type::LINKED) return false;
+    if(meshCombine != CombineAs::ASSEMBLE || forceToMesh) return false;
+    if(impMesh && !impMesh->IsEmpty()) return false;
+    return impShell && !impShell->IsEmpty();
+}
+
+PartInstance Group::LinkedInstance() {
+    PartInstance pi = {};
+    pi.group = h;
+    pi.shell = impShell;
+    pi.offset = {
+        SK.GetParam(h.param(0))->val,
+        SK.GetParam(h.param(1))->val,
+        SK.GetParam(h.param(2))->val };
+    pi.q = {
+        SK.GetParam(h.param(3))->val,
+        SK.GetParam(h.param(4))->val,
+        SK.GetParam(h.param(5))->val,
+        SK.GetParam(h.param(6))->val };
+    pi.scale = scale;
+    return pi;
+}
+
+static void AssembleInstanceInto(SShell *sh, PartInstance *pi) {
+    int first = sh->surface.n;
+    sh->AddTransformedCopyOf(pi->shell, pi->offset, pi->q, pi->scale);
+
+    // The new surfaces have the largest handles, so they're all at the end.
+    Group *g = SK.GetGroup(pi->group);
+    for(int i = first; i < sh->surface.n; i++) {
+        SSurface *ss = &(sh->surface.elem[i]);
+        hEntity face = { ss->face };
+        if(face.v == Entity::NO_ENTITY.v) continue;
+        ss->face = g->Remap(face, 0).v;
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Our whole running shell, including the linked parts that we hold as
+// instances. If there are any, then that's assembled into the given shell,
+// which the caller must free; otherwise it's just runningShell.
+//-----------------------------------------------------------------------------
+SShell *Group::GetRunningShell(SShell *assembled) {
+    if(runningInstances.n == 0) return &runningShell;
+
+    assembled->AddTransformedCopyOf(&runningShell,
+        Vector::From(0, 0, 0), Quaternion::IDENTITY, 1.0);
+    for(PartInstance &pi : runningInstances) {
+        AssembleInstanceInto(assembled, &pi);
     }
+    return assembled;
+}
+
+//-----------------------------------------------------------------------------
+// Triangulate linked parts that we hold as instances. Each part's shell is
+// triangulated just once, and those triangles are moved into place for every
+// instance of it; unless it's scaled, since then the chord tolerance would
+// be scaled too. If each isn't NULL, then every instance gets a mesh of its
+// own there, instead of them all going into sm.
+//-----------------------------------------------------------------------------
+static void TriangulateInstancesInto(PartInstance *pis, int n, SMesh *sm,
+                                     SMesh *each = NULL) {
+    std::map<SShell *, SMesh> parts;
+    for(int i = 0; i < n; i++) {
+        PartInstance *pi = &pis[i];
+        Group *g = SK.GetGroup(pi->group);
+        if(each) sm = &each[i];
+        if(!EXACT(fabs(pi->scale) == 1.0)) {
+            SShell sh = {};
+            AssembleInstanceInto(&sh, pi);
+            sh.TriangulateInto(sm);
+            sh.Clear();
+            continue;
+        }
+
+        auto it = parts.find(pi->shell);
+        if(it == parts.end()) {
+            SMesh m = {};
+            pi->shell->TriangulateInto(&m);
+            it = parts.emplace(pi->shell, m).first;
+        }
+
+        // A scale of -1 turns the part inside out, so flip the triangles
+        // back, as SSurface::FromTransformationOf does for the surfaces.
+        bool mirror = (pi->scale < 0);
+        for(const STriangle &tr : it->second.l) {
+            STriangle t = tr;
+            if(mirror) {
+                swap(t.b, t.c);
+                swap(t.bn, t.cn);
+            }
+            t.a  = (pi->q.Rotate(t.a.ScaledBy(pi->scale))).Plus(pi->offset);
+            t.b  = (pi->q.Rotate(t.b.ScaledBy(pi->scale))).Plus(pi->offset);
+            t.c  = (pi->q.Rotate(t.c.ScaledBy(pi->scale))).Plus(pi->offset);
+            t.an = pi->q.Rotate(t.an.ScaledBy(pi->scale));
+            t.bn = pi->q.Rotate(t.bn.ScaledBy(pi->scale));
+            t.cn = pi->q.Rotate(t.cn.ScaledBy(pi->scale));
+
+            hEntity face = { t.meta.face };
+            if(face.v != Entity::NO_ENTITY.v) {
+                t.meta.face = g->Remap(face, 0).v;
+            }
+            sm->AddTriangle(&t);
+        }
+    }
+
+    for(auto &it : parts) {
+        it.second.Clear();
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Split our running model into the solids that it's made of, to check those
+// against each other for interference. Each linked part that we hold as an
+// instance is one. The rest of the shell falls apart into the pieces whose
+// surfaces are joined by curves, since two solids that just touch each have
+// curves of their own. A mesh has no curves, so its triangles are joined
+// wherever they share a vertex instead. Each body is named for the group
+// that its first face came from.
+//-----------------------------------------------------------------------------
+void Group::MakeSolidBodiesInto(std::vector<SolidBody> *bodies) {
+    std::vector<hGroup> groups;
+    std::vector<bool> haveGroup;
+    auto addBody = [&](hGroup hg, bool known) {
+        bodies->push_back({});
+        groups.push_back(hg);
+        haveGroup.push_back(known);
+        return bodies->size() - 1;
+    };
+    auto nameFrom = [&](size_t b, uint32_t face) {
+        if(haveGroup[b] || face == Entity::NO_ENTITY.v) return;
+        hEntity he = { face };
+        groups[b] = he.group();
+        haveGroup[b] = true;
+    };
+
+    std::vector<SMesh> instanceMeshes(runningInstances.n);
+    TriangulateInstancesInto(runningInstances.elem, runningInstances.n, NULL,
+                             instanceMeshes.data());
+    for(int i = 0; i < runningInstances.n; i++) {
+        size_t b = addBody(runningInstances.elem[i].group, /*known=*/true);
+        (*bodies)[b].mesh = instanceMeshes[i];
+    }
+
+    std::vector<int> parent;
+    auto findRoot = [&](int i) {
+        while(parent[i] != i) {
+            parent[i] = parent[parent[i]];
+            i = parent[i];
+        }
+        return i;
+    };
+    std::map<int, size_t> bodyForRoot;
+    auto bodyFor = [&](int root) {
+        auto it = bodyForRoot.find(root);
+        if(it == bodyForRoot.end()) {
+            it = bodyForRoot.emplace(root, addBody(h, /*known=*/false)).first;
+        }
+        return it->second;
+    };
+
+    SShell *sh = &runningShell;
+    parent.resize(sh->surface.n);
+    for(int i = 0; i < sh->surface.n; i++) parent[i] = i;
+    for(const SCurve &sc : sh->curve) {
+        int ia = sh->surface.IndexOf(sc.surfA),
+            ib = sh->surface.IndexOf(sc.surfB);
+        if(ia < 0 || ib < 0) continue;
+        parent[findRoot(ib)] = findRoot(ia);
+    }
+    std::vector<SMesh> surfaceMeshes(sh->surface.n);
+    ParallelFor(sh->surface.n, [&](int i) {
+        sh->surface.elem[i].TriangulateInto(sh, &surfaceMeshes[i]);
+    });
+    for(int i = 0; i < sh->surface.n; i++) {
+        size_t b = bodyFor(findRoot(i));
+        nameFrom(b, sh->surface.elem[i].face);
+        (*bodies)[b].mesh.MakeFromCopyOf(&surfaceMeshes[i]);
+        surfaceMeshes[i].Clear();
+    }
+
+    SPointHash sph = {};
+    SMesh *m = &runningMesh;
+    std::vector<int> vertex(3*m->l.n);
+    parent.clear();
+    bodyForRoot.clear();
+    for(int i = 0; i < m->l.n; i++) {
+        STriangle *tr = &(m->l.elem[i]);
+        Vector v[3] = { tr->a, tr->b, tr->c };
+        for(int k = 0; k < 3; k++) {
+            vertex[3*i + k] = sph.IndexForPointOrAdd(v[k]);
+            if(vertex[3*i + k] == (int)parent.size()) {
+                parent.push_back(vertex[3*i + k]);
+            }
+        }
+        parent[findRoot(vertex[3*i + 1])] = findRoot(vertex[3*i]);
+        parent[findRoot(vertex[3*i + 2])] = findRoot(vertex[3*i]);
+    }
+    for(int i = 0; i < m->l.n; i++) {
+        STriangle *tr = &(m->l.elem[i]);
+        size_t b = bodyFor(findRoot(vertex[3*i]));
+        nameFrom(b, tr->meta.face);
+        (*bodies)[b].mesh.AddTriangle(tr);
+    }
+    sph.Clear();
+
+    std::map<std::string, int> named;
+    size_t kept = 0;
+    for(size_t i = 0; i < bodies->size(); i++) {
+        SolidBody body = (*bodies)[i];
+        if(body.mesh.IsEmpty()) continue;
+        body.mesh.GetBounding(&body.maxp, &body.minp);
+
+        Group *g = SK.group.FindByIdNoOops(groups[i]);
+        body.name = (g ? g : this)->DescriptionString();
+        int n = ++named[body.name];
+        if(n > 1) body.name += ssprintf(" #%d", n);
+        (*bodies)[kept++] = body;
+    }
+    bodies->resize(kept);
 }
 
 void Group::GenerateShellAndMesh() {
-    bool prevBooleanFailed = booleanFailed;
+    Profiler::Scope scope(h, Profiler::Phase::SHELL);
     booleanFailed = false;
+    meshCutFailed = false;
 
     Group *srcg = this;
 
@@ -187,6 +447,7 @@ void Group::GenerateShellAndMesh() {
     thisMesh.Clear();
     runningShell.Clear();
     runningMesh.Clear();
+    runningInstances.Clear();
 
     // Don't attempt a lathe or extrusion unless the source section is good:
     // planar and not self-intersecting.
@@ -203,8 +464,17 @@ void Group::GenerateShellAndMesh() {
         // not our own previous group.
         srcg = SK.GetGroup(opA);
 
-        GenerateForStepAndRepeat<SShell>(&(srcg->thisShell), &thisShell);
+        // If we're repeating a linked part that was held by reference,
+        // then we need a copy of it to repeat.
+        SShell srcShell = {};
+        if(srcg->IsLinkedInstance()) {
+            PartInstance pi = srcg->LinkedInstance();
+            AssembleInstanceInto(&srcShell, &pi);
+        }
+        GenerateForStepAndRepeat<SShell>(srcShell.IsEmpty() ? &(srcg->thisShell) : &srcShell,
+                                         &thisShell);
         GenerateForStepAndRepeat<SMesh> (&(srcg->thisMesh),  &thisMesh);
+        srcShell.Clear();
     } else if(type == Type::EXTRUDE && haveSrc) {
         Group *src = SK.GetGroup(opA);
         Vector translate = Vector::From(h.param(0), h.param(1), h.param(2));
@@ -216,6 +486,25 @@ void Group::GenerateShellAndMesh() {
             tbot = translate.ScaledBy(-1); ttop = translate.ScaledBy(1);
         }
 
+        // The side faces are annotated with the line segments that they were
+        // extruded from, found by their endpoints; so when we first need one,
+        // hash the segments of the source group by their endpoints, moved to
+        // the top. Where several segments match, the first one wins, as it
+        // would in a search through the entities.
+        SPointHash segmentEnds = {};
+        std::unordered_map<uint64_t, int> segmentByEnds;
+        bool haveSegments = false;
+        auto segmentKey = [](int ia, int ib) {
+            return ((uint64_t)min(ia, ib) << 32) | (uint64_t)max(ia, ib);
+        };
+        auto findSegment = [&](Vector a, Vector b) -> int {
+            int ia = segmentEnds.IndexForPoint(a),
+                ib = segmentEnds.IndexForPoint(b);
+            if(ia < 0 || ib < 0) return INT_MAX;
+            auto it = segmentByEnds.find(segmentKey(ia, ib));
+            return (it == segmentByEnds.end()) ? INT_MAX : it->second;
+        };
+
         SBezierLoopSetSet *sblss = &(src->bezierLoops);
         SBezierLoopSet *sbls;
         for(sbls = sblss->l.First(); sbls; sbls = sblss->l.NextAfter(sbls)) {
@@ -251,25 +540,27 @@ void Group::GenerateShellAndMesh() {
                 // So these are the sides
                 if(ss->degm != 1 || ss->degn != 1) continue;
 
-                Entity *e;
-                for(e = SK.entity.First(); e; e = SK.entity.NextAfter(e)) {
-                    if(e->group.v != opA.v) continue;
-                    if(e->type != Entity::Type::LINE_SEGMENT) continue;
-
-                    Vector a = SK.GetEntity(e->point[0])->PointGetNum(),
-                           b = SK.GetEntity(e->point[1])->PointGetNum();
-                    a = a.Plus(ttop);
-                    b = b.Plus(ttop);
-                    // Could get taken backwards, so check all cases.
-                    if((a.Equals(ss->ctrl[0][0]) && b.Equals(ss->ctrl[1][0])) ||
-                       (b.Equals(ss->ctrl[0][0]) && a.Equals(ss->ctrl[1][0])) ||
-                       (a.Equals(ss->ctrl[0][1]) && b.Equals(ss->ctrl[1][1])) ||
-                       (b.Equals(ss->ctrl[0][1]) && a.Equals(ss->ctrl[1][1])))
-                    {
-                        face = Remap(e->h, REMAP_LINE_TO_FACE);
-                        ss->face = face.v;
-                        break;
+                if(!haveSegments) {
+                    for(int j = 0; j < SK.entity.n; j++) {
+                        Entity *e = &(SK.entity.elem[j]);
+                        if(e->group.v != opA.v) continue;
+                        if(e->type != Entity::Type::LINE_SEGMENT) continue;
+
+                        Vector a = SK.GetEntity(e->point[0])->PointGetNum(),
+                               b = SK.GetEntity(e->point[1])->PointGetNum();
+                        int ia = segmentEnds.IndexForPointOrAdd(a.Plus(ttop)),
+                            ib = segmentEnds.IndexForPointOrAdd(b.Plus(ttop));
+                        // Could get taken backwards, so the key doesn't care.
+                        segmentByEnds.emplace(segmentKey(ia, ib), j);
                     }
+                    haveSegments = true;
+                }
+
+                int j = min(findSegment(ss->ctrl[0][0], ss->ctrl[1][0]),
+                            findSegment(ss->ctrl[0][1], ss->ctrl[1][1]));
+                if(j != INT_MAX) {
+                    face = Remap(SK.entity.elem[j].h, REMAP_LINE_TO_FACE);
+                    ss->face = face.v;
                 }
             }
         }
@@ -285,24 +576,20 @@ void Group::GenerateShellAndMesh() {
         for(sbls = sblss->l.First(); sbls; sbls = sblss->l.NextAfter(sbls)) {
             thisShell.MakeFromRevolutionOf(sbls, pt, axis, color, this);
         }
-    } else if(type == Type::LINKED) {
+    } else if(type == Type::LINKED && !IsLinkedInstance()) {
         // The imported shell or mesh are copied over, with the appropriate
         // transformation applied. We also must remap the face entities.
-        Vector offset = {
-            SK.GetParam(h.param(0))->val,
-            SK.GetParam(h.param(1))->val,
-            SK.GetParam(h.param(2))->val };
-        Quaternion q = {
-            SK.GetParam(h.param(3))->val,
-            SK.GetParam(h.param(4))->val,
-            SK.GetParam(h.param(5))->val,
-            SK.GetParam(h.param(6))->val };
+        PartInstance pi = LinkedInstance();
 
-        thisMesh.MakeFromTransformationOf(&impMesh, offset, q, scale);
-        thisMesh.RemapFaces(this, 0);
+        if(impMesh) {
+            thisMesh.MakeFromTransformationOf(impMesh, pi.offset, pi.q, scale);
+            thisMesh.RemapFaces(this, 0);
+        }
 
-        thisShell.MakeFromTransformationOf(&impShell, offset, q, scale);
-        thisShell.RemapFaces(this, 0);
+        if(impShell) {
+            thisShell.MakeFromTransformationOf(impShell, pi.offset, pi.q, scale);
+            thisShell.RemapFaces(this, 0);
+        }
     }
 
     if(srcg->meshCombine != CombineAs::ASSEMBLE) {
@@ -317,29 +604,52 @@ void Group::GenerateShellAndMesh() {
 
     if(prevg->runningMesh.IsEmpty() && thisMesh.IsEmpty() && !forceToMesh) {
         SShell *prevs = &(prevg->runningShell);
+        SShell prevAssembled = {};
+        if(!thisShell.IsEmpty() && !suppress && srcg->meshCombine != CombineAs::ASSEMBLE) {
+            // A real Boolean needs the surfaces of any linked parts that
+            // we've been holding by reference, so that's where we copy them;
+            // which is part of the cost of that Boolean.
+            Profiler::Scope scope(h, Profiler::Phase::BOOLEAN);
+            prevs = prevg->GetRunningShell(&prevAssembled);
+        } else {
+            for(PartInstance &pi : prevg->runningInstances) {
+                runningInstances.Add(&pi);
+            }
+        }
         GenerateForBoolean<SShell>(prevs, &thisShell, &runningShell,
             srcg->meshCombine);
+        prevAssembled.Clear();
+
+        if(IsLinkedInstance() && !suppress) {
+            PartInstance pi = LinkedInstance();
+            runningInstances.Add(&pi);
+        }
 
         if(srcg->meshCombine != CombineAs::ASSEMBLE) {
             runningShell.MergeCoincidentSurfaces();
         }
 
         // If the Boolean failed, then we should note that in the text screen
-        // for this group.
+        // for this group; our caller does that, once our results are in use.
         booleanFailed = runningShell.booleanFailed;
-        if(booleanFailed != prevBooleanFailed) {
-            SS.ScheduleShowTW();
-        }
     } else {
         SMesh prevm, thism;
         prevm = {};
         thism = {};
 
         prevm.MakeFromCopyOf(&(prevg->runningMesh));
-        prevg->runningShell.TriangulateInto(&prevm);
-
         thism.MakeFromCopyOf(&thisMesh);
-        thisShell.TriangulateInto(&thism);
+        {
+            Profiler::Scope scope(h, Profiler::Phase::TRIANGULATE);
+            prevg->runningShell.TriangulateInto(&prevm);
+            TriangulateInstancesInto(prevg->runningInstances.elem,
+                                     prevg->runningInstances.n, &prevm);
+            thisShell.TriangulateInto(&thism);
+            if(IsLinkedInstance()) {
+                PartInstance pi = LinkedInstance();
+                TriangulateInstancesInto(&pi, 1, &thism);
+            }
+        }
 
         SMesh outm = {};
         GenerateForBoolean<SMesh>(&prevm, &thism, &outm, srcg->meshCombine);
@@ -362,8 +672,10 @@ void Group::GenerateDisplayItems() {
     // to find the emphasized edges for a mesh), so we will run it only
     // if its inputs have changed.
     if(displayDirty) {
+        Profiler::Scope scope(h, Profiler::Phase::DISPLAY);
         Group *pg = RunningMeshGroup();
-        if(pg && thisMesh.IsEmpty() && thisShell.IsEmpty()) {
+        if(pg && thisMesh.IsEmpty() && thisShell.IsEmpty() &&
+           !(IsLinkedInstance() && !suppress)) {
             // We don't contribute any new solid model in this group, so our
             // display items are identical to the previous group's; which means
             // that we can just display those, and stop ourselves from
@@ -391,7 +703,12 @@ void Group::GenerateDisplayItems() {
             // We do contribute new solid model, so we have to triangulate the
             // shell, and edge-find the mesh.
             displayMesh.Clear();
-            runningShell.TriangulateInto(&displayMesh);
+            {
+                Profiler::Scope scope(h, Profiler::Phase::TRIANGULATE);
+                runningShell.TriangulateInto(&displayMesh);
+                TriangulateInstancesInto(runningInstances.elem, runningInstances.n,
+                                         &displayMesh);
+            }
             STriangle *t;
             for(t = runningMesh.l.First(); t; t = runningMesh.l.NextAfter(t)) {
                 STriangle trn = *t;
@@ -417,6 +734,10 @@ void Group::GenerateDisplayItems() {
             }
         }
 
+        // For drawing the mesh, and for picking faces with the mouse.
+        displayBuffers.Build(&displayMesh);
+        displayBvh.Build(&displayMesh);
+
         displayDirty = false;
     }
 }
@@ -491,7 +812,7 @@ void Group::DrawDisplayItems(Group::Type t) {
         // and if we're actually going to display it, to the color buffer too.
         glEnable(GL_LIGHTING);
         if(!SS.GW.showShaded) glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
-        ssglFillMesh(useSpecColor, specColor, &displayMesh, mh, ms1, ms2);
+        ssglFillMesh(useSpecColor, specColor, &displayMesh, &displayBuffers, mh, ms1, ms2);
         if(!SS.GW.showShaded) glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
         glDisable(GL_LIGHTING);
     }
@@ -14,11 +14,63 @@ static std::string ToUpper(std::string str) {
     return str;
 }
 
-class DxfReadInterface : public DRW_Interface {
+struct DxfBlock {
+    std::vector<std::unique_ptr<DRW_Entity>> entities;
+    DRW_Block data;
+};
+
+//-----------------------------------------------------------------------------
+// The geometry that a DXF entity turns into, with the transforms of any
+// blocks it was inserted through already applied. Converting entities to
+// this doesn't touch the sketch, so it's done in parallel; the requests and
+// constraints are created from it afterwards, in file order.
+//-----------------------------------------------------------------------------
+struct DxfStyle {
+    std::string         id;
+    RgbaColor           color;
+    bool                hasWidth;
+    double              width;
+    StipplePattern      stipple;
+    double              textHeight;
+    double              textAngle;
+    Style::TextOrigin   textOrigin;
+};
+
+struct DxfGeometry {
+    enum class Type : uint32_t {
+        POINT, LINE, ARC, CIRCLE, CUBIC, COMMENT,
+        DIM_ALIGNED, DIM_LINEAR, DIM_ANGULAR, DIM_DIAMETRIC
+    };
+
+    Type        type;
+    int         style;      // index into DxfChunk::styles, or -1 for none
+    Vector      p[5];
+    double      r;
+    bool        hasActual;  // whether a dimension has a measured value
+    double      actual;
+    bool        asRadius;
+    std::string text;
+};
+
+struct DxfChunk {
+    std::vector<DxfStyle>       styles;
+    std::vector<DxfGeometry>    geometry;
+    unsigned                    unknownEntities;
+};
+
+class DxfConverter {
 public:
+    const std::map<std::string, DxfBlock>  *blocks;
+    const std::map<std::string, DRW_Layer> *layers;
+    double                                  defaultTextHeight;
+
+    DxfChunk                   *chunk;
+    std::map<std::string, int>  styleIndex;
+
     Vector blockX;
     Vector blockY;
     Vector blockT;
+    const DRW_Insert *insertInsert = NULL;
 
     void invertXTransform() {
         blockX.x = -blockX.x;
@@ -95,7 +147,15 @@ public:
         return Vector::From(radius * cos(angle), radius * sin(angle), 0.0);
     }
 
-    hRequest createBulge(Vector p0, Vector p1, double bulge) {
+    DxfGeometry *addGeometry(DxfGeometry::Type type, int style) {
+        chunk->geometry.emplace_back();
+        DxfGeometry *g = &chunk->geometry.back();
+        g->type  = type;
+        g->style = style;
+        return g;
+    }
+
+    void addBulge(Vector p0, Vector p1, double bulge, int style) {
         bool reversed = bulge < 0.0;
         double alpha = atan(bulge) * 4.0;
 
@@ -124,84 +184,64 @@ public:
         if(reversed) std::swap(p0, p1);
         blockTransformArc(&center, &p0, &p1);
 
-        hRequest hr = SS.GW.AddRequest(Request::Type::ARC_OF_CIRCLE, /*rememberForUndo=*/false);
-        SK.GetEntity(hr.entity(1))->PointForceTo(center);
-        SK.GetEntity(hr.entity(2))->PointForceTo(p0);
-        SK.GetEntity(hr.entity(3))->PointForceTo(p1);
-        processPoint(hr.entity(1));
-        processPoint(hr.entity(2));
-        processPoint(hr.entity(3));
-        return hr;
-    }
-
-    struct Block {
-        std::vector<std::unique_ptr<DRW_Entity>> entities;
-        DRW_Block data;
-    };
-
-    unsigned unknownEntities = 0;
-    std::map<std::string, hStyle> styles;
-    std::map<std::string, Block> blocks;
-    std::map<std::string, DRW_Layer> layers;
-    Block *readBlock = NULL;
-    const DRW_Insert *insertInsert = NULL;
-
-    template<class T>
-    bool addPendingBlockEntity(const T &e) {
-        if(readBlock == NULL) return false;
-        readBlock->entities.emplace_back(new T(e));
-        return true;
+        DxfGeometry *g = addGeometry(DxfGeometry::Type::ARC, style);
+        g->p[0] = center;
+        g->p[1] = p0;
+        g->p[2] = p1;
     }
 
-    void addEntity(DRW_Entity *e) {
+    void addEntity(const DRW_Entity *e) {
         switch(e->eType) {
             case DRW::POINT:
-                addPoint(*static_cast<DRW_Point *>(e));
+                addPoint(*static_cast<const DRW_Point *>(e));
                 break;
             case DRW::LINE:
-                addLine(*static_cast<DRW_Line *>(e));
+                addLine(*static_cast<const DRW_Line *>(e));
                 break;
             case DRW::ARC:
-                addArc(*static_cast<DRW_Arc *>(e));
+                addArc(*static_cast<const DRW_Arc *>(e));
                 break;
             case DRW::CIRCLE:
-                addCircle(*static_cast<DRW_Circle *>(e));
+                addCircle(*static_cast<const DRW_Circle *>(e));
                 break;
             case DRW::POLYLINE:
-                addPolyline(*static_cast<DRW_Polyline *>(e));
+                addPolyline(*static_cast<const DRW_Polyline *>(e));
                 break;
             case DRW::LWPOLYLINE:
-                addLWPolyline(*static_cast<DRW_LWPolyline *>(e));
+                addLWPolyline(*static_cast<const DRW_LWPolyline *>(e));
                 break;
             case DRW::SPLINE:
-                addSpline(static_cast<DRW_Spline *>(e));
+                addSpline(static_cast<const DRW_Spline *>(e));
                 break;
             case DRW::INSERT:
-                addInsert(*static_cast<DRW_Insert *>(e));
+                addInsert(*static_cast<const DRW_Insert *>(e));
                 break;
             case DRW::TEXT:
-                addText(*static_cast<DRW_Text *>(e));
+                addText(*static_cast<const DRW_Text *>(e));
                 break;
             case DRW::MTEXT:
-                addMText(*static_cast<DRW_MText *>(e));
+                addMText(*static_cast<const DRW_MText *>(e));
                 break;
             case DRW::DIMALIGNED:
-                addDimAlign(static_cast<DRW_DimAligned *>(e));
+                addDimAlign(static_cast<const DRW_DimAligned *>(e));
                 break;
             case DRW::DIMLINEAR:
-                addDimLinear(static_cast<DRW_DimLinear *>(e));
+                addDimLinear(static_cast<const DRW_DimLinear *>(e));
                 break;
             case DRW::DIMRADIAL:
-                addDimRadial(static_cast<DRW_DimRadial *>(e));
+                addDimRadial(static_cast<const DRW_DimRadial *>(e));
                 break;
             case DRW::DIMDIAMETRIC:
-                addDimDiametric(static_cast<DRW_DimDiametric *>(e));
+                addDimDiametric(static_cast<const DRW_DimDiametric *>(e));
                 break;
             case DRW::DIMANGULAR:
-                addDimAngular(static_cast<DRW_DimAngular *>(e));
+                addDimAngular(static_cast<const DRW_DimAngular *>(e));
+                break;
+            case DRW::DIMANGULAR3P:
+                addDimAngular3P(static_cast<const DRW_DimAngular3p *>(e));
                 break;
             default:
-                unknownEntities++;
+                chunk->unknownEntities++;
         }
     }
 
@@ -248,16 +288,16 @@ public:
         return (Style::TextOrigin)origin;
     }
 
-    DRW_Layer *getSourceLayer(const DRW_Entity *e) {
-        DRW_Layer *layer = NULL;
+    const DRW_Layer *getSourceLayer(const DRW_Entity *e) {
+        const DRW_Layer *layer = NULL;
         if(insertInsert != NULL) {
             std::string l = insertInsert->layer;
-            auto bi = layers.find(l);
-            if(bi != layers.end()) layer = &bi->second;
+            auto bi = layers->find(l);
+            if(bi != layers->end()) layer = &bi->second;
         } else {
             std::string l = e->layer;
-            auto bi = layers.find(l);
-            if(bi != layers.end()) layer = &bi->second;
+            auto bi = layers->find(l);
+            if(bi != layers->end()) layer = &bi->second;
         }
         return layer;
     }
@@ -272,7 +312,7 @@ public:
             }
         }
         if(col == DRW::ColorByLayer) {
-            DRW_Layer *layer = getSourceLayer(e);
+            const DRW_Layer *layer = getSourceLayer(e);
             if(layer != NULL) {
                 col = layer->color;
             } else {
@@ -292,7 +332,7 @@ public:
             }
         }
         if(result == DRW_LW_Conv::widthByLayer) {
-            DRW_Layer *layer = getSourceLayer(e);
+            const DRW_Layer *layer = getSourceLayer(e);
             if(layer != NULL) {
                 result = layer->lWeight;
             } else {
@@ -312,7 +352,7 @@ public:
             }
         }
         if(result == "BYLAYER") {
-            DRW_Layer *layer = getSourceLayer(e);
+            const DRW_Layer *layer = getSourceLayer(e);
             if(layer != NULL) {
                 result = ToUpper(layer->lineType);
             } else {
@@ -322,24 +362,7 @@ public:
         return result;
     }
 
-    hStyle invisibleStyle() {
-        std::string id = "@dxf-invisible";
-
-        auto si = styles.find(id);
-        if(si != styles.end()) {
-            return si->second;
-        }
-
-        hStyle hs = { Style::CreateCustomStyle(/*rememberForUndo=*/false) };
-        Style *s = Style::Get(hs);
-        s->name = id;
-        s->visible = false;
-
-        styles.emplace(id, hs);
-        return hs;
-    }
-
-    hStyle styleFor(const DRW_Entity *e) {
+    int styleFor(const DRW_Entity *e) {
         // Color.
         // TODO: which color to choose: index or RGB one?
         int col = getColor(e);
@@ -368,7 +391,7 @@ public:
         DRW_Text::HAlign alignH = DRW_Text::HLeft;
         DRW_Text::VAlign alignV = DRW_Text::VBaseLine;
         double textAngle = 0.0;
-        double textHeight = Style::DefaultTextHeight();
+        double textHeight = defaultTextHeight;
 
         if(e->eType == DRW::TEXT || e->eType == DRW::MTEXT) {
             const DRW_Text *text = static_cast<const DRW_Text *>(e);
@@ -390,7 +413,7 @@ public:
             id += ssprintf("-%s", lineType.c_str());
         if(c.red != 0 || c.green != 0 || c.blue != 0)
             id += ssprintf("-#%02x%02x%02x", c.red, c.green, c.blue);
-        if(textHeight != Style::DefaultTextHeight())
+        if(textHeight != defaultTextHeight)
             id += ssprintf("-h%.4g", textHeight);
         if(textAngle != 0.0)
             id += ssprintf("-a%.5g", textAngle);
@@ -399,172 +422,45 @@ public:
         if(alignV != DRW_Text::VBaseLine)
             id += ssprintf("-ov%d", alignV);
 
-        auto si = styles.find(id);
-        if(si != styles.end()) {
+        auto si = styleIndex.find(id);
+        if(si != styleIndex.end()) {
             return si->second;
         }
 
-        hStyle hs = { Style::CreateCustomStyle(/*rememberForUndo=*/false) };
-        Style *s = Style::Get(hs);
-        if(lw != DRW_LW_Conv::widthDefault) {
-            s->widthAs = Style::UnitsAs::MM;
-            s->width = width;
-            s->stippleScale = 1.0 + width * 2.0;
-        }
-        s->name = id;
-        s->stippleType = stipple;
-        if(c.red != 0 || c.green != 0 || c.blue != 0) s->color = c;
-        s->textHeightAs = Style::UnitsAs::MM;
-        s->textHeight = textHeight;
-        s->textAngle = textAngle;
-        s->textOrigin = dxfAlignToOrigin(alignH, alignV);
-
-        styles.emplace(id, hs);
-        return hs;
-    }
-
-    void setStyle(hRequest hr, hStyle hs) {
-        Request *r = SK.GetRequest(hr);
-        r->style = hs;
-    }
-
-    struct VectorHash {
-        size_t operator()(const Vector &v) const {
-            static const size_t size = std::numeric_limits<size_t>::max() / 2 - 1;
-            static const double eps = (4.0 * LENGTH_EPS);
-
-            double x = fabs(v.x) / eps;
-            double y = fabs(v.y) / eps;
-
-            size_t xs = size_t(fmod(x, double(size)));
-            size_t ys = size_t(fmod(y, double(size)));
-
-            return ys * size + xs;
-        }
-    };
-
-    struct VectorPred {
-        bool operator()(Vector a, Vector b) const {
-            return a.Equals(b, LENGTH_EPS);
-        }
-    };
-
-    std::unordered_map<Vector, hEntity, VectorHash, VectorPred> points;
-
-    void processPoint(hEntity he, bool constrain = true) {
-        Entity *e = SK.GetEntity(he);
-        Vector pos = e->PointGetNum();
-        hEntity p = findPoint(pos);
-        if(p.v == he.v) return;
-        if(p.v != Entity::NO_ENTITY.v) {
-            if(constrain) {
-                Constraint::ConstrainCoincident(he, p);
-            }
-            // We don't add point because we already
-            // have point in this position
-            return;
-        }
-        points.emplace(pos, he);
-    }
-
-    hEntity findPoint(const Vector &p) {
-        auto it = points.find(p);
-        if(it == points.end()) return Entity::NO_ENTITY;
-        return it->second;
-    }
-
-    hEntity createOrGetPoint(const Vector &p) {
-        hEntity he = findPoint(p);
-        if(he.v != Entity::NO_ENTITY.v) return he;
-
-        hRequest hr = SS.GW.AddRequest(Request::Type::DATUM_POINT, /*rememberForUndo=*/false);
-        he = hr.entity(0);
-        SK.GetEntity(he)->PointForceTo(p);
-        points.emplace(p, he);
-        return he;
-    }
-
-    hEntity createLine(Vector p0, Vector p1, uint32_t style, bool constrainHV = false) {
-        if(p0.Equals(p1)) return Entity::NO_ENTITY;
-        hRequest hr = SS.GW.AddRequest(Request::Type::LINE_SEGMENT, /*rememberForUndo=*/false);
-        SK.GetEntity(hr.entity(1))->PointForceTo(p0);
-        SK.GetEntity(hr.entity(2))->PointForceTo(p1);
-        processPoint(hr.entity(1));
-        processPoint(hr.entity(2));
-
-        if(constrainHV) {
-            bool hasConstraint = false;
-            Constraint::Type cType;
-            if(fabs(p0.x - p1.x) < LENGTH_EPS) {
-                hasConstraint = true;
-                cType = Constraint::Type::VERTICAL;
-            } else if(fabs(p0.y - p1.y) < LENGTH_EPS) {
-                hasConstraint = true;
-                cType = Constraint::Type::HORIZONTAL;
-            }
-            if(hasConstraint) {
-                Constraint::Constrain(
-                    cType,
-                    Entity::NO_ENTITY,
-                    Entity::NO_ENTITY,
-                    hr.entity(0)
-                );
-            }
-        }
-
-        if(style != 0) {
-            Request *r = SK.GetRequest(hr);
-            r->style = hStyle{ style };
-        }
-        return hr.entity(0);
-    }
-
-    hEntity createCircle(const Vector &c, double r, uint32_t style) {
-        hRequest hr = SS.GW.AddRequest(Request::Type::CIRCLE, /*rememberForUndo=*/false);
-        SK.GetEntity(hr.entity(1))->PointForceTo(c);
-        processPoint(hr.entity(1));
-        SK.GetEntity(hr.entity(64))->DistanceForceTo(r);
-        if(style != 0) {
-            Request *r = SK.GetRequest(hr);
-            r->style = hStyle{ style };
-        }
-        return hr.entity(0);
-    }
-
-    void addLayer(const DRW_Layer &data) override {
-        layers.emplace(data.name, data);
-    }
-
-    void addBlock(const DRW_Block &data) override {
-        readBlock = &blocks[data.name];
-        readBlock->data = data;
-    }
-
-    void endBlock() override {
-        readBlock = NULL;
+        DxfStyle ds = {};
+        ds.id         = id;
+        ds.color      = c;
+        ds.hasWidth   = (lw != DRW_LW_Conv::widthDefault);
+        ds.width      = width;
+        ds.stipple    = stipple;
+        ds.textHeight = textHeight;
+        ds.textAngle  = textAngle;
+        ds.textOrigin = dxfAlignToOrigin(alignH, alignV);
+
+        int index = (int)chunk->styles.size();
+        chunk->styles.push_back(ds);
+        styleIndex.emplace(id, index);
+        return index;
     }
 
-    void addPoint(const DRW_Point &data) override {
+    void addPoint(const DRW_Point &data) {
         if(data.space != DRW::ModelSpace) return;
-        if(addPendingBlockEntity<DRW_Point>(data)) return;
 
-        hRequest hr = SS.GW.AddRequest(Request::Type::DATUM_POINT, /*rememberForUndo=*/false);
-        SK.GetEntity(hr.entity(0))->PointForceTo(toVector(data.basePoint));
-        processPoint(hr.entity(0));
+        DxfGeometry *g = addGeometry(DxfGeometry::Type::POINT, -1);
+        g->p[0] = toVector(data.basePoint);
     }
 
-    void addLine(const DRW_Line &data) override {
+    void addLine(const DRW_Line &data) {
         if(data.space != DRW::ModelSpace) return;
-        if(addPendingBlockEntity<DRW_Line>(data)) return;
 
-        createLine(toVector(data.basePoint), toVector(data.secPoint), styleFor(&data).v, /*constrainHV=*/true);
+        DxfGeometry *g = addGeometry(DxfGeometry::Type::LINE, styleFor(&data));
+        g->p[0] = toVector(data.basePoint);
+        g->p[1] = toVector(data.secPoint);
     }
 
-    void addArc(const DRW_Arc &data) override {
+    void addArc(const DRW_Arc &data) {
         if(data.space != DRW::ModelSpace) return;
-        if(addPendingBlockEntity<DRW_Arc>(data)) return;
 
-        hRequest hr = SS.GW.AddRequest(Request::Type::ARC_OF_CIRCLE, /*rememberForUndo=*/false);
         double r = data.radious;
         double sa = data.staangle;
         double ea = data.endangle;
@@ -581,25 +477,22 @@ public:
 
         blockTransformArc(&c, &rvs, &rve);
 
-        SK.GetEntity(hr.entity(1))->PointForceTo(c);
-        SK.GetEntity(hr.entity(2))->PointForceTo(rvs);
-        SK.GetEntity(hr.entity(3))->PointForceTo(rve);
-        processPoint(hr.entity(1));
-        processPoint(hr.entity(2));
-        processPoint(hr.entity(3));
-        setStyle(hr, styleFor(&data));
+        DxfGeometry *g = addGeometry(DxfGeometry::Type::ARC, styleFor(&data));
+        g->p[0] = c;
+        g->p[1] = rvs;
+        g->p[2] = rve;
     }
 
-    void addCircle(const DRW_Circle &data) override {
+    void addCircle(const DRW_Circle &data) {
         if(data.space != DRW::ModelSpace) return;
-        if(addPendingBlockEntity<DRW_Circle>(data)) return;
 
-        createCircle(toVector(data.basePoint), data.radious, styleFor(&data).v);
+        DxfGeometry *g = addGeometry(DxfGeometry::Type::CIRCLE, styleFor(&data));
+        g->p[0] = toVector(data.basePoint);
+        g->r    = data.radious;
     }
 
-    void addLWPolyline(const DRW_LWPolyline &data)  override {
+    void addLWPolyline(const DRW_LWPolyline &data) {
         if(data.space != DRW::ModelSpace) return;
-        if(addPendingBlockEntity<DRW_LWPolyline>(data)) return;
 
         size_t vNum = data.vertlist.size();
 
@@ -622,20 +515,20 @@ public:
 
             Vector p0 = Vector::From(c0.x, c0.y, 0.0);
             Vector p1 = Vector::From(c1.x, c1.y, 0.0);
-            hStyle hs = styleFor(&data);
+            int style = styleFor(&data);
 
             if(EXACT(data.vertlist[i]->bulge == 0.0)) {
-                createLine(blockTransform(p0), blockTransform(p1), hs.v, /*constrainHV=*/true);
+                DxfGeometry *g = addGeometry(DxfGeometry::Type::LINE, style);
+                g->p[0] = blockTransform(p0);
+                g->p[1] = blockTransform(p1);
             } else {
-                hRequest hr = createBulge(p0, p1, c0.bulge);
-                setStyle(hr, hs);
+                addBulge(p0, p1, c0.bulge, style);
             }
         }
     }
 
-    void addPolyline(const DRW_Polyline &data) override {
+    void addPolyline(const DRW_Polyline &data) {
         if(data.space != DRW::ModelSpace) return;
-        if(addPendingBlockEntity<DRW_Polyline>(data)) return;
 
         int vNum = data.vertlist.size();
 
@@ -659,37 +552,34 @@ public:
 
             Vector p0 = Vector::From(c0.x, c0.y, 0.0);
             Vector p1 = Vector::From(c1.x, c1.y, 0.0);
-            hStyle hs = styleFor(&data);
+            int style = styleFor(&data);
 
             if(EXACT(bulge == 0.0)) {
-                createLine(blockTransform(p0), blockTransform(p1), hs.v, /*constrainHV=*/true);
+                DxfGeometry *g = addGeometry(DxfGeometry::Type::LINE, style);
+                g->p[0] = blockTransform(p0);
+                g->p[1] = blockTransform(p1);
             } else {
-                hRequest hr = createBulge(p0, p1, bulge);
-                setStyle(hr, hs);
+                addBulge(p0, p1, bulge, style);
             }
         }
     }
 
-    void addSpline(const DRW_Spline *data) override {
+    void addSpline(const DRW_Spline *data) {
         if(data->space != DRW::ModelSpace) return;
         if(data->degree != 3) return;
-        if(addPendingBlockEntity<DRW_Spline>(*data)) return;
 
-        hRequest hr = SS.GW.AddRequest(Request::Type::CUBIC, /*rememberForUndo=*/false);
+        DxfGeometry *g = addGeometry(DxfGeometry::Type::CUBIC, styleFor(data));
         for(int i = 0; i < 4; i++) {
-            SK.GetEntity(hr.entity(i + 1))->PointForceTo(toVector(*data->controllist[i]));
-            processPoint(hr.entity(i + 1));
+            g->p[i] = toVector(*data->controllist[i]);
         }
-        setStyle(hr, styleFor(data));
     }
 
-    void addInsert(const DRW_Insert &data) override {
+    void addInsert(const DRW_Insert &data) {
         if(data.space != DRW::ModelSpace) return;
-        if(addPendingBlockEntity<DRW_Insert>(data)) return;
 
-        auto bi = blocks.find(data.name);
-        ssassert(bi != blocks.end(), "Inserted block does not exist");
-        Block *block = &bi->second;
+        auto bi = blocks->find(data.name);
+        ssassert(bi != blocks->end(), "Inserted block does not exist");
+        const DxfBlock *block = &bi->second;
 
         // Push transform.
         Vector x = blockX;
@@ -713,59 +603,41 @@ public:
         blockT = t;
     }
 
-    void addMText(const DRW_MText &data) override {
+    void addMText(const DRW_MText &data) {
         if(data.space != DRW::ModelSpace) return;
-        if(addPendingBlockEntity<DRW_MText>(data)) return;
 
         DRW_MText text = data;
         text.secPoint = text.basePoint;
         addText(text);
     }
 
-    void addText(const DRW_Text &data) override {
+    void addText(const DRW_Text &data) {
         if(data.space != DRW::ModelSpace) return;
-        if(addPendingBlockEntity<DRW_Text>(data)) return;
 
-        Constraint c = {};
-        c.group         = SS.GW.activeGroup;
-        c.workplane     = SS.GW.ActiveWorkplane();
-        c.type          = Constraint::Type::COMMENT;
+        DxfGeometry *g = addGeometry(DxfGeometry::Type::COMMENT, styleFor(&data));
         if(data.alignH == DRW_Text::HLeft && data.alignV == DRW_Text::VBaseLine) {
-            c.disp.offset   = toVector(data.basePoint);
+            g->p[0] = toVector(data.basePoint);
         } else {
-            c.disp.offset   = toVector(data.secPoint);
+            g->p[0] = toVector(data.secPoint);
         }
-        c.comment       = data.text;
-        c.disp.style    = styleFor(&data);
-        Constraint::AddConstraint(&c, /*rememberForUndo=*/false);
+        g->text = data.text;
     }
 
-    void addDimAlign(const DRW_DimAligned *data) override {
+    void addDimAlign(const DRW_DimAligned *data) {
         if(data->space != DRW::ModelSpace) return;
-        if(addPendingBlockEntity<DRW_DimAligned>(*data)) return;
-
-        Vector p0 = toVector(data->getDef1Point());
-        Vector p1 = toVector(data->getDef2Point());
-        Vector p2 = toVector(data->getTextPoint());
-        hConstraint hc = Constraint::Constrain(
-            Constraint::Type::PT_PT_DISTANCE,
-            createOrGetPoint(p0),
-            createOrGetPoint(p1),
-            Entity::NO_ENTITY
-        );
 
-        Constraint *c = SK.GetConstraint(hc);
+        DxfGeometry *g = addGeometry(DxfGeometry::Type::DIM_ALIGNED, -1);
+        g->p[0] = toVector(data->getDef1Point());
+        g->p[1] = toVector(data->getDef2Point());
+        g->p[2] = toVector(data->getTextPoint());
         if(data->hasActualMeasurement()) {
-            c->valA = data->getActualMeasurement();
-        } else {
-            c->ModifyToSatisfy();
+            g->hasActual = true;
+            g->actual    = data->getActualMeasurement();
         }
-        c->disp.offset = p2.Minus(p0.Plus(p1).ScaledBy(0.5));
     }
 
-    void addDimLinear(const DRW_DimLinear *data) override {
+    void addDimLinear(const DRW_DimLinear *data) {
         if(data->space != DRW::ModelSpace) return;
-        if(addPendingBlockEntity<DRW_DimLinear>(*data)) return;
 
         Vector p0 = toVector(data->getDef1Point(), /*transform=*/false);
         Vector p1 = toVector(data->getDef2Point(), /*transform=*/false);
@@ -780,88 +652,44 @@ public:
 
         Vector p4 = p0.ClosestPointOnLine(p1, p3.Minus(p1)).Plus(p0).ScaledBy(0.5);
 
-        p0 = blockTransform(p0);
-        p1 = blockTransform(p1);
-        p2 = blockTransform(p2);
-        p3 = blockTransform(p3);
-        p4 = blockTransform(p4);
-
-        hConstraint hc = Constraint::Constrain(
-            Constraint::Type::PT_LINE_DISTANCE,
-            createOrGetPoint(p0),
-            Entity::NO_ENTITY,
-            createLine(p1, p3, invisibleStyle().v)
-        );
-
-        Constraint *c = SK.GetConstraint(hc);
+        DxfGeometry *g = addGeometry(DxfGeometry::Type::DIM_LINEAR, -1);
+        g->p[0] = blockTransform(p0);
+        g->p[1] = blockTransform(p1);
+        g->p[2] = blockTransform(p2);
+        g->p[3] = blockTransform(p3);
+        g->p[4] = blockTransform(p4);
         if(data->hasActualMeasurement()) {
-            c->valA = data->getActualMeasurement();
-        } else {
-            c->ModifyToSatisfy();
+            g->hasActual = true;
+            g->actual    = data->getActualMeasurement();
         }
-        c->disp.offset = p2.Minus(p4);
     }
 
-    void addDimAngular(const DRW_DimAngular *data) override {
+    void addDimAngular(const DRW_DimAngular *data) {
         if(data->space != DRW::ModelSpace) return;
-        if(addPendingBlockEntity<DRW_DimAngular>(*data)) return;
-
-        Vector l0p0 = toVector(data->getFirstLine1());
-        Vector l0p1 = toVector(data->getFirstLine2());
-        Vector l1p0 = toVector(data->getSecondLine1());
-        Vector l1p1 = toVector(data->getSecondLine2());
-
-        hConstraint hc = Constraint::Constrain(
-            Constraint::Type::ANGLE,
-            Entity::NO_ENTITY,
-            Entity::NO_ENTITY,
-            createLine(l0p0, l0p1, invisibleStyle().v),
-            createLine(l1p1, l1p0, invisibleStyle().v),
-            /*other=*/false,
-            /*other2=*/false
-        );
 
-        Constraint *c = SK.GetConstraint(hc);
-        c->ModifyToSatisfy();
+        DxfGeometry *g = addGeometry(DxfGeometry::Type::DIM_ANGULAR, -1);
+        g->p[0] = toVector(data->getFirstLine1());
+        g->p[1] = toVector(data->getFirstLine2());
+        g->p[2] = toVector(data->getSecondLine1());
+        g->p[3] = toVector(data->getSecondLine2());
+        g->p[4] = toVector(data->getTextPoint());
         if(data->hasActualMeasurement()) {
-            double actual = data->getActualMeasurement() / PI * 180.0;
-            if(fabs(180.0 - actual - c->valA) < fabs(actual - c->valA)) {
-                c->other = true;
-            }
-            c->valA = actual;
-        }
-
-        bool skew = false;
-        Vector pi = Vector::AtIntersectionOfLines(l0p0, l0p1, l1p0, l1p1, &skew);
-        if(!skew) {
-            c->disp.offset = toVector(data->getTextPoint()).Minus(pi);
+            g->hasActual = true;
+            g->actual    = data->getActualMeasurement();
         }
     }
 
-    hConstraint createDiametric(Vector cp, double r, Vector tp, double actual, bool asRadius = false) {
-        hEntity he = createCircle(cp, r, invisibleStyle().v);
-
-        hConstraint hc = Constraint::Constrain(
-            Constraint::Type::DIAMETER,
-            Entity::NO_ENTITY,
-            Entity::NO_ENTITY,
-            he
-        );
-
-        Constraint *c = SK.GetConstraint(hc);
-        if(actual > 0.0) {
-            c->valA = asRadius ? actual * 2.0 : actual;
-        } else {
-            c->ModifyToSatisfy();
-        }
-        c->disp.offset = tp.Minus(cp);
-        if(asRadius) c->other = true;
-        return hc;
+    void addDiametric(Vector cp, double r, Vector tp, double actual, bool asRadius) {
+        DxfGeometry *g = addGeometry(DxfGeometry::Type::DIM_DIAMETRIC, -1);
+        g->p[0]     = cp;
+        g->p[1]     = tp;
+        g->r        = r;
+        g->actual   = actual;
+        g->asRadius = asRadius;
     }
 
-    void addDimRadial(const DRW_DimRadial *data) override {
+    void addDimRadial(const DRW_DimRadial *data) {
         if(data->space != DRW::ModelSpace) return;
-        if(addPendingBlockEntity<DRW_DimRadial>(*data)) return;
 
         Vector cp = toVector(data->getCenterPoint());
         Vector dp = toVector(data->getDiameterPoint());
@@ -871,12 +699,11 @@ public:
             actual = data->getActualMeasurement();
         }
 
-        createDiametric(cp, cp.Minus(dp).Magnitude(), tp, actual, /*asRadius=*/true);
+        addDiametric(cp, cp.Minus(dp).Magnitude(), tp, actual, /*asRadius=*/true);
     }
 
-    void addDimDiametric(const DRW_DimDiametric *data) override {
+    void addDimDiametric(const DRW_DimDiametric *data) {
         if(data->space != DRW::ModelSpace) return;
-        if(addPendingBlockEntity<DRW_DimRadial>(*data)) return;
 
         Vector dp1 = toVector(data->getDiameter1Point());
         Vector dp2 = toVector(data->getDiameter2Point());
@@ -888,12 +715,11 @@ public:
             actual = data->getActualMeasurement();
         }
 
-        createDiametric(cp, cp.Minus(dp1).Magnitude(), tp, actual, /*asRadius=*/false);
+        addDiametric(cp, cp.Minus(dp1).Magnitude(), tp, actual, /*asRadius=*/false);
     }
 
-    void addDimAngular3P(const DRW_DimAngular3p *data) override {
+    void addDimAngular3P(const DRW_DimAngular3p *data) {
         if(data->space != DRW::ModelSpace) return;
-        if(addPendingBlockEntity<DRW_DimAngular3p>(*data)) return;
 
         DRW_DimAngular dim = *static_cast<const DRW_Dimension *>(data);
         dim.setFirstLine1(data->getVertexPoint());
@@ -904,12 +730,457 @@ public:
     }
 };
 
+class DxfReadInterface : public DRW_Interface {
+public:
+    unsigned unknownEntities = 0;
+    std::map<std::string, hStyle> styles;
+    std::map<std::string, DxfBlock> blocks;
+    std::map<std::string, DRW_Layer> layers;
+    std::vector<std::unique_ptr<DRW_Entity>> entities;
+    DxfBlock *readBlock = NULL;
+
+    // While reading the file, the entities are only collected, either into
+    // the block being read or into the list of model space entities.
+    template<class T>
+    void addPendingEntity(const T &e) {
+        if(e.space != DRW::ModelSpace) return;
+        if(readBlock != NULL) {
+            readBlock->entities.emplace_back(new T(e));
+        } else {
+            entities.emplace_back(new T(e));
+        }
+    }
+
+    hStyle invisibleStyle() {
+        std::string id = "@dxf-invisible";
+
+        auto si = styles.find(id);
+        if(si != styles.end()) {
+            return si->second;
+        }
+
+        hStyle hs = { Style::CreateCustomStyle(/*rememberForUndo=*/false) };
+        Style *s = Style::Get(hs);
+        s->name = id;
+        s->visible = false;
+
+        styles.emplace(id, hs);
+        return hs;
+    }
+
+    hStyle styleFor(const DxfStyle &ds) {
+        auto si = styles.find(ds.id);
+        if(si != styles.end()) {
+            return si->second;
+        }
+
+        const RgbaColor &c = ds.color;
+        hStyle hs = { Style::CreateCustomStyle(/*rememberForUndo=*/false) };
+        Style *s = Style::Get(hs);
+        if(ds.hasWidth) {
+            s->widthAs = Style::UnitsAs::MM;
+            s->width = ds.width;
+            s->stippleScale = 1.0 + ds.width * 2.0;
+        }
+        s->name = ds.id;
+        s->stippleType = ds.stipple;
+        if(c.red != 0 || c.green != 0 || c.blue != 0) s->color = c;
+        s->textHeightAs = Style::UnitsAs::MM;
+        s->textHeight = ds.textHeight;
+        s->textAngle = ds.textAngle;
+        s->textOrigin = ds.textOrigin;
+
+        styles.emplace(ds.id, hs);
+        return hs;
+    }
+
+    void setStyle(hRequest hr, hStyle hs) {
+        Request *r = SK.GetRequest(hr);
+        r->style = hs;
+    }
+
+    struct VectorHash {
+        size_t operator()(const Vector &v) const {
+            static const size_t size = std::numeric_limits<size_t>::max() / 2 - 1;
+            static const double eps = (4.0 * LENGTH_EPS);
+
+            double x = fabs(v.x) / eps;
+            double y = fabs(v.y) / eps;
+
+            size_t xs = size_t(fmod(x, double(size)));
+            size_t ys = size_t(fmod(y, double(size)));
+
+            return ys * size + xs;
+        }
+    };
+
+    struct VectorPred {
+        bool operator()(Vector a, Vector b) const {
+            return a.Equals(b, LENGTH_EPS);
+        }
+    };
+
+    std::unordered_map<Vector, hEntity, VectorHash, VectorPred> points;
+
+    void processPoint(hEntity he, bool constrain = true) {
+        Entity *e = SK.GetEntity(he);
+        Vector pos = e->PointGetNum();
+        hEntity p = findPoint(pos);
+        if(p.v == he.v) return;
+        if(p.v != Entity::NO_ENTITY.v) {
+            if(constrain) {
+                Constraint::ConstrainCoincident(he, p);
+            }
+            // We don't add point because we already
+            // have point in this position
+            return;
+        }
+        points.emplace(pos, he);
+    }
+
+    hEntity findPoint(const Vector &p) {
+        auto it = points.find(p);
+        if(it == points.end()) return Entity::NO_ENTITY;
+        return it->second;
+    }
+
+    hEntity createOrGetPoint(const Vector &p) {
+        hEntity he = findPoint(p);
+        if(he.v != Entity::NO_ENTITY.v) return he;
+
+        hRequest hr = SS.GW.AddRequest(Request::Type::DATUM_POINT, /*rememberForUndo=*/false);
+        he = hr.entity(0);
+        SK.GetEntity(he)->PointForceTo(p);
+        points.emplace(p, he);
+        return he;
+    }
+
+    hEntity createLine(Vector p0, Vector p1, uint32_t style, bool constrainHV = false) {
+        if(p0.Equals(p1)) return Entity::NO_ENTITY;
+        hRequest hr = SS.GW.AddRequest(Request::Type::LINE_SEGMENT, /*rememberForUndo=*/false);
+        SK.GetEntity(hr.entity(1))->PointForceTo(p0);
+        SK.GetEntity(hr.entity(2))->PointForceTo(p1);
+        processPoint(hr.entity(1));
+        processPoint(hr.entity(2));
+
+        if(constrainHV) {
+            bool hasConstraint = false;
+            Constraint::Type cType;
+            if(fabs(p0.x - p1.x) < LENGTH_EPS) {
+                hasConstraint = true;
+                cType = Constraint::Type::VERTICAL;
+            } else if(fabs(p0.y - p1.y) < LENGTH_EPS) {
+                hasConstraint = true;
+                cType = Constraint::Type::HORIZONTAL;
+            }
+            if(hasConstraint) {
+                Constraint::Constrain(
+                    cType,
+                    Entity::NO_ENTITY,
+                    Entity::NO_ENTITY,
+                    hr.entity(0)
+                );
+            }
+        }
+
+        if(style != 0) {
+            Request *r = SK.GetRequest(hr);
+            r->style = hStyle{ style };
+        }
+        return hr.entity(0);
+    }
+
+    hRequest createArc(Vector c, Vector p0, Vector p1) {
+        hRequest hr = SS.GW.AddRequest(Request::Type::ARC_OF_CIRCLE, /*rememberForUndo=*/false);
+        SK.GetEntity(hr.entity(1))->PointForceTo(c);
+        SK.GetEntity(hr.entity(2))->PointForceTo(p0);
+        SK.GetEntity(hr.entity(3))->PointForceTo(p1);
+        processPoint(hr.entity(1));
+        processPoint(hr.entity(2));
+        processPoint(hr.entity(3));
+        return hr;
+    }
+
+    hEntity createCircle(const Vector &c, double r, uint32_t style) {
+        hRequest hr = SS.GW.AddRequest(Request::Type::CIRCLE, /*rememberForUndo=*/false);
+        SK.GetEntity(hr.entity(1))->PointForceTo(c);
+        processPoint(hr.entity(1));
+        SK.GetEntity(hr.entity(64))->DistanceForceTo(r);
+        if(style != 0) {
+            Request *r = SK.GetRequest(hr);
+            r->style = hStyle{ style };
+        }
+        return hr.entity(0);
+    }
+
+    hConstraint createDiametric(Vector cp, double r, Vector tp, double actual, bool asRadius = false) {
+        hEntity he = createCircle(cp, r, invisibleStyle().v);
+
+        hConstraint hc = Constraint::Constrain(
+            Constraint::Type::DIAMETER,
+            Entity::NO_ENTITY,
+            Entity::NO_ENTITY,
+            he
+        );
+
+        Constraint *c = SK.GetConstraint(hc);
+        if(actual > 0.0) {
+            c->valA = asRadius ? actual * 2.0 : actual;
+        } else {
+            c->ModifyToSatisfy();
+        }
+        c->disp.offset = tp.Minus(cp);
+        if(asRadius) c->other = true;
+        return hc;
+    }
+
+    void addLayer(const DRW_Layer &data) override {
+        layers.emplace(data.name, data);
+    }
+
+    void addBlock(const DRW_Block &data) override {
+        readBlock = &blocks[data.name];
+        readBlock->data = data;
+    }
+
+    void endBlock() override {
+        readBlock = NULL;
+    }
+
+    void addPoint(const DRW_Point &data) override {
+        addPendingEntity<DRW_Point>(data);
+    }
+
+    void addLine(const DRW_Line &data) override {
+        addPendingEntity<DRW_Line>(data);
+    }
+
+    void addArc(const DRW_Arc &data) override {
+        addPendingEntity<DRW_Arc>(data);
+    }
+
+    void addCircle(const DRW_Circle &data) override {
+        addPendingEntity<DRW_Circle>(data);
+    }
+
+    void addLWPolyline(const DRW_LWPolyline &data)  override {
+        addPendingEntity<DRW_LWPolyline>(data);
+    }
+
+    void addPolyline(const DRW_Polyline &data) override {
+        addPendingEntity<DRW_Polyline>(data);
+    }
+
+    void addSpline(const DRW_Spline *data) override {
+        addPendingEntity<DRW_Spline>(*data);
+    }
+
+    void addInsert(const DRW_Insert &data) override {
+        addPendingEntity<DRW_Insert>(data);
+    }
+
+    void addMText(const DRW_MText &data) override {
+        addPendingEntity<DRW_MText>(data);
+    }
+
+    void addText(const DRW_Text &data) override {
+        addPendingEntity<DRW_Text>(data);
+    }
+
+    void addDimAlign(const DRW_DimAligned *data) override {
+        addPendingEntity<DRW_DimAligned>(*data);
+    }
+
+    void addDimLinear(const DRW_DimLinear *data) override {
+        addPendingEntity<DRW_DimLinear>(*data);
+    }
+
+    void addDimAngular(const DRW_DimAngular *data) override {
+        addPendingEntity<DRW_DimAngular>(*data);
+    }
+
+    void addDimRadial(const DRW_DimRadial *data) override {
+        addPendingEntity<DRW_DimRadial>(*data);
+    }
+
+    void addDimDiametric(const DRW_DimDiametric *data) override {
+        addPendingEntity<DRW_DimDiametric>(*data);
+    }
+
+    void addDimAngular3P(const DRW_DimAngular3p *data) override {
+        addPendingEntity<DRW_DimAngular3p>(*data);
+    }
+
+    void addGeometry(const DxfChunk &chunk, const DxfGeometry &g) {
+        switch(g.type) {
+            case DxfGeometry::Type::POINT: {
+                hRequest hr = SS.GW.AddRequest(Request::Type::DATUM_POINT, /*rememberForUndo=*/false);
+                SK.GetEntity(hr.entity(0))->PointForceTo(g.p[0]);
+                processPoint(hr.entity(0));
+                break;
+            }
+
+            case DxfGeometry::Type::LINE: {
+                hStyle hs = styleFor(chunk.styles[g.style]);
+                createLine(g.p[0], g.p[1], hs.v, /*constrainHV=*/true);
+                break;
+            }
+
+            case DxfGeometry::Type::ARC: {
+                hRequest hr = createArc(g.p[0], g.p[1], g.p[2]);
+                setStyle(hr, styleFor(chunk.styles[g.style]));
+                break;
+            }
+
+            case DxfGeometry::Type::CIRCLE:
+                createCircle(g.p[0], g.r, styleFor(chunk.styles[g.style]).v);
+                break;
+
+            case DxfGeometry::Type::CUBIC: {
+                hRequest hr = SS.GW.AddRequest(Request::Type::CUBIC, /*rememberForUndo=*/false);
+                for(int i = 0; i < 4; i++) {
+                    SK.GetEntity(hr.entity(i + 1))->PointForceTo(g.p[i]);
+                    processPoint(hr.entity(i + 1));
+                }
+                setStyle(hr, styleFor(chunk.styles[g.style]));
+                break;
+            }
+
+            case DxfGeometry::Type::COMMENT: {
+                Constraint c = {};
+                c.group         = SS.GW.activeGroup;
+                c.workplane     = SS.GW.ActiveWorkplane();
+                c.type          = Constraint::Type::COMMENT;
+                c.disp.offset   = g.p[0];
+                c.comment       = g.text;
+                c.disp.style    = styleFor(chunk.styles[g.style]);
+                Constraint::AddConstraint(&c, /*rememberForUndo=*/false);
+                break;
+            }
+
+            case DxfGeometry::Type::DIM_ALIGNED: {
+                Vector p0 = g.p[0];
+                Vector p1 = g.p[1];
+                Vector p2 = g.p[2];
+                hConstraint hc = Constraint::Constrain(
+                    Constraint::Type::PT_PT_DISTANCE,
+                    createOrGetPoint(p0),
+                    createOrGetPoint(p1),
+                    Entity::NO_ENTITY
+                );
+
+                Constraint *c = SK.GetConstraint(hc);
+                if(g.hasActual) {
+                    c->valA = g.actual;
+                } else {
+                    c->ModifyToSatisfy();
+                }
+                c->disp.offset = p2.Minus(p0.Plus(p1).ScaledBy(0.5));
+                break;
+            }
+
+            case DxfGeometry::Type::DIM_LINEAR: {
+                hConstraint hc = Constraint::Constrain(
+                    Constraint::Type::PT_LINE_DISTANCE,
+                    createOrGetPoint(g.p[0]),
+                    Entity::NO_ENTITY,
+                    createLine(g.p[1], g.p[3], invisibleStyle().v)
+                );
+
+                Constraint *c = SK.GetConstraint(hc);
+                if(g.hasActual) {
+                    c->valA = g.actual;
+                } else {
+                    c->ModifyToSatisfy();
+                }
+                c->disp.offset = g.p[2].Minus(g.p[4]);
+                break;
+            }
+
+            case DxfGeometry::Type::DIM_ANGULAR: {
+                Vector l0p0 = g.p[0];
+                Vector l0p1 = g.p[1];
+                Vector l1p0 = g.p[2];
+                Vector l1p1 = g.p[3];
+
+                hConstraint hc = Constraint::Constrain(
+                    Constraint::Type::ANGLE,
+                    Entity::NO_ENTITY,
+                    Entity::NO_ENTITY,
+                    createLine(l0p0, l0p1, invisibleStyle().v),
+                    createLine(l1p1, l1p0, invisibleStyle().v),
+                    /*other=*/false,
+                    /*other2=*/false
+                );
+
+                Constraint *c = SK.GetConstraint(hc);
+                c->ModifyToSatisfy();
+                if(g.hasActual) {
+                    double actual = g.actual / PI * 180.0;
+                    if(fabs(180.0 - actual - c->valA) < fabs(actual - c->valA)) {
+                        c->other = true;
+                    }
+                    c->valA = actual;
+                }
+
+                bool skew = false;
+                Vector pi = Vector::AtIntersectionOfLines(l0p0, l0p1, l1p0, l1p1, &skew);
+                if(!skew) {
+                    c->disp.offset = g.p[4].Minus(pi);
+                }
+                break;
+            }
+
+            case DxfGeometry::Type::DIM_DIAMETRIC:
+                createDiametric(g.p[0], g.r, g.p[1], g.actual, g.asRadius);
+                break;
+        }
+    }
+
+    //-------------------------------------------------------------------------
+    // Once the whole file is read, convert the model space entities to
+    // geometry, a chunk of them on each thread, and then add that geometry
+    // to the sketch. Points are welded and constrained as they're added, so
+    // that part stays in file order.
+    //-------------------------------------------------------------------------
+    void addEntities() {
+        const size_t chunkSize = 256;
+        std::vector<DxfChunk> chunks((entities.size() + chunkSize - 1) / chunkSize);
+
+        double defaultTextHeight = Style::DefaultTextHeight();
+        ParallelFor((int)chunks.size(), [&](int i) {
+            DxfConverter converter = {};
+            converter.blocks            = &blocks;
+            converter.layers            = &layers;
+            converter.defaultTextHeight = defaultTextHeight;
+            converter.chunk             = &chunks[i];
+            converter.clearBlockTransform();
+
+            size_t end = std::min(entities.size(), (i + 1) * chunkSize);
+            for(size_t j = i * chunkSize; j < end; j++) {
+                converter.addEntity(entities[j].get());
+            }
+        });
+        entities.clear();
+
+        for(const DxfChunk &chunk : chunks) {
+            for(const DxfGeometry &g : chunk.geometry) {
+                addGeometry(chunk, g);
+            }
+            unknownEntities += chunk.unknownEntities;
+        }
+    }
+};
+
 void ImportDxf(const std::string &filename) {
     SS.UndoRemember();
     dxfRW dxf(filename.c_str());
     DxfReadInterface interface;
-    interface.clearBlockTransform();
-    if(!dxf.read(&interface, /*ext=*/false)) {
+    SS.GW.BeginBatch();
+    bool ok = dxf.read(&interface, /*ext=*/false);
+    interface.addEntities();
+    SS.GW.EndBatch();
+    if(!ok) {
         Error("Corrupted DXF file!");
     }
     if(interface.unknownEntities > 0) {
@@ -922,8 +1193,11 @@ void ImportDwg(const std::string &filename) {
     SS.UndoRemember();
     dwgR dwg(filename.c_str());
     DxfReadInterface interface;
-    interface.clearBlockTransform();
-    if(!dwg.read(&interface, /*ext=*/false)) {
+    SS.GW.BeginBatch();
+    bool ok = dwg.read(&interface, /*ext=*/false);
+    interface.addEntities();
+    SS.GW.EndBatch();
+    if(!ok) {
         Error("Corrupted DWG file!");
     }
     if(interface.unknownEntities > 0) {
@@ -8,7 +8,8 @@
 #define EXPORT_DLL
 #include <slvs.h>
 
-Sketch SolveSpace::SK = {};
+static Sketch TheSketch = {};
+thread_local Sketch *SolveSpace::SketchInUse = &TheSketch;
 static System SYS;
 
 static int IsInit = 0;
@@ -246,6 +246,9 @@ void SMesh::AddAgainstBsp(SMesh *srcm, SBsp3 *bsp3) {
     int i;
 
     for(i = 0; i < srcm->l.n; i++) {
+        // The result is of no use if this regeneration has been superseded.
+        if(RegenerationCancelled()) break;
+
         STriangle *st = &(srcm->l.elem[i]);
         int pn = l.n;
         atLeastOneDiscarded = false;
@@ -326,36 +329,336 @@ bool SMesh::IsEmpty() const {
     return (l.n == 0);
 }
 
-uint32_t SMesh::FirstIntersectionWith(Point2d mp) const {
+//-----------------------------------------------------------------------------
+// The volume enclosed by a closed mesh, as the sum of the signed volumes
+// under each of its triangles.
+//-----------------------------------------------------------------------------
+double SMesh::CalculateVolume() const {
+    double vol = 0;
+    int i;
+    for(i = 0; i < l.n; i++) {
+        STriangle tr = l.elem[i];
+
+        // Translate to place vertex A at (x, y, 0)
+        Vector trans = Vector::From(tr.a.x, tr.a.y, 0);
+        tr.a = (tr.a).Minus(trans);
+        tr.b = (tr.b).Minus(trans);
+        tr.c = (tr.c).Minus(trans);
+
+        // Rotate to place vertex B on the y-axis. Depending on
+        // whether the triangle is CW or CCW, C is either to the
+        // right or to the left of the y-axis. This handles the
+        // sign of our normal.
+        Vector u = Vector::From(-tr.b.y, tr.b.x, 0);
+        u = u.WithMagnitude(1);
+        Vector v = Vector::From(tr.b.x, tr.b.y, 0);
+        v = v.WithMagnitude(1);
+        Vector n = Vector::From(0, 0, 1);
+
+        tr.a = (tr.a).DotInToCsys(u, v, n);
+        tr.b = (tr.b).DotInToCsys(u, v, n);
+        tr.c = (tr.c).DotInToCsys(u, v, n);
+
+        n = tr.Normal().WithMagnitude(1);
+
+        // Triangles on edge don't contribute
+        if(fabs(n.z) < LENGTH_EPS) continue;
+
+        // The plane has equation p dot n = a dot n
+        double d = (tr.a).Dot(n);
+        // nx*x + ny*y + nz*z = d
+        // nz*z = d - nx*x - ny*y
+        double A = -n.x/n.z, B = -n.y/n.z, C = d/n.z;
+
+        double mac = tr.c.y/tr.c.x, mbc = (tr.c.y - tr.b.y)/tr.c.x;
+        double xc = tr.c.x, yb = tr.b.y;
+
+        // I asked Maple for
+        //    int(int(A*x + B*y +C, y=mac*x..(mbc*x + yb)), x=0..xc);
+        double integral =
+            (1.0/3)*(
+                A*(mbc-mac)+
+                (1.0/2)*B*(mbc*mbc-mac*mac)
+            )*(xc*xc*xc)+
+            (1.0/2)*(A*yb+B*yb*mbc+C*(mbc-mac))*xc*xc+
+            C*yb*xc+
+            (1.0/2)*B*yb*yb*xc;
+
+        vol += integral;
+    }
+    return vol;
+}
+
+void SMeshBvh::Clear() {
+    node.Clear();
+    tri.Clear();
+}
+
+void SMeshBvh::Build(const SMesh *m) {
+    Clear();
+    if(m->l.n == 0) return;
+
+    std::vector<Vector> centroid;
+    centroid.reserve(m->l.n);
+    for(int i = 0; i < m->l.n; i++) {
+        const STriangle *tr = &(m->l.elem[i]);
+        centroid.push_back(((tr->a).Plus(tr->b).Plus(tr->c)).ScaledBy(1.0/3));
+        tri.Add(&i);
+    }
+    BuildNode(m, &centroid[0], 0, m->l.n);
+}
+
+// Split the triangles at the median of their centroids, along the axis in
+// which those are spread the most, until few enough are left for a leaf.
+int SMeshBvh::BuildNode(const SMesh *m, const Vector *centroid, int first, int count) {
+    Node n = {};
+    n.first = first;
+    n.count = count;
+    const STriangle *tr0 = &(m->l.elem[tri.elem[first]]);
+    n.minp = n.maxp = tr0->a;
+    Vector cmin = centroid[tri.elem[first]],
+           cmax = cmin;
+    for(int i = first; i < first + count; i++) {
+        const STriangle *tr = &(m->l.elem[tri.elem[i]]);
+        m->DoBounding(tr->a, &n.maxp, &n.minp);
+        m->DoBounding(tr->b, &n.maxp, &n.minp);
+        m->DoBounding(tr->c, &n.maxp, &n.minp);
+        m->DoBounding(centroid[tri.elem[i]], &cmax, &cmin);
+    }
+
+    int h = node.n;
+    node.Add(&n);
+    if(count <= MAX_LEAF_TRIANGLES) return h;
+
+    Vector extent = cmax.Minus(cmin);
+    int axis = (extent.x > extent.y) ? 0 : 1;
+    if(extent.z > extent.Element(axis)) axis = 2;
+
+    int half = count / 2;
+    std::nth_element(&tri.elem[first], &tri.elem[first + half], &tri.elem[first + count],
+        [&](int a, int b) {
+            return centroid[a].Element(axis) < centroid[b].Element(axis);
+        });
+
+    // The list of nodes may get reallocated as we recurse, so don't hold
+    // a pointer into it.
+    int left  = BuildNode(m, centroid, first, half),
+        right = BuildNode(m, centroid, first + half, count - half);
+    node.elem[h].count    = 0;
+    node.elem[h].child[0] = left;
+    node.elem[h].child[1] = right;
+    return h;
+}
+
+// Whether the projection of a box onto the screen might contain the point,
+// somewhere nearer than maxT; t is measured towards the viewer, so opposite
+// to projected z. We allow a pixel of slop, since the triangles are projected
+// separately from the box around them.
+static bool ProjectedBoxMightContain(Vector minp, Vector maxp, Point2d mp, double maxT) {
+    BBox box = {};
+    for(int i = 0; i < 8; i++) {
+        Vector p = Vector::From((i & 1) ? maxp.x : minp.x,
+                                (i & 2) ? maxp.y : minp.y,
+                                (i & 4) ? maxp.z : minp.z);
+        double w;
+        Vector r = SS.GW.ProjectPoint4(p, &w);
+        // Behind the eye, the projection of the box no longer contains the
+        // projection of everything inside it.
+        if(w <= 0) return true;
+        r = r.ScaledBy(SS.GW.scale/w);
+        if(i == 0) {
+            box = BBox::From(r, r);
+        } else {
+            box.Include(r);
+        }
+    }
+    return box.Contains(mp, 1) && -box.minp.z + 1 > maxT;
+}
+
+uint32_t SMeshBvh::FirstIntersectionWith(const SMesh *m, Point2d mp) const {
     Vector p0 = Vector::From(mp.x, mp.y, 0);
     Vector gn = Vector::From(0, 0, 1);
 
     double maxT = -1e12;
+    int best = -1;
     uint32_t face = 0;
 
-    int i;
-    for(i = 0; i < l.n; i++) {
-        STriangle tr = l.elem[i];
-        tr.a = SS.GW.ProjectPoint3(tr.a);
-        tr.b = SS.GW.ProjectPoint3(tr.b);
-        tr.c = SS.GW.ProjectPoint3(tr.c);
+    if(node.n == 0) return face;
 
-        Vector n = tr.Normal();
+    std::vector<int> stack;
+    stack.push_back(0);
+    while(!stack.empty()) {
+        const Node *nd = &(node.elem[stack.back()]);
+        stack.pop_back();
 
-        if(n.Dot(gn) < LENGTH_EPS) continue; // back-facing or on edge
+        if(!ProjectedBoxMightContain(nd->minp, nd->maxp, mp, maxT)) continue;
+        if(nd->count == 0) {
+            stack.push_back(nd->child[0]);
+            stack.push_back(nd->child[1]);
+            continue;
+        }
 
-        if(tr.ContainsPointProjd(gn, p0)) {
-            // Let our line have the form r(t) = p0 + gn*t
-            double t = -(n.Dot((tr.a).Minus(p0)))/(n.Dot(gn));
-            if(t > maxT) {
-                maxT = t;
-                face = tr.meta.face;
+        for(int i = nd->first; i < nd->first + nd->count; i++) {
+            int j = tri.elem[i];
+            STriangle tr = m->l.elem[j];
+            tr.a = SS.GW.ProjectPoint3(tr.a);
+            tr.b = SS.GW.ProjectPoint3(tr.b);
+            tr.c = SS.GW.ProjectPoint3(tr.c);
+
+            Vector n = tr.Normal();
+
+            if(n.Dot(gn) < LENGTH_EPS) continue; // back-facing or on edge
+
+            if(tr.ContainsPointProjd(gn, p0)) {
+                // Let our line have the form r(t) = p0 + gn*t
+                double t = -(n.Dot((tr.a).Minus(p0)))/(n.Dot(gn));
+                // We visit the triangles out of order, so break ties
+                // the same way as if we didn't.
+                if(t > maxT || (EXACT(t == maxT) && j < best)) {
+                    maxT = t;
+                    best = j;
+                    face = tr.meta.face;
+                }
             }
         }
     }
     return face;
 }
 
+// Find the triangles in every leaf whose box overlaps the given box.
+void SMeshBvh::TrianglesInBox(Vector minp, Vector maxp, std::vector<int> *l) const {
+    if(node.n == 0) return;
+
+    std::vector<int> stack;
+    stack.push_back(0);
+    while(!stack.empty()) {
+        const Node *nd = &(node.elem[stack.back()]);
+        stack.pop_back();
+
+        if(nd->minp.x > maxp.x || nd->maxp.x < minp.x ||
+           nd->minp.y > maxp.y || nd->maxp.y < minp.y ||
+           nd->minp.z > maxp.z || nd->maxp.z < minp.z) continue;
+        if(nd->count == 0) {
+            stack.push_back(nd->child[0]);
+            stack.push_back(nd->child[1]);
+            continue;
+        }
+        for(int i = nd->first; i < nd->first + nd->count; i++) {
+            l->push_back(tri.elem[i]);
+        }
+    }
+}
+
+// Find the triangles in every leaf whose box is hit by the ray from p in
+// the direction dir; the boxes get LENGTH_EPS of slop, like everything else.
+void SMeshBvh::TrianglesAlongRay(Vector p, Vector dir, std::vector<int> *l) const {
+    if(node.n == 0) return;
+
+    std::vector<int> stack;
+    stack.push_back(0);
+    while(!stack.empty()) {
+        const Node *nd = &(node.elem[stack.back()]);
+        stack.pop_back();
+
+        double tmin = 0, tmax = VERY_POSITIVE;
+        bool hit = true;
+        for(int i = 0; i < 3 && hit; i++) {
+            double lo = nd->minp.Element(i) - LENGTH_EPS,
+                   hi = nd->maxp.Element(i) + LENGTH_EPS,
+                   pi = p.Element(i), di = dir.Element(i);
+            if(fabs(di) < 1e-12) {
+                hit = (pi >= lo && pi <= hi);
+                continue;
+            }
+            double t0 = (lo - pi)/di, t1 = (hi - pi)/di;
+            if(t0 > t1) swap(t0, t1);
+            tmin = max(tmin, t0);
+            tmax = min(tmax, t1);
+            hit = (tmin <= tmax);
+        }
+        if(!hit) continue;
+
+        if(nd->count == 0) {
+            stack.push_back(nd->child[0]);
+            stack.push_back(nd->child[1]);
+            continue;
+        }
+        for(int i = nd->first; i < nd->first + nd->count; i++) {
+            l->push_back(tri.elem[i]);
+        }
+    }
+}
+
+void SMeshBuffers::Clear() {
+    vertex.Clear();
+    index.Clear();
+    run.Clear();
+}
+
+void SMeshBuffers::Build(const SMesh *m) {
+    Clear();
+
+    struct Vertex {
+        float n[3], p[3];
+
+        bool operator==(const Vertex &other) const {
+            return memcmp(this, &other, sizeof(*this)) == 0;
+        }
+    };
+    struct VertexHash {
+        size_t operator()(const Vertex &v) const {
+            size_t h = 0;
+            const uint32_t *words = (const uint32_t *)&v;
+            for(size_t i = 0; i < sizeof(v) / sizeof(uint32_t); i++) {
+                h = h * 31 + words[i];
+            }
+            return h;
+        }
+    };
+    std::unordered_map<Vertex, uint32_t, VertexHash> vertexIndex;
+
+    auto addVertex = [&](Vector n, Vector p) {
+        Vertex v = { { (float)n.x, (float)n.y, (float)n.z },
+                     { (float)p.x, (float)p.y, (float)p.z } };
+        auto it = vertexIndex.find(v);
+        uint32_t i;
+        if(it != vertexIndex.end()) {
+            i = it->second;
+        } else {
+            i = (uint32_t)vertexIndex.size();
+            vertexIndex.emplace(v, i);
+            for(float f : v.n) vertex.Add(&f);
+            for(float f : v.p) vertex.Add(&f);
+        }
+        index.Add(&i);
+    };
+
+    for(int i = 0; i < m->l.n; i++) {
+        const STriangle *tr = &(m->l.elem[i]);
+
+        if(run.n == 0 || !tr->meta.color.Equals(run.elem[run.n - 1].color)) {
+            Run r = {};
+            r.color = tr->meta.color;
+            r.first = index.n;
+            run.Add(&r);
+        }
+        run.elem[run.n - 1].count += 3;
+
+        if(tr->an.EqualsExactly(Vector::From(0, 0, 0))) {
+            // Compute the normal from the vertices
+            Vector n = tr->Normal();
+            addVertex(n, tr->a);
+            addVertex(n, tr->b);
+            addVertex(n, tr->c);
+        } else {
+            // Use the exact normals that are specified
+            addVertex(tr->an, tr->a);
+            addVertex(tr->bn, tr->b);
+            addVertex(tr->cn, tr->c);
+        }
+    }
+}
+
 STriangleLl *STriangleLl::Alloc()
     { return (STriangleLl *)AllocTemporary(sizeof(STriangleLl)); }
 SKdNode *SKdNode::Alloc()
@@ -369,13 +672,9 @@ SKdNode *SKdNode::From(SMesh *m) {
         tra[i] = m->l.elem[i];
     }
 
-    srand(0);
-    int n = m->l.n;
-    while(n > 1) {
-        int k = rand() % n;
-        n--;
+    ShuffleDeterministically(m->l.n, [&](int k, int n) {
         swap(tra[k], tra[n]);
-    }
+    });
 
     STriangleLl *tll = NULL;
     for(i = 0; i < m->l.n; i++) {
@@ -0,0 +1,529 @@
+//-----------------------------------------------------------------------------
+// Boolean operations on triangle meshes, by cutting the triangles of each
+// mesh where they intersect the other mesh, and then keeping or discarding
+// each piece according to where it lies with respect to the other mesh.
+//
+// This is an alternative to the BSP in bsp.cpp. The pairs of triangles that
+// might intersect, and the triangles that a ray might hit, are found through
+// a bounding volume hierarchy, so the time doesn't depend on how badly the
+// BSP happens to split the triangles.
+//-----------------------------------------------------------------------------
+#include "solvespace.h"
+
+// Where a piece of one mesh lies, with respect to the other mesh.
+enum class PieceClass : uint32_t {
+    INSIDE      = 100,
+    OUTSIDE     = 200,
+    COINC_SAME  = 300,
+    COINC_OPP   = 400
+};
+
+// The points of a triangle that lie in a plane, given the signed distance
+// of each vertex from that plane; we find the extent of those points along
+// the direction dir.
+static bool SpanInPlane(const Vector *v, const double *s, Vector dir,
+                        double *t0, Vector *p0, double *t1, Vector *p1)
+{
+    bool found = false;
+    for(int k = 0; k < 3; k++) {
+        int kn = (k + 1) % 3;
+        Vector p;
+        if(s[k] == 0) {
+            p = v[k];
+        } else if(s[k]*s[kn] < 0) {
+            p = v[k].Plus((v[kn].Minus(v[k])).ScaledBy(s[k]/(s[k] - s[kn])));
+        } else {
+            continue;
+        }
+
+        double t = dir.Dot(p);
+        if(!found || t < *t0) {
+            *t0 = t;
+            *p0 = p;
+        }
+        if(!found || t > *t1) {
+            *t1 = t;
+            *p1 = p;
+        }
+        found = true;
+    }
+    return found;
+}
+
+// How a pair of triangles meet: not at all, or in the same plane, or along
+// a segment of nonzero length where they cross.
+enum class Crossing : uint32_t {
+    NONE        = 0,
+    COPLANAR    = 100,
+    SEGMENT     = 200
+};
+
+static Crossing CrossTriangles(const STriangle *ta, const STriangle *tb, SEdge *se) {
+    Vector na = ta->Normal(), nb = tb->Normal();
+    if(na.Magnitude() < 1e-10 || nb.Magnitude() < 1e-10) return Crossing::NONE;
+    na = na.WithMagnitude(1);
+    nb = nb.WithMagnitude(1);
+
+    Vector va[3] = { ta->a, ta->b, ta->c },
+           vb[3] = { tb->a, tb->b, tb->c };
+    double sa[3], sb[3];
+    double da = na.Dot(ta->a), db = nb.Dot(tb->a);
+    bool coplanar = true;
+    for(int k = 0; k < 3; k++) {
+        sb[k] = na.Dot(vb[k]) - da;
+        if(fabs(sb[k]) < LENGTH_EPS) {
+            sb[k] = 0;
+        } else {
+            coplanar = false;
+        }
+        sa[k] = nb.Dot(va[k]) - db;
+        if(fabs(sa[k]) < LENGTH_EPS) sa[k] = 0;
+    }
+    if(coplanar) return Crossing::COPLANAR;
+
+    Vector dir = na.Cross(nb);
+    if(dir.Magnitude() < 1e-12) return Crossing::NONE;
+    dir = dir.WithMagnitude(1);
+
+    double a0, a1, b0, b1;
+    Vector pa0, pa1, pb0, pb1;
+    if(!SpanInPlane(va, sa, dir, &a0, &pa0, &a1, &pa1)) return Crossing::NONE;
+    if(!SpanInPlane(vb, sb, dir, &b0, &pb0, &b1, &pb1)) return Crossing::NONE;
+
+    // Both spans lie along the line where the planes meet, so the triangles
+    // intersect where those spans overlap.
+    double t0 = max(a0, b0), t1 = min(a1, b1);
+    if(t1 - t0 < LENGTH_EPS) return Crossing::NONE;
+
+    *se = SEdge::From((a0 > b0) ? pa0 : pb0,
+                      (a1 < b1) ? pa1 : pb1);
+    return Crossing::SEGMENT;
+}
+
+// If two triangles cross along a segment of nonzero length, then each of
+// them must be cut along that segment. If they're coplanar, then each of
+// them is cut along the edges of the other instead, so that every piece
+// either lies on the other triangle or doesn't.
+static void CutTriangles(const STriangle *ta, const STriangle *tb,
+                         std::vector<SEdge> *cutsA, std::vector<SEdge> *cutsB)
+{
+    SEdge se;
+    switch(CrossTriangles(ta, tb, &se)) {
+        case Crossing::COPLANAR: {
+            Vector va[3] = { ta->a, ta->b, ta->c },
+                   vb[3] = { tb->a, tb->b, tb->c };
+            for(int k = 0; k < 3; k++) {
+                cutsA->push_back(SEdge::From(vb[k], vb[(k + 1) % 3]));
+                cutsB->push_back(SEdge::From(va[k], va[(k + 1) % 3]));
+            }
+            break;
+        }
+
+        case Crossing::SEGMENT:
+            cutsA->push_back(se);
+            cutsB->push_back(se);
+            break;
+
+        case Crossing::NONE:
+            break;
+    }
+}
+
+// Split a convex polygon by the line in its plane through a with direction
+// u, where m is normal to that line within the plane. We split only if the
+// segment from a to a + len*u crosses the polygon's interior.
+static bool SplitPolygon(const std::vector<Vector> &poly, Vector m, Vector a,
+                         Vector u, double len,
+                         std::vector<Vector> *pos, std::vector<Vector> *neg)
+{
+    size_t n = poly.size();
+    double d = m.Dot(a);
+    std::vector<double> dist(n);
+    bool anyPos = false, anyNeg = false;
+    for(size_t i = 0; i < n; i++) {
+        dist[i] = m.Dot(poly[i]) - d;
+        if(fabs(dist[i]) < LENGTH_EPS) dist[i] = 0;
+        if(dist[i] > 0) anyPos = true;
+        if(dist[i] < 0) anyNeg = true;
+    }
+    if(!anyPos || !anyNeg) return false;
+
+    std::vector<Vector> cross(n);
+    double smin = VERY_POSITIVE, smax = VERY_NEGATIVE;
+    for(size_t i = 0; i < n; i++) {
+        size_t j = (i + 1) % n;
+        if(dist[i] == 0) {
+            double s = u.Dot(poly[i].Minus(a));
+            smin = min(smin, s);
+            smax = max(smax, s);
+        }
+        if(dist[i]*dist[j] < 0) {
+            cross[i] = poly[i].Plus((poly[j].Minus(poly[i])).ScaledBy(
+                                    dist[i]/(dist[i] - dist[j])));
+            double s = u.Dot(cross[i].Minus(a));
+            smin = min(smin, s);
+            smax = max(smax, s);
+        }
+    }
+    if(min(smax, len) - max(smin, 0.0) < LENGTH_EPS) return false;
+
+    pos->clear();
+    neg->clear();
+    for(size_t i = 0; i < n; i++) {
+        size_t j = (i + 1) % n;
+        if(dist[i] >= 0) pos->push_back(poly[i]);
+        if(dist[i] <= 0) neg->push_back(poly[i]);
+        if(dist[i]*dist[j] < 0) {
+            pos->push_back(cross[i]);
+            neg->push_back(cross[i]);
+        }
+    }
+    return (pos->size() >= 3 && neg->size() >= 3);
+}
+
+// Cut a triangle into convex pieces, along every cut that crosses it.
+static void CutTriangleInto(const STriangle *tr, Vector n, const std::vector<SEdge> &cuts,
+                            std::vector<std::vector<Vector>> *pieces)
+{
+    pieces->clear();
+    pieces->push_back({ tr->a, tr->b, tr->c });
+
+    std::vector<Vector> pos, neg;
+    for(const SEdge &se : cuts) {
+        Vector u = (se.b).Minus(se.a);
+        double len = u.Magnitude();
+        if(len < LENGTH_EPS) continue;
+        u = u.ScaledBy(1.0/len);
+        Vector m = n.Cross(u);
+        if(m.Magnitude() < 1e-6) continue;
+        m = m.WithMagnitude(1);
+
+        size_t count = pieces->size();
+        for(size_t i = 0; i < count; i++) {
+            if(!SplitPolygon((*pieces)[i], m, se.a, u, len, &pos, &neg)) continue;
+            (*pieces)[i] = neg;
+            pieces->push_back(pos);
+        }
+    }
+}
+
+// Classify a point on a piece with normal n, against a closed mesh. If the
+// point lies on a triangle of the mesh then it's coincident; otherwise we
+// cast rays from it, and count the triangles that they cross, with sign
+// according to their normals, to get the winding number. A ray that passes
+// too close to an edge is ambiguous, so then we try another direction.
+static bool ClassifyPoint(Vector p, Vector n, const SMesh *m, const SMeshBvh *bvh,
+                          Vector mmax, Vector mmin, std::vector<int> *nearby,
+                          PieceClass *where)
+{
+    if(p.OutsideAndNotOn(mmax, mmin)) {
+        *where = PieceClass::OUTSIDE;
+        return true;
+    }
+
+    Vector eps = Vector::From(LENGTH_EPS, LENGTH_EPS, LENGTH_EPS);
+    nearby->clear();
+    bvh->TrianglesInBox(p.Minus(eps), p.Plus(eps), nearby);
+    bool onFace = false, sameNormal = false;
+    double maxNormalMag = -1;
+    for(int i : *nearby) {
+        const STriangle *tr = &(m->l.elem[i]);
+        Vector trn = tr->Normal();
+        if(trn.Magnitude() < 1e-10) continue;
+        if(fabs((trn.WithMagnitude(1)).Dot(p.Minus(tr->a))) > LENGTH_EPS) continue;
+        if(!tr->ContainsPoint(p)) continue;
+
+        // As in the BSP, don't trust the normal of an almost-zero-area
+        // triangle if we're just on its edge.
+        onFace = true;
+        if(trn.Magnitude() > maxNormalMag) {
+            sameNormal = n.Dot(trn) > 0;
+            maxNormalMag = trn.Magnitude();
+        }
+    }
+    if(onFace) {
+        *where = sameNormal ? PieceClass::COINC_SAME : PieceClass::COINC_OPP;
+        return true;
+    }
+
+    // Cast the rays roughly towards the nearest face of the mesh's bounding
+    // box, so that they pass through as few boxes in the hierarchy as we can.
+    int axis = 0;
+    double sign = 1, nearest = VERY_POSITIVE;
+    for(int i = 0; i < 3; i++) {
+        double dmax = mmax.Element(i) - p.Element(i),
+               dmin = p.Element(i) - mmin.Element(i);
+        if(dmax < nearest) {
+            axis = i;
+            sign = 1;
+            nearest = dmax;
+        }
+        if(dmin < nearest) {
+            axis = i;
+            sign = -1;
+            nearest = dmin;
+        }
+    }
+
+    const double tol = 1e-6;
+    for(int attempt = 0; attempt < 10; attempt++) {
+        Vector dir = Vector::From(Random(0.5) - 0.25, Random(0.5) - 0.25, Random(0.5) - 0.25);
+        dir = dir.Plus(Vector::From(axis == 0 ? sign : 0,
+                                    axis == 1 ? sign : 0,
+                                    axis == 2 ? sign : 0));
+        dir = dir.WithMagnitude(1);
+
+        nearby->clear();
+        bvh->TrianglesAlongRay(p, dir, nearby);
+        int winding = 0;
+        bool ambiguous = false;
+        for(int i : *nearby) {
+            const STriangle *tr = &(m->l.elem[i]);
+            Vector e1 = (tr->b).Minus(tr->a),
+                   e2 = (tr->c).Minus(tr->a);
+            Vector trn = e1.Cross(e2);
+            if(trn.Magnitude() < 1e-10) continue;
+
+            Vector h = dir.Cross(e2);
+            double det = e1.Dot(h);
+            if(fabs(det) < tol*trn.Magnitude()) {
+                // Parallel to the triangle; ambiguous only if the ray could
+                // lie in its plane.
+                if(fabs((trn.WithMagnitude(1)).Dot(p.Minus(tr->a))) < LENGTH_EPS) {
+                    ambiguous = true;
+                    break;
+                }
+                continue;
+            }
+            Vector s = p.Minus(tr->a), q = s.Cross(e1);
+            double u = s.Dot(h)/det,
+                   v = dir.Dot(q)/det,
+                   t = e2.Dot(q)/det;
+            if(u < -tol || v < -tol || u + v > 1 + tol || t < -LENGTH_EPS) continue;
+            if(u < tol || v < tol || u + v > 1 - tol || t < LENGTH_EPS) {
+                ambiguous = true;
+                break;
+            }
+            winding += (trn.Dot(dir) > 0) ? 1 : -1;
+        }
+        if(ambiguous) continue;
+
+        *where = (winding > 0) ? PieceClass::INSIDE : PieceClass::OUTSIDE;
+        return true;
+    }
+    return false;
+}
+
+static int FindGroup(std::vector<int> *parent, int i) {
+    while((*parent)[i] != i) {
+        (*parent)[i] = (*parent)[(*parent)[i]];
+        i = (*parent)[i];
+    }
+    return i;
+}
+
+// Triangles that aren't cut at all, and that share an edge, must lie on the
+// same side of the other mesh; so we put them in the same group, and cast
+// rays only once for each group.
+static void GroupUncutTriangles(const SMesh *m, const std::vector<std::vector<SEdge>> &cuts,
+                                std::vector<int> *parent)
+{
+    struct Edge {
+        Vector  a, b;
+        int     tri;
+    };
+    auto lessThan = [](Vector p, Vector q) {
+        if(p.x != q.x) return p.x < q.x;
+        if(p.y != q.y) return p.y < q.y;
+        return p.z < q.z;
+    };
+
+    std::vector<Edge> edges;
+    for(int i = 0; i < m->l.n; i++) {
+        if(!cuts[i].empty()) continue;
+        const STriangle *tr = &(m->l.elem[i]);
+        Vector v[3] = { tr->a, tr->b, tr->c };
+        for(int k = 0; k < 3; k++) {
+            Edge e = { v[k], v[(k + 1) % 3], i };
+            if(lessThan(e.b, e.a)) swap(e.a, e.b);
+            edges.push_back(e);
+        }
+    }
+    std::sort(edges.begin(), edges.end(), [&](const Edge &p, const Edge &q) {
+        if(lessThan(p.a, q.a)) return true;
+        if(lessThan(q.a, p.a)) return false;
+        return lessThan(p.b, q.b);
+    });
+
+    parent->resize(m->l.n);
+    for(int i = 0; i < m->l.n; i++) (*parent)[i] = i;
+    for(size_t i = 1; i < edges.size(); i++) {
+        const Edge &p = edges[i - 1], &q = edges[i];
+        if(lessThan(p.a, q.a) || lessThan(p.b, q.b)) continue;
+        (*parent)[FindGroup(parent, p.tri)] = FindGroup(parent, q.tri);
+    }
+}
+
+// Add the pieces of each triangle of srcm that we should keep, with the
+// same rules as SBsp3::InsertInPlane: flipNormal keeps the pieces inside
+// the other mesh instead of outside it, and reverses them; keepCoplanar
+// keeps the pieces that lie on the other mesh, if their normals agree
+// (or disagree, when flipping).
+static bool AddPiecesInto(SMesh *into, const SMesh *srcm,
+                          const std::vector<std::vector<SEdge>> &cuts,
+                          const SMesh *agnst, const SMeshBvh *bvh)
+{
+    Vector mmax, mmin;
+    agnst->GetBounding(&mmax, &mmin);
+
+    std::vector<int> parent;
+    GroupUncutTriangles(srcm, cuts, &parent);
+    std::vector<PieceClass> groupClass(srcm->l.n);
+    std::vector<bool> groupKnown(srcm->l.n, false);
+
+    std::vector<std::vector<Vector>> pieces;
+    std::vector<int> nearby;
+    for(int i = 0; i < srcm->l.n; i++) {
+        const STriangle *tr = &(srcm->l.elem[i]);
+        Vector n = tr->Normal();
+        if(n.Magnitude() < 1e-10) continue;
+        n = n.WithMagnitude(1);
+
+        int group = FindGroup(&parent, i);
+        CutTriangleInto(tr, n, cuts[i], &pieces);
+        for(const std::vector<Vector> &piece : pieces) {
+            Vector center = Vector::From(0, 0, 0);
+            for(const Vector &v : piece) center = center.Plus(v);
+            center = center.ScaledBy(1.0/piece.size());
+
+            PieceClass where;
+            if(cuts[i].empty() && groupKnown[group]) {
+                where = groupClass[group];
+            } else {
+                if(!ClassifyPoint(center, n, agnst, bvh, mmax, mmin, &nearby, &where)) {
+                    return false;
+                }
+                if(cuts[i].empty() &&
+                   (where == PieceClass::INSIDE || where == PieceClass::OUTSIDE))
+                {
+                    groupClass[group] = where;
+                    groupKnown[group] = true;
+                }
+            }
+
+            bool keep;
+            if(into->flipNormal) {
+                keep = (where == PieceClass::INSIDE) ||
+                       (where == PieceClass::COINC_OPP && into->keepCoplanar);
+            } else {
+                keep = (where == PieceClass::OUTSIDE) ||
+                       (where == PieceClass::COINC_SAME && into->keepCoplanar);
+            }
+            if(!keep) continue;
+
+            Vector pn = into->flipNormal ? n.ScaledBy(-1) : n;
+            for(size_t j = 1; j + 1 < piece.size(); j++) {
+                into->AddTriangle(tr->meta, pn, piece[0], piece[j], piece[j + 1]);
+            }
+        }
+    }
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Make the union of a and b, or the difference a minus b, by cutting the
+// meshes. If some piece can't be classified, then we leave our mesh as it
+// was and return false, so that the caller can fall back to the BSP.
+//-----------------------------------------------------------------------------
+bool SMesh::MakeFromCutBooleanOf(SMesh *a, SMesh *b, bool difference) {
+    RestartRandom(); // Let's be deterministic, at least!
+
+    SMeshBvh bvha = {}, bvhb = {};
+    bvha.Build(a);
+    bvhb.Build(b);
+
+    std::vector<std::vector<SEdge>> cutsA(a->l.n), cutsB(b->l.n);
+    Vector eps = Vector::From(LENGTH_EPS, LENGTH_EPS, LENGTH_EPS);
+    std::vector<int> nearby;
+    for(int i = 0; i < a->l.n; i++) {
+        const STriangle *ta = &(a->l.elem[i]);
+        Vector tmax = ta->a, tmin = ta->a;
+        DoBounding(ta->b, &tmax, &tmin);
+        DoBounding(ta->c, &tmax, &tmin);
+
+        nearby.clear();
+        bvhb.TrianglesInBox(tmin.Minus(eps), tmax.Plus(eps), &nearby);
+        for(int j : nearby) {
+            CutTriangles(ta, &(b->l.elem[j]), &cutsA[i], &cutsB[j]);
+        }
+    }
+
+    // In the same order as the BSP, b's pieces and then a's.
+    SMesh m = {};
+    bool success;
+    if(difference) {
+        m.flipNormal = true;
+        m.keepCoplanar = true;
+        success = AddPiecesInto(&m, b, cutsB, a, &bvha);
+
+        m.flipNormal = false;
+        m.keepCoplanar = false;
+        success = success && AddPiecesInto(&m, a, cutsA, b, &bvhb);
+    } else {
+        m.flipNormal = false;
+        m.keepCoplanar = false;
+        success = AddPiecesInto(&m, b, cutsB, a, &bvha);
+
+        m.flipNormal = false;
+        m.keepCoplanar = true;
+        success = success && AddPiecesInto(&m, a, cutsA, b, &bvhb);
+    }
+
+    if(success) {
+        for(int i = 0; i < m.l.n; i++) {
+            AddTriangle(&(m.l.elem[i]));
+        }
+    }
+    m.Clear();
+    bvha.Clear();
+    bvhb.Clear();
+    return success;
+}
+
+//-----------------------------------------------------------------------------
+// Where two closed meshes interfere: we add the segments along which their
+// surfaces cross to el, and return the volume that they share. That's what's
+// left of the sum of their volumes once we take away the volume of their
+// union, which we can find with the usual Boolean.
+//-----------------------------------------------------------------------------
+double SMesh::InterferenceWith(SMesh *b, SEdgeList *el) {
+    SMeshBvh bvhb = {};
+    bvhb.Build(b);
+
+    Vector eps = Vector::From(LENGTH_EPS, LENGTH_EPS, LENGTH_EPS);
+    std::vector<int> nearby;
+    for(int i = 0; i < l.n; i++) {
+        const STriangle *ta = &(l.elem[i]);
+        Vector tmax = ta->a, tmin = ta->a;
+        DoBounding(ta->b, &tmax, &tmin);
+        DoBounding(ta->c, &tmax, &tmin);
+
+        nearby.clear();
+        bvhb.TrianglesInBox(tmin.Minus(eps), tmax.Plus(eps), &nearby);
+        for(int j : nearby) {
+            SEdge se;
+            if(CrossTriangles(ta, &(b->l.elem[j]), &se) == Crossing::SEGMENT) {
+                el->AddEdge(se.a, se.b);
+            }
+        }
+    }
+    bvhb.Clear();
+
+    SMesh both = {};
+    if(!both.MakeFromCutBooleanOf(this, b, /*difference=*/false)) {
+        both.MakeFromUnionOf(this, b);
+    }
+    double volume = CalculateVolume() + b->CalculateVolume() - both.CalculateVolume();
+    both.Clear();
+    return max(volume, 0.0);
+}
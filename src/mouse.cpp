@@ -460,13 +460,15 @@ void GraphicsWindow::MouseMoved(double x, double y, bool leftDown,
             ssassert(false, "Unexpected pending operation");
     }
 
-    SS.GenerateAll();
+    SS.GenerateForDrag();
 }
 
 void GraphicsWindow::ClearPending() {
     pending.points.Clear();
     pending = {};
     SS.ScheduleShowTW();
+    // If we were dragging, then that's over now.
+    SS.GenerateAfterDrag(/*onlyIfPaused=*/false);
 }
 
 void GraphicsWindow::MouseMiddleOrRightDown(double x, double y) {
@@ -846,11 +848,52 @@ hRequest GraphicsWindow::AddRequest(Request::Type type, bool rememberForUndo) {
     // place this request's entities where the mouse is can do so. But
     // we mustn't try to solve until reasonable values have been supplied
     // for these new parameters, or else we'll get a numerical blowup.
-    SS.GenerateAll(SolveSpaceUI::Generate::REGEN);
+    if(batchDepth > 0) {
+        GenerateNewRequest(r.h);
+    } else {
+        SS.GenerateAll(SolveSpaceUI::Generate::REGEN);
+    }
     SS.MarkGroupDirty(r.group);
     return r.h;
 }
 
+void GraphicsWindow::BeginBatch() {
+    batchDepth++;
+}
+
+void GraphicsWindow::EndBatch() {
+    ssassert(batchDepth > 0, "Unbalanced batch");
+    batchDepth--;
+    if(batchDepth == 0) {
+        SS.GenerateAll(SolveSpaceUI::Generate::REGEN);
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Generate the entities and parameters of a request that was just added in a
+// batch, replacing any that it had already, without regenerating the rest of
+// the sketch. Those of each request have handles within a range of their own,
+// so they're easy to find. As in GenerateAll, params that we've seen before
+// keep their values.
+//-----------------------------------------------------------------------------
+void GraphicsWindow::GenerateNewRequest(hRequest hr) {
+    IdList<Entity,hEntity> entity = {};
+    IdList<Param,hParam> param = {};
+    SK.GetRequest(hr)->Generate(&entity, &param);
+
+    for(Param &p : param) {
+        Param *prevp = SK.param.FindByIdNoOops(p.h);
+        if(prevp) p.val = prevp->val;
+    }
+
+    SK.entity.RemoveRange(hr.entity(0), hr.entity(0xffff));
+    SK.param.RemoveRange(hr.param(0), hr.param(0xffff));
+    for(Entity &e : entity) SK.entity.Add(&e);
+    for(Param &p : param) SK.param.Add(&p);
+    entity.Clear();
+    param.Clear();
+}
+
 bool GraphicsWindow::ConstrainPointByHovered(hEntity pt) {
     if(!hover.entity.v) return false;
 
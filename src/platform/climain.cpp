@@ -0,0 +1,283 @@
+//-----------------------------------------------------------------------------
+// Our main() function for the headless command-line interface, which loads
+// models, regenerates them and exports the results without any windows.
+//-----------------------------------------------------------------------------
+#include <errno.h>
+#include <limits.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "solvespace.h"
+#include "headless.h"
+
+namespace SolveSpace {
+
+/* Batch processing */
+
+enum class ExportKind : uint32_t {
+    MESH,
+    SURFACES,
+    VIEW,
+    WIREFRAME,
+    SECTION,
+};
+
+struct ExportRequest {
+    ExportKind  kind;
+    std::string extension;
+};
+
+static std::string Basename(const std::string &filename) {
+    std::string basename = filename;
+    size_t slash = basename.rfind('/');
+    if(slash != std::string::npos) basename.erase(0, slash + 1);
+    size_t dot = basename.rfind('.');
+    if(dot != std::string::npos) basename.erase(dot);
+    return basename;
+}
+
+static std::string Dirname(const std::string &filename) {
+    size_t slash = filename.rfind('/');
+    if(slash == std::string::npos) return ".";
+    return filename.substr(0, slash);
+}
+
+static std::string OutputFilename(const std::string &input, const std::string &outputDir,
+                                  const ExportRequest &req) {
+    std::string dir = outputDir.empty() ? Dirname(input) : outputDir;
+    std::string suffix;
+    switch(req.kind) {
+        case ExportKind::MESH:
+        case ExportKind::SURFACES:  suffix = "";           break;
+        case ExportKind::VIEW:      suffix = "-view";      break;
+        case ExportKind::WIREFRAME: suffix = "-wireframe"; break;
+        case ExportKind::SECTION:   suffix = "-section";   break;
+    }
+    return dir + "/" + Basename(input) + suffix + "." + req.extension;
+}
+
+// Load one model, regenerate it, and write all the requested exports. We
+// don't go through SS.OpenFile, since that would offer the autosave and
+// then remove it, and add the file to the recent list.
+static bool ProcessFile(const std::string &input, const std::string &outputDir,
+                        const std::vector<ExportRequest> &exports) {
+    TakeHeadlessErrorCount();
+
+    char absolute[PATH_MAX];
+    if(!realpath(input.c_str(), absolute)) {
+        fprintf(stderr, "%s: %s\n", input.c_str(), strerror(errno));
+        return false;
+    }
+
+    // Linked files are located relative to the file we're loading.
+    SS.saveFile = absolute;
+    if(!SS.LoadFromFile(absolute) || !SS.ReloadAllImported(/*canCancel=*/true)) {
+        fprintf(stderr, "%s: cannot load model\n", input.c_str());
+        SS.saveFile = "";
+        SS.NewFile();
+        SS.AfterNewFile();
+        return false;
+    }
+    SS.AfterNewFile();
+
+    for(const ExportRequest &req : exports) {
+        std::string output = OutputFilename(absolute, outputDir, req);
+        switch(req.kind) {
+            case ExportKind::MESH:
+                SS.ExportMeshTo(output);
+                break;
+
+            case ExportKind::SURFACES: {
+                StepFileWriter sfw = {};
+                sfw.ExportSurfacesTo(output);
+                break;
+            }
+
+            case ExportKind::VIEW:
+                SS.ExportViewOrWireframeTo(output, /*exportWireframe=*/false);
+                break;
+
+            case ExportKind::WIREFRAME:
+                SS.ExportViewOrWireframeTo(output, /*exportWireframe=*/true);
+                break;
+
+            case ExportKind::SECTION:
+                SS.ExportSectionTo(output);
+                break;
+        }
+        fprintf(stderr, "%s -> %s\n", input.c_str(), output.c_str());
+    }
+
+    int errorCount = TakeHeadlessErrorCount();
+    if(errorCount > 0) {
+        fprintf(stderr, "%s: %d error(s)\n", input.c_str(), errorCount);
+        return false;
+    }
+    return true;
+}
+
+// Each worker takes every jobs-th file, starting from its own index; the
+// models share no state, so the split doesn't need to be any smarter.
+static bool ProcessFiles(const std::vector<std::string> &inputs, size_t first, size_t stride,
+                         const std::string &outputDir,
+                         const std::vector<ExportRequest> &exports) {
+    bool success = true;
+    for(size_t i = first; i < inputs.size(); i += stride) {
+        if(!ProcessFile(inputs[i], outputDir, exports)) success = false;
+    }
+    return success;
+}
+
+static void ShowUsage(const char *argv0) {
+    fprintf(stderr,
+"Usage: %s [OPTION]... FILE...\n"
+"Load each FILE, regenerate it, and export the results; no windows are shown.\n"
+"\n"
+"  --mesh EXT           export the mesh of the active group\n"
+"                       (stl, obj, js, html)\n"
+"  --surfaces EXT       export the surfaces of the active group (step, stp)\n"
+"  --view EXT           export the 2d view, as FILE-view.EXT\n"
+"                       (pdf, eps, ps, svg, step, stp, dxf, plt, hpgl, ngc, txt)\n"
+"  --wireframe EXT      export the 3d wireframe, as FILE-wireframe.EXT\n"
+"                       (step, stp, dxf)\n"
+"  --section EXT        export a section in the plane of the active workplane,\n"
+"                       as FILE-section.EXT (same formats as --view)\n"
+"  --chord-tol TOL      chord tolerance for exported curves and meshes, in mm\n"
+"  -o, --output-dir DIR write the exported files into DIR, instead of next\n"
+"                       to each FILE\n"
+"  -j, --jobs N         process the files in N parallel worker processes\n"
+"  -h, --help           show this help\n"
+"\n"
+"Every export option may be given more than once. The exit status is zero\n"
+"only if every file was loaded and exported without errors.\n",
+        argv0);
+}
+
+static bool CheckExtension(const std::string &ext, const FileFilter filters[]) {
+    for(const FileFilter *filter = filters; filter->name; filter++) {
+        for(const char *const *pattern = filter->patterns; *pattern; pattern++) {
+            if(ext == *pattern) return true;
+        }
+    }
+    return false;
+}
+
+};
+
+int main(int argc, char **argv) {
+    // Our file format, and many of the exported ones, must have a period as
+    // the decimal separator no matter what the user's locale is.
+    setlocale(LC_ALL, "C");
+
+    InitHeadless(argv[0]);
+
+    std::vector<std::string> inputs;
+    std::vector<ExportRequest> exports;
+    std::string outputDir;
+    double chordTol = 0;
+    int jobs = 1;
+
+    for(int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        auto needValue = [&]() -> std::string {
+            if(i + 1 >= argc) {
+                fprintf(stderr, "%s: option '%s' requires an argument\n",
+                        argv[0], arg.c_str());
+                exit(2);
+            }
+            return argv[++i];
+        };
+        auto addExport = [&](ExportKind kind, const FileFilter filters[]) {
+            ExportRequest req = { kind, needValue() };
+            if(!CheckExtension(req.extension, filters)) {
+                fprintf(stderr, "%s: cannot export '%s' as '%s'\n",
+                        argv[0], arg.c_str(), req.extension.c_str());
+                exit(2);
+            }
+            exports.push_back(req);
+        };
+
+        if(arg == "-h" || arg == "--help") {
+            ShowUsage(argv[0]);
+            return 0;
+        } else if(arg == "--mesh") {
+            addExport(ExportKind::MESH, MeshFileFilter);
+        } else if(arg == "--surfaces") {
+            addExport(ExportKind::SURFACES, SurfaceFileFilter);
+        } else if(arg == "--view") {
+            addExport(ExportKind::VIEW, VectorFileFilter);
+        } else if(arg == "--wireframe") {
+            addExport(ExportKind::WIREFRAME, Vector3dFileFilter);
+        } else if(arg == "--section") {
+            addExport(ExportKind::SECTION, VectorFileFilter);
+        } else if(arg == "--chord-tol") {
+            chordTol = atof(needValue().c_str());
+            if(chordTol <= 0) {
+                fprintf(stderr, "%s: chord tolerance must be positive\n", argv[0]);
+                return 2;
+            }
+        } else if(arg == "-o" || arg == "--output-dir") {
+            outputDir = needValue();
+        } else if(arg == "-j" || arg == "--jobs") {
+            jobs = atoi(needValue().c_str());
+            if(jobs < 1) {
+                fprintf(stderr, "%s: number of jobs must be at least 1\n", argv[0]);
+                return 2;
+            }
+        } else if(arg.size() > 1 && arg[0] == '-') {
+            fprintf(stderr, "%s: unrecognized option '%s'\n", argv[0], arg.c_str());
+            ShowUsage(argv[0]);
+            return 2;
+        } else {
+            inputs.push_back(arg);
+        }
+    }
+
+    if(inputs.empty()) {
+        ShowUsage(argv[0]);
+        return 2;
+    }
+
+    SS.Init();
+    if(chordTol > 0) SS.exportChordTol = chordTol;
+
+    bool success = true;
+    if(jobs == 1 || inputs.size() == 1) {
+        success = ProcessFiles(inputs, 0, 1, outputDir, exports);
+    } else {
+        size_t workers = min((size_t)jobs, inputs.size());
+
+        // Flush before forking, or anything buffered gets written twice.
+        fflush(stdout);
+        fflush(stderr);
+
+        std::vector<pid_t> pids;
+        for(size_t i = 0; i < workers; i++) {
+            pid_t pid = fork();
+            if(pid < 0) {
+                fprintf(stderr, "%s: cannot fork: %s\n", argv[0], strerror(errno));
+                success = false;
+                break;
+            } else if(pid == 0) {
+                bool workerSuccess = ProcessFiles(inputs, i, workers, outputDir, exports);
+                fflush(stdout);
+                fflush(stderr);
+                _exit(workerSuccess ? 0 : 1);
+            }
+            pids.push_back(pid);
+        }
+
+        for(pid_t pid : pids) {
+            int status;
+            if(waitpid(pid, &status, 0) < 0 ||
+               !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                success = false;
+            }
+        }
+    }
+
+    SK.Clear();
+    SS.Clear();
+
+    return success ? 0 : 1;
+}
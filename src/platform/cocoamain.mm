@@ -119,10 +119,12 @@ void SolveSpace::SetAutosaveTimerFor(int minutes) {
 }
 
 void SolveSpace::ScheduleLater() {
-    [[NSRunLoop currentRunLoop]
-        performSelector:@selector(runLater:)
-        target:[DeferredHandler class] argument:nil
-        order:0 modes:@[NSDefaultRunLoopMode]];
+    // This may be called from any thread, so it goes to the main run loop,
+    // not to the current one.
+    [DeferredHandler
+        performSelectorOnMainThread:@selector(runLater:)
+        withObject:nil waitUntilDone:NO
+        modes:@[NSDefaultRunLoopMode]];
 }
 
 /* OpenGL view */
@@ -46,7 +46,6 @@
 #include <cairomm/xlib_surface.h>
 #include <pangomm/fontdescription.h>
 #include <gdk/gdkx.h>
-#include <fontconfig/fontconfig.h>
 
 #include <GL/glx.h>
 
@@ -219,13 +218,15 @@ void SetAutosaveTimerFor(int minutes) {
     Glib::signal_timeout().connect(&AutosaveTimerCallback, minutes * 60 * 1000);
 }
 
-static bool LaterCallback() {
+static gboolean LaterCallback(gpointer) {
     SS.DoLater();
-    return false;
+    return FALSE;
 }
 
 void ScheduleLater() {
-    Glib::signal_idle().connect(&LaterCallback);
+    // Not Glib::signal_idle(), since that may only be used from the thread
+    // that runs the main loop.
+    g_idle_add(&LaterCallback, NULL);
 }
 
 /* GL wrapper */
@@ -1471,59 +1472,6 @@ void OpenWebsite(const char *url) {
     gtk_show_uri(Gdk::Screen::get_default()->gobj(), url, GDK_CURRENT_TIME, NULL);
 }
 
-/* fontconfig is already initialized by GTK */
-std::vector<std::string> GetFontFiles() {
-    std::vector<std::string> fonts;
-
-    FcPattern   *pat = FcPatternCreate();
-    FcObjectSet *os  = FcObjectSetBuild(FC_FILE, (char *)0);
-    FcFontSet   *fs  = FcFontList(0, pat, os);
-
-    for(int i = 0; i < fs->nfont; i++) {
-        FcChar8 *filenameFC = FcPatternFormat(fs->fonts[i], (const FcChar8*) "%{file}");
-        std::string filename = (char*) filenameFC;
-        fonts.push_back(filename);
-        FcStrFree(filenameFC);
-    }
-
-    FcFontSetDestroy(fs);
-    FcObjectSetDestroy(os);
-    FcPatternDestroy(pat);
-
-    return fonts;
-}
-
-static std::string resource_dir;
-const void *LoadResource(const std::string &name, size_t *size) {
-    static std::map<std::string, std::vector<uint8_t>> cache;
-
-    auto it = cache.find(name);
-    if(it == cache.end()) {
-        struct stat st;
-        std::string path;
-
-        path = (UNIX_DATADIR "/") + name;
-        if(stat(path.c_str(), &st)) {
-            ssassert(errno == ENOENT, "Unexpected stat() error");
-            ssassert(!resource_dir.empty(), "Expected local resource directory to be set");
-            path = resource_dir + "/" + name;
-            ssassert(!stat(path.c_str(), &st), "Cannot find resource");
-        }
-
-        std::vector<uint8_t> data(st.st_size);
-        FILE *f = ssfopen(path.c_str(), "rb");
-        ssassert(f != NULL, "Cannot open resource");
-        fread(&data[0], 1, st.st_size, f);
-        fclose(f);
-
-        cache.emplace(name, std::move(data));
-        it = cache.find(name);
-    }
-
-    *size = (*it).second.size();
-    return &(*it).second[0];
-}
-
 /* Space Navigator support */
 
 #ifdef HAVE_SPACEWARE
@@ -1587,12 +1535,7 @@ int main(int argc, char** argv) {
     gtk_disable_setlocale();
 
     /* Are we running from a build directory, as opposed to a global install? */
-    if(std::string(argv[0]).find('/') != std::string::npos) {
-        resource_dir = argv[0]; // .../src/solvespace
-        resource_dir.erase(resource_dir.rfind('/'));
-        resource_dir.erase(resource_dir.rfind('/'));
-        resource_dir += "/res"; // .../res
-    }
+    SetResourceDirFromExecutable(argv[0]);
 
     Gtk::Main main(argc, argv);
 
@@ -0,0 +1,131 @@
+//-----------------------------------------------------------------------------
+// The platform functions that the rest of the program expects, implemented
+// for the programs that run without any windows, so that they never block
+// waiting for a user.
+//-----------------------------------------------------------------------------
+#include <limits.h>
+#include <time.h>
+
+#include "solvespace.h"
+#include "config.h"
+#include "headless.h"
+
+namespace SolveSpace {
+
+static int errorCount = 0;
+
+int TakeHeadlessErrorCount() {
+    int count = errorCount;
+    errorCount = 0;
+    return count;
+}
+
+/* Settings */
+
+// We never read nor write the settings of the interactive program, so that
+// the output depends only on the model and the command line.
+void CnfFreezeInt(uint32_t, const std::string &) {}
+void CnfFreezeFloat(float, const std::string &) {}
+void CnfFreezeString(const std::string &, const std::string &) {}
+uint32_t CnfThawInt(uint32_t val, const std::string &) { return val; }
+float CnfThawFloat(float val, const std::string &) { return val; }
+std::string CnfThawString(const std::string &val, const std::string &) { return val; }
+
+/* Timers */
+
+int64_t GetMilliseconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return 1000 * (uint64_t) ts.tv_sec + ts.tv_nsec / 1000000;
+}
+
+void SetTimerFor(int) {}
+void SetAutosaveTimerFor(int) {}
+void ScheduleLater() {}
+
+/* Graphics window */
+
+// There is no window, but the view still determines the projection of the
+// 2d view exports, and the zoom determines the default chord tolerance.
+static const int GRAPHICS_WIDTH  = 1200;
+static const int GRAPHICS_HEIGHT = 900;
+
+void GetGraphicsWindowSize(int *w, int *h) {
+    *w = GRAPHICS_WIDTH;
+    *h = GRAPHICS_HEIGHT;
+}
+void InvalidateGraphics(void) {}
+void PaintGraphics(void) {}
+void SetCurrentFilename(const std::string &) {}
+void ToggleFullScreen(void) {}
+bool FullScreenIsActive(void) { return false; }
+void ShowGraphicsEditControl(int, int, int, int, const std::string &) {}
+void HideGraphicsEditControl(void) {}
+bool GraphicsEditControlIsVisible(void) { return false; }
+void ToggleMenuBar(void) {}
+bool MenuBarIsVisible(void) { return false; }
+void AddContextMenuItem(const char *, ContextCommand) {}
+void CreateContextSubmenu(void) {}
+ContextCommand ShowContextMenu(void) { return ContextCommand::CANCELLED; }
+void EnableMenuByCmd(Command, bool) {}
+void CheckMenuByCmd(Command, bool) {}
+void RadioMenuByCmd(Command, bool) {}
+void RefreshRecentMenus(void) {}
+
+/* Save/load */
+
+bool GetOpenFile(std::string *, const std::string &, const FileFilter []) {
+    return false;
+}
+bool GetSaveFile(std::string *, const std::string &, const FileFilter []) {
+    return false;
+}
+DialogChoice SaveFileYesNoCancel(void) {
+    return DIALOG_NO;
+}
+DialogChoice LoadAutosaveYesNo(void) {
+    return DIALOG_NO;
+}
+DialogChoice LocateImportedFileYesNoCancel(const std::string &filename,
+                                           bool canCancel) {
+    fprintf(stderr, "The linked file %s is not present.\n", filename.c_str());
+    return canCancel ? DIALOG_CANCEL : DIALOG_NO;
+}
+
+/* Text window */
+
+void ShowTextWindow(bool) {}
+void GetTextWindowSize(int *w, int *h) {
+    *w = 0;
+    *h = 0;
+}
+void InvalidateText(void) {}
+void MoveTextScrollbarTo(int, int, int) {}
+void SetMousePointerToHand(bool) {}
+void ShowTextEditControl(int, int, const std::string &) {}
+void HideTextEditControl(void) {}
+bool TextEditControlIsVisible(void) { return false; }
+
+/* Miscellanea */
+
+void DoMessageBox(const char *message, int, int, bool error) {
+    if(error) errorCount++;
+    fprintf(stderr, "%s: %s\n", error ? "error" : "message", message);
+}
+
+void OpenWebsite(const char *) {}
+
+void InitHeadless(const char *argv0) {
+    char executable[PATH_MAX];
+    if(std::string(argv0).find('/') != std::string::npos &&
+       realpath(argv0, executable)) {
+        SetResourceDirFromExecutable(executable);
+    }
+}
+
+/* Application lifecycle */
+
+void ExitNow(void) {}
+
+}
+
@@ -0,0 +1,20 @@
+//-----------------------------------------------------------------------------
+// The platform functions for the programs that run without any windows,
+// like the command-line interface and the benchmark harness.
+//-----------------------------------------------------------------------------
+#ifndef __HEADLESS_H
+#define __HEADLESS_H
+
+namespace SolveSpace {
+
+// Find the resources relative to the executable, if it was started from a
+// build directory, as opposed to a global install.
+void InitHeadless(const char *argv0);
+
+// Returns the number of errors reported through Error() since the last call;
+// an export that fails tells us only this way.
+int TakeHeadlessErrorCount();
+
+}
+
+#endif
@@ -7,17 +7,28 @@
 // Copyright 2008-2013 Jonathan Westhues.
 // Copyright 2013 Daniel Richard G. <skunk@iSKUNK.ORG>
 //-----------------------------------------------------------------------------
+#include <errno.h>
 #include <time.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <execinfo.h>
+#include <mutex>
+
+#if !defined(__APPLE__) && !defined(LIBRARY)
+#include <fontconfig/fontconfig.h>
+#endif
 
 #include "solvespace.h"
+#include "config.h"
 
 namespace SolveSpace {
 
 void dbp(const char *str, ...)
 {
     va_list f;
-    static char buf[1024*50];
+    static thread_local char buf[1024*50];
     va_start(f, str);
     vsnprintf(buf, sizeof(buf), str, f);
     va_end(f);
@@ -63,6 +74,117 @@ void ssremove(const std::string &filename)
     remove(filename.c_str());
 }
 
+bool ssstat(const std::string &filename, int64_t *mtime, int64_t *size)
+{
+    ssassert(filename.length() == strlen(filename.c_str()),
+             "Unexpected null byte in middle of a path");
+    struct stat st;
+    if(stat(filename.c_str(), &st)) return false;
+    *mtime = (int64_t)st.st_mtime;
+    *size  = (int64_t)st.st_size;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Map a whole file into memory, read-only. An empty file can't be mapped,
+// but we don't need to; it just gets an empty buffer.
+//-----------------------------------------------------------------------------
+const void *ssmmap(const std::string &filename, size_t *size)
+{
+    ssassert(filename.length() == strlen(filename.c_str()),
+             "Unexpected null byte in middle of a path");
+    int fd = open(filename.c_str(), O_RDONLY);
+    if(fd == -1) return NULL;
+
+    struct stat st;
+    if(fstat(fd, &st)) {
+        close(fd);
+        return NULL;
+    }
+    *size = (size_t)st.st_size;
+
+    void *data = (void *)"";
+    if(*size > 0) {
+        data = mmap(NULL, *size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if(data == MAP_FAILED) data = NULL;
+    }
+    close(fd);
+    return data;
+}
+
+void ssmunmap(const void *data, size_t size)
+{
+    if(size == 0) return;
+    munmap((void *)data, size);
+}
+
+#if !defined(__APPLE__) && !defined(LIBRARY)
+//-----------------------------------------------------------------------------
+// Fonts and resources, the same way for the GTK port as for the programs that
+// run without any windows; OS X has its own, from the application bundle.
+//-----------------------------------------------------------------------------
+std::vector<std::string> GetFontFiles() {
+    std::vector<std::string> fonts;
+
+    FcPattern   *pat = FcPatternCreate();
+    FcObjectSet *os  = FcObjectSetBuild(FC_FILE, (char *)0);
+    FcFontSet   *fs  = FcFontList(0, pat, os);
+
+    for(int i = 0; i < fs->nfont; i++) {
+        FcChar8 *filenameFC = FcPatternFormat(fs->fonts[i], (const FcChar8*) "%{file}");
+        std::string filename = (char*) filenameFC;
+        fonts.push_back(filename);
+        FcStrFree(filenameFC);
+    }
+
+    FcFontSetDestroy(fs);
+    FcObjectSetDestroy(os);
+    FcPatternDestroy(pat);
+
+    return fonts;
+}
+
+static std::string resource_dir;
+void SetResourceDirFromExecutable(const std::string &executable) {
+    if(executable.find('/') == std::string::npos) return;
+
+    resource_dir = executable; // .../src/solvespace
+    resource_dir.erase(resource_dir.rfind('/'));
+    resource_dir.erase(resource_dir.rfind('/'));
+    resource_dir += "/res"; // .../res
+}
+
+const void *LoadResource(const std::string &name, size_t *size) {
+    static std::map<std::string, std::vector<uint8_t>> cache;
+
+    auto it = cache.find(name);
+    if(it == cache.end()) {
+        struct stat st;
+        std::string path;
+
+        path = (UNIX_DATADIR "/") + name;
+        if(stat(path.c_str(), &st)) {
+            ssassert(errno == ENOENT, "Unexpected stat() error");
+            ssassert(!resource_dir.empty(), "Expected local resource directory to be set");
+            path = resource_dir + "/" + name;
+            ssassert(!stat(path.c_str(), &st), "Cannot find resource");
+        }
+
+        std::vector<uint8_t> data(st.st_size);
+        FILE *f = ssfopen(path.c_str(), "rb");
+        ssassert(f != NULL, "Cannot open resource");
+        fread(&data[0], 1, st.st_size, f);
+        fclose(f);
+
+        cache.emplace(name, std::move(data));
+        it = cache.find(name);
+    }
+
+    *size = (*it).second.size();
+    return &(*it).second[0];
+}
+#endif
+
 //-----------------------------------------------------------------------------
 // A separate heap, on which we allocate expressions. Maybe a bit faster,
 // since fragmentation is less of a concern, and it also makes it possible
@@ -78,22 +200,27 @@ typedef struct _AllocTempHeader {
 } AllocTempHeader;
 
 static AllocTempHeader *Head = NULL;
+// Surfaces get triangulated on worker threads, which allocate here too.
+static std::mutex HeadMutex;
 
 void *AllocTemporary(size_t n)
 {
     AllocTempHeader *h =
         (AllocTempHeader *)malloc(n + sizeof(AllocTempHeader));
+    memset(&h[1], 0, n);
+
+    std::lock_guard<std::mutex> lock(HeadMutex);
     h->prev = NULL;
     h->next = Head;
     if(Head) Head->prev = h;
     Head = h;
-    memset(&h[1], 0, n);
     return (void *)&h[1];
 }
 
 void FreeTemporary(void *p)
 {
     AllocTempHeader *h = (AllocTempHeader *)p - 1;
+    std::lock_guard<std::mutex> lock(HeadMutex);
     if(h->prev) {
         h->prev->next = h->next;
     } else {
@@ -105,6 +232,7 @@ void FreeTemporary(void *p)
 
 void FreeAllTemporary(void)
 {
+    std::lock_guard<std::mutex> lock(HeadMutex);
     AllocTempHeader *h = Head;
     while(h) {
         AllocTempHeader *f = h;
@@ -235,6 +235,9 @@ void SolveSpace::SetTimerFor(int milliseconds)
 
 void SolveSpace::ScheduleLater()
 {
+    // We call DoLater() after every message anyways, so there just needs to
+    // be a message; it's posted, since this may be called from any thread.
+    PostMessage(GraphicsWnd, WM_NULL, 0, 0);
 }
 
 static void CALLBACK AutosaveCallback(HWND hwnd, UINT msg, UINT_PTR id, DWORD time)
@@ -14,7 +14,7 @@ static HANDLE PermHeap, TempHeap;
 void dbp(const char *str, ...)
 {
     va_list f;
-    static char buf[1024*50];
+    static thread_local char buf[1024*50];
     va_start(f, str);
     _vsnprintf(buf, sizeof(buf), str, f);
     va_end(f);
@@ -100,6 +100,62 @@ void ssremove(const std::string &filename)
     _wremove(Widen(filename).c_str());
 }
 
+bool ssstat(const std::string &filename, int64_t *mtime, int64_t *size)
+{
+    ssassert(filename.length() == strlen(filename.c_str()),
+             "Unexpected null byte in middle of a path");
+    WIN32_FILE_ATTRIBUTE_DATA data;
+    if(!GetFileAttributesExW(Widen(filename).c_str(), GetFileExInfoStandard, &data))
+        return false;
+    *mtime = ((int64_t)data.ftLastWriteTime.dwHighDateTime << 32) |
+             data.ftLastWriteTime.dwLowDateTime;
+    *size  = ((int64_t)data.nFileSizeHigh << 32) | data.nFileSizeLow;
+    return true;
+}
+
+//-----------------------------------------------------------------------------
+// Map a whole file into memory, read-only. An empty file can't be mapped,
+// but we don't need to; it just gets an empty buffer.
+//-----------------------------------------------------------------------------
+const void *ssmmap(const std::string &filename, size_t *size)
+{
+    // Same as in ssfopen.
+    std::string uncFilename = filename;
+    if(uncFilename.substr(0, 2) != "\\\\")
+        uncFilename = "\\\\?\\" + uncFilename;
+
+    ssassert(filename.length() == strlen(filename.c_str()),
+             "Unexpected null byte in middle of a path");
+    HANDLE file = CreateFileW(Widen(uncFilename).c_str(), GENERIC_READ, FILE_SHARE_READ,
+                              NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if(file == INVALID_HANDLE_VALUE) return NULL;
+
+    LARGE_INTEGER fileSize;
+    if(!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        return NULL;
+    }
+    *size = (size_t)fileSize.QuadPart;
+    if(*size == 0) {
+        CloseHandle(file);
+        return "";
+    }
+
+    // The view keeps the mapping, and the mapping the file, open.
+    HANDLE mapping = CreateFileMappingW(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    CloseHandle(file);
+    if(mapping == NULL) return NULL;
+    const void *data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    return data;
+}
+
+void ssmunmap(const void *data, size_t size)
+{
+    if(size == 0) return;
+    UnmapViewOfFile(data);
+}
+
 //-----------------------------------------------------------------------------
 // A separate heap, on which we allocate expressions. Maybe a bit faster,
 // since no fragmentation issues whatsoever, and it also makes it possible
@@ -108,39 +164,41 @@ void ssremove(const std::string &filename)
 //-----------------------------------------------------------------------------
 void *AllocTemporary(size_t n)
 {
-    void *v = HeapAlloc(TempHeap, HEAP_NO_SERIALIZE | HEAP_ZERO_MEMORY, n);
+    void *v = HeapAlloc(TempHeap, HEAP_ZERO_MEMORY, n);
     ssassert(v != NULL, "Cannot allocate memory");
     return v;
 }
 void FreeTemporary(void *p) {
-    HeapFree(TempHeap, HEAP_NO_SERIALIZE, p);
+    HeapFree(TempHeap, 0, p);
 }
 void FreeAllTemporary()
 {
     if(TempHeap) HeapDestroy(TempHeap);
-    TempHeap = HeapCreate(HEAP_NO_SERIALIZE, 1024*1024*20, 0);
+    // Both heaps are serialized, since surfaces get triangulated on worker
+    // threads that allocate from them too.
+    TempHeap = HeapCreate(0, 1024*1024*20, 0);
     // This is a good place to validate, because it gets called fairly
     // often.
     vl();
 }
 
 void *MemAlloc(size_t n) {
-    void *p = HeapAlloc(PermHeap, HEAP_NO_SERIALIZE | HEAP_ZERO_MEMORY, n);
+    void *p = HeapAlloc(PermHeap, HEAP_ZERO_MEMORY, n);
     ssassert(p != NULL, "Cannot allocate memory");
     return p;
 }
 void MemFree(void *p) {
-    HeapFree(PermHeap, HEAP_NO_SERIALIZE, p);
+    HeapFree(PermHeap, 0, p);
 }
 
 void vl() {
-    ssassert(HeapValidate(TempHeap, HEAP_NO_SERIALIZE, NULL), "Corrupted heap");
-    ssassert(HeapValidate(PermHeap, HEAP_NO_SERIALIZE, NULL), "Corrupted heap");
+    ssassert(HeapValidate(TempHeap, 0, NULL), "Corrupted heap");
+    ssassert(HeapValidate(PermHeap, 0, NULL), "Corrupted heap");
 }
 
 void InitHeaps() {
     // Create the heap used for long-lived stuff (that gets freed piecewise).
-    PermHeap = HeapCreate(HEAP_NO_SERIALIZE, 1024*1024*20, 0);
+    PermHeap = HeapCreate(0, 1024*1024*20, 0);
     // Create the heap that we use to store Exprs and other temp stuff.
     FreeAllTemporary();
 }
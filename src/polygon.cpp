@@ -495,6 +495,72 @@ void SPointList::Add(Vector pt) {
     l.Add(&p);
 }
 
+// The cells are much bigger than the tolerance, so that a point's
+// neighborhood usually lies entirely within its own cell.
+static const double POINT_HASH_CELL = 100*LENGTH_EPS;
+
+uint64_t SPointHash::CellKey(int64_t i, int64_t j, int64_t k) {
+    // Distinct cells may collide, which just puts their points in the same
+    // chain; every candidate gets compared exactly anyways.
+    uint64_t h = (uint64_t)i * 0x9E3779B97F4A7C15ULL;
+    h ^= (uint64_t)j * 0xC2B2AE3D27D4EB4FULL + (h << 6) + (h >> 2);
+    h ^= (uint64_t)k * 0x165667B19E3779F9ULL + (h << 6) + (h >> 2);
+    return h;
+}
+
+void SPointHash::Clear() {
+    points.clear();
+    next.clear();
+    cells.clear();
+}
+
+int SPointHash::IndexForPoint(Vector pt) const {
+    // The tolerance is less than half a cell, so the point's neighborhood
+    // spans at most two cells along each axis. Return the lowest index that
+    // matches, as a linear search through the points would.
+    int64_t i0 = (int64_t)floor((pt.x - LENGTH_EPS) / POINT_HASH_CELL),
+            i1 = (int64_t)floor((pt.x + LENGTH_EPS) / POINT_HASH_CELL),
+            j0 = (int64_t)floor((pt.y - LENGTH_EPS) / POINT_HASH_CELL),
+            j1 = (int64_t)floor((pt.y + LENGTH_EPS) / POINT_HASH_CELL),
+            k0 = (int64_t)floor((pt.z - LENGTH_EPS) / POINT_HASH_CELL),
+            k1 = (int64_t)floor((pt.z + LENGTH_EPS) / POINT_HASH_CELL);
+
+    int best = -1;
+    for(int64_t i = i0; i <= i1; i++) {
+        for(int64_t j = j0; j <= j1; j++) {
+            for(int64_t k = k0; k <= k1; k++) {
+                auto it = cells.find(CellKey(i, j, k));
+                if(it == cells.end()) continue;
+                for(int idx = it->second; idx >= 0; idx = next[idx]) {
+                    if(best >= 0 && idx >= best) continue;
+                    if(pt.Equals(points[idx])) best = idx;
+                }
+            }
+        }
+    }
+    return best;
+}
+
+int SPointHash::IndexForPointOrAdd(Vector pt) {
+    int idx = IndexForPoint(pt);
+    if(idx >= 0) return idx;
+
+    idx = (int)points.size();
+    uint64_t key = CellKey((int64_t)floor(pt.x / POINT_HASH_CELL),
+                           (int64_t)floor(pt.y / POINT_HASH_CELL),
+                           (int64_t)floor(pt.z / POINT_HASH_CELL));
+    auto it = cells.find(key);
+    if(it == cells.end()) {
+        next.push_back(-1);
+        cells[key] = idx;
+    } else {
+        next.push_back(it->second);
+        it->second = idx;
+    }
+    points.push_back(pt);
+    return idx;
+}
+
 void SContour::AddPoint(Vector p) {
     SPoint sp;
     sp.tag = 0;
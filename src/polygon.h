@@ -112,6 +112,23 @@ public:
     void Add(Vector pt);
 };
 
+// Merges points that coincide to within LENGTH_EPS, the same test that
+// SPointList uses, but looks them up through a hash of their quantized
+// coordinates; so welding the vertices of a big mesh is linear, not
+// quadratic, in the number of points.
+class SPointHash {
+public:
+    std::vector<Vector>                 points;
+    std::vector<int>                    next;
+    std::unordered_map<uint64_t, int>   cells;
+
+    static uint64_t CellKey(int64_t i, int64_t j, int64_t k);
+
+    void Clear();
+    int IndexForPoint(Vector pt) const;
+    int IndexForPointOrAdd(Vector pt);
+};
+
 class SContour {
 public:
     int             tag;
@@ -131,9 +148,7 @@ public:
     void FindPointWithMinX();
     Vector AnyEdgeMidpoint() const;
 
-    bool IsEar(int bp, double scaledEps) const;
     bool BridgeToContour(SContour *sc, SEdgeList *el, List<Vector> *vl);
-    void ClipEarInto(SMesh *m, int bp, double scaledEps);
     void UvTriangulateInto(SMesh *m, SSurface *srf);
 };
 
@@ -258,6 +273,7 @@ public:
     void AddAgainstBsp(SMesh *srcm, SBsp3 *bsp3);
     void MakeFromUnionOf(SMesh *a, SMesh *b);
     void MakeFromDifferenceOf(SMesh *a, SMesh *b);
+    bool MakeFromCutBooleanOf(SMesh *a, SMesh *b, bool difference);
 
     void MakeFromCopyOf(SMesh *a);
     void MakeFromTransformationOf(SMesh *a, Vector trans,
@@ -269,8 +285,57 @@ public:
 
     bool IsEmpty() const;
     void RemapFaces(Group *g, int remap);
+    double CalculateVolume() const;
+    double InterferenceWith(SMesh *b, SEdgeList *el);
+};
+
+// A bounding volume hierarchy over the triangles of a mesh, so that we can
+// find the triangle under the mouse without projecting every one of them.
+class SMeshBvh {
+public:
+    enum { MAX_LEAF_TRIANGLES = 4 };
+
+    class Node {
+    public:
+        Vector  minp, maxp;
+        // A leaf owns count triangles, listed in tri starting at first;
+        // any other node has two children.
+        int     first, count;
+        int     child[2];
+    };
+
+    List<Node>  node;
+    List<int>   tri;
+
+    void Clear();
+    void Build(const SMesh *m);
+    int BuildNode(const SMesh *m, const Vector *centroid, int first, int count);
+    uint32_t FirstIntersectionWith(const SMesh *m, Point2d mp) const;
+    void TrianglesInBox(Vector minp, Vector maxp, std::vector<int> *l) const;
+    void TrianglesAlongRay(Vector p, Vector dir, std::vector<int> *l) const;
+};
 
-    uint32_t FirstIntersectionWith(Point2d mp) const;
+// The triangles of a mesh in the form that gl draws them from: vertices
+// shared between triangles wherever their normals agree, and runs of
+// triangles with the same color. These are built once when the mesh
+// changes, instead of sending every triangle again on every paint.
+class SMeshBuffers {
+public:
+    class Run {
+    public:
+        RgbaColor   color;
+        int         first;
+        int         count;
+    };
+
+    // The normal, then the position, of each vertex.
+    List<float>     vertex;
+    // Three vertices for each triangle, in the same order as the mesh.
+    List<uint32_t>  index;
+    List<Run>       run;
+
+    void Clear();
+    void Build(const SMesh *m);
 };
 
 // A linked list of triangles
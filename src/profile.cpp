@@ -0,0 +1,153 @@
+//-----------------------------------------------------------------------------
+// Accumulate the time spent in each phase of regenerating the sketch, per
+// group, and report it in the text window or in a file.
+//-----------------------------------------------------------------------------
+#include "solvespace.h"
+
+const char *Profiler::PhaseName(Phase phase) {
+    switch(phase) {
+        case Phase::NONE:        return "";
+        case Phase::REGENERATE:  return "regenerate";
+        case Phase::SOLVE:       return "solve";
+        case Phase::LOOPS:       return "loops";
+        case Phase::SHELL:       return "shell and mesh";
+        case Phase::BOOLEAN:     return "boolean";
+        case Phase::TRIANGULATE: return "triangulate";
+        case Phase::DISPLAY:     return "display items";
+    }
+    ssassert(false, "Unexpected profiler phase");
+}
+
+thread_local std::vector<Profiler::Phase> Profiler::stack;
+
+Profiler::Scope::Scope(Phase phase) : Scope(hGroup { 0 }, phase) {}
+
+Profiler::Scope::Scope(hGroup hg, Phase phase) : hg(hg), phase(phase) {
+    reentered = std::find(stack.begin(), stack.end(), phase) != stack.end();
+    if(reentered) return;
+
+    stack.push_back(phase);
+    start = std::chrono::steady_clock::now();
+}
+
+Profiler::Scope::~Scope() {
+    if(reentered) return;
+
+    std::chrono::duration<double, std::milli> time =
+        std::chrono::steady_clock::now() - start;
+
+    stack.pop_back();
+    Phase parent = stack.empty() ? Phase::NONE : stack.back();
+    ProfilerInUse->Add(hg, parent, phase, time.count());
+}
+
+void Profiler::Clear() {
+    // Any scopes in progress stay on the stack, and get added when they end.
+    std::lock_guard<std::mutex> lock(mutex);
+    entries.clear();
+}
+
+void Profiler::Add(hGroup hg, Phase parent, Phase phase, double time) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for(Entry &e : entries) {
+        if(e.group.v == hg.v && e.parent == parent && e.phase == phase) {
+            e.calls++;
+            e.time += time;
+            return;
+        }
+    }
+
+    Entry e = {};
+    e.group  = hg;
+    e.parent = parent;
+    e.phase  = phase;
+    e.calls  = 1;
+    e.time   = time;
+    entries.push_back(e);
+}
+
+void Profiler::AddFrom(const Profiler &other) {
+    std::vector<Entry> others;
+    {
+        std::lock_guard<std::mutex> lock(other.mutex);
+        others = other.entries;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for(const Entry &o : others) {
+        bool found = false;
+        for(Entry &e : entries) {
+            if(e.group.v == o.group.v && e.parent == o.parent && e.phase == o.phase) {
+                e.calls += o.calls;
+                e.time  += o.time;
+                found = true;
+                break;
+            }
+        }
+        if(!found) entries.push_back(o);
+    }
+}
+
+Profiler::Entry Profiler::TotalForGroup(hGroup hg, Phase phase) const {
+    Entry total = {};
+    total.group = hg;
+    total.phase = phase;
+    std::lock_guard<std::mutex> lock(mutex);
+    for(const Entry &e : entries) {
+        if(e.group.v != hg.v || e.phase != phase) continue;
+        total.calls += e.calls;
+        total.time  += e.time;
+    }
+    return total;
+}
+
+Profiler::Entry Profiler::TotalForPhase(Phase parent, Phase phase) const {
+    Entry total = {};
+    total.parent = parent;
+    total.phase  = phase;
+    std::lock_guard<std::mutex> lock(mutex);
+    for(const Entry &e : entries) {
+        if(e.parent != parent || e.phase != phase) continue;
+        total.calls += e.calls;
+        total.time  += e.time;
+    }
+    return total;
+}
+
+// A phase is never nested within itself, so we can add up all of its time.
+Profiler::Entry Profiler::TotalForPhase(Phase phase) const {
+    Entry total = {};
+    total.phase = phase;
+    std::lock_guard<std::mutex> lock(mutex);
+    for(const Entry &e : entries) {
+        if(e.phase != phase) continue;
+        total.calls += e.calls;
+        total.time  += e.time;
+    }
+    return total;
+}
+
+bool Profiler::DumpTo(const std::string &filename) const {
+    // Don't hold the lock while we write the file, or look up the groups.
+    std::vector<Entry> copy;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        copy = entries;
+    }
+
+    FILE *f = ssfopen(filename, "wb");
+    if(!f) return false;
+
+    fprintf(f, "group,parent,phase,calls,milliseconds\r\n");
+    for(const Entry &e : copy) {
+        std::string group;
+        Group *g = SK.group.FindByIdNoOops(e.group);
+        if(g) group = g->DescriptionString();
+        fprintf(f, "\"%s\",\"%s\",\"%s\",%d,%.3f\r\n",
+                group.c_str(), PhaseName(e.parent), PhaseName(e.phase),
+                e.calls, e.time);
+    }
+
+    fclose(f);
+    return true;
+}
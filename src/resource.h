@@ -16,6 +16,12 @@ class Pixmap;
 // the specified name does not exist.
 const void *LoadResource(const std::string &name, size_t *size);
 
+#if !defined(WIN32) && !defined(__APPLE__)
+// On other Unices, resources are looked for in the installed data directory,
+// and then in the build directory that holds the given executable, if any.
+void SetResourceDirFromExecutable(const std::string &executable);
+#endif
+
 std::string LoadString(const std::string &name);
 std::string LoadStringFromGzip(const std::string &name);
 Pixmap LoadPNG(const std::string &name);
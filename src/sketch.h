@@ -112,6 +112,71 @@ public:
     void Clear() {}
 };
 
+// The lines and points of one group's entities, in model coordinates, kept
+// from one paint to the next; moving the view just transforms the same
+// vertices again. They are built again after the sketch is regenerated, or
+// when the styles that they were built with have changed. Lines that must
+// face the viewer (fat lines, dots and freehand strokes), and entities that
+// aren't curves or points, are still drawn through their entities each time.
+class EntityDisplayCache {
+public:
+    // A run of lines from consecutive entities in the same style, and the
+    // pattern that they were broken into dashes with.
+    class Run {
+    public:
+        hStyle          hs;
+        bool            styled;
+        StipplePattern  stippleType;
+        double          stippleScale;
+        int             first;
+        int             count;
+    };
+
+    class Point {
+    public:
+        Vector          p;
+        bool            free;
+    };
+
+    bool            valid;
+    hGroup          activeGroup;
+    double          chordTol;
+
+    // The two ends of each line.
+    List<float>     vertex;
+    List<Run>       run;
+    List<Point>     point;
+    List<hEntity>   uncached;
+
+    void Clear();
+    bool IsStale(bool drawAsHidden) const;
+    void Generate(hGroup hg, bool drawAsHidden);
+    void DrawPoints() const;
+    void Draw(hGroup hg, bool drawAsHidden) const;
+};
+
+// A linked part in an assembly. It's held by reference to the shell that we
+// read from its file, along with the transformation that puts it in place;
+// the part's surfaces are copied only for something that needs all of them,
+// like a Boolean or an export.
+class PartInstance {
+public:
+    hGroup      group;
+    SShell      *shell;
+    Vector      offset;
+    Quaternion  q;
+    double      scale;
+};
+
+// One of the separate solids that make up the model: a linked part that we
+// hold as an instance, or a connected piece of the rest.
+class SolidBody {
+public:
+    std::string name;
+    SMesh       mesh;
+    Vector      minp, maxp;
+};
+
 // A set of requests. Every request must have an associated group.
 class Group {
 public:
@@ -188,17 +253,28 @@ public:
     }               polyError;
 
     bool            booleanFailed;
+    // We were asked to cut the meshes, but had to fall back to the BSP.
+    bool            meshCutFailed;
+    // Our shell and mesh are out of date, since the last time that we were
+    // solved; they're regenerated last, perhaps in the background.
+    bool            shellDirty;
 
     SShell          thisShell;
     SShell          runningShell;
+    // Linked parts that are assembled into runningShell, but not copied.
+    List<PartInstance> runningInstances;
 
     SMesh           thisMesh;
     SMesh           runningMesh;
 
     bool            displayDirty;
     SMesh           displayMesh;
+    SMeshBuffers    displayBuffers;
+    SMeshBvh        displayBvh;
     SEdgeList       displayEdges;
     SOutlineList    displayOutlines;
+    EntityDisplayCache displayEntities;
+    EntityDisplayCache displayHiddenEntities;
 
     enum class CombineAs : uint32_t {
         UNION           = 0,
@@ -208,6 +284,9 @@ public:
     CombineAs meshCombine;
 
     bool forceToMesh;
+    // Combine meshes by cutting them where they intersect, instead of with
+    // a BSP; we still fall back to the BSP if that fails.
+    bool cutMeshes;
 
     IdList<EntityMap,EntityId> remap;
     enum { REMAP_PRIME = 19477 };
@@ -215,9 +294,11 @@ public:
 
     std::string linkFile;
     std::string linkFileRel;
-    SMesh       impMesh;
-    SShell      impShell;
-    EntityList  impEntity;
+    // What we read from the linked file; that's shared with every group that
+    // links the same file, so it's not ours to change or free.
+    SMesh       *impMesh;
+    SShell      *impShell;
+    EntityList  *impEntity;
 
     std::string     name;
 
@@ -270,6 +351,10 @@ public:
     Group *PreviousGroup();
     Group *RunningMeshGroup();
     bool IsMeshGroup();
+    bool IsLinkedInstance();
+    PartInstance LinkedInstance();
+    SShell *GetRunningShell(SShell *assembled);
+    void MakeSolidBodiesInto(std::vector<SolidBody> *bodies);
     void GenerateShellAndMesh();
     template<class T> void GenerateForStepAndRepeat(T *steps, T *outs);
     template<class T> void GenerateForBoolean(T *a, T *b, T *o, Group::CombineAs how);
@@ -682,9 +767,14 @@ public:
         Point2d     mp;
         double      dmin;
         SEdgeList   *sel;
+        // The screen bounding box of everything that we measured the
+        // distance to, grown by as much as that distance was reduced.
+        BBox        screenBBox;
+        bool        hasScreenBBox;
     } dogd;
 
     double GetDistance(Point2d mp);
+    BBox GetScreenBBox(bool *hasBBox);
     Vector GetLabelPos();
     void GetReferencePos(Vector *refps);
     void Draw();
@@ -694,6 +784,7 @@ public:
     bool HasLabel() const;
 
     void LineDrawOrGetDistance(Vector a, Vector b);
+    void IncludeInScreenBBox(Point2d p, double r = 0.0);
     bool IsVisible() const;
     void DrawOrGetDistance(Vector *labelPos, Vector *refps);
     std::string Label() const;
@@ -8,7 +8,11 @@
 #include "config.h"
 
 SolveSpaceUI SolveSpace::SS = {};
-Sketch SolveSpace::SK = {};
+static Sketch TheSketch = {};
+thread_local Sketch       *SolveSpace::SketchInUse       = &TheSketch;
+thread_local Profiler     *SolveSpace::ProfilerInUse     = &SS.profiler;
+thread_local SEdgeList    *SolveSpace::NakedEdgesInUse   = &SS.nakedEdges;
+thread_local Regeneration *SolveSpace::RegenerationInUse = NULL;
 
 std::string SolveSpace::RecentFile[MAX_RECENT] = {};
 
@@ -146,6 +150,8 @@ bool SolveSpaceUI::OpenFile(const std::string &filename) {
 }
 
 void SolveSpaceUI::Exit() {
+    CancelRegeneration();
+
     // Recent files
     for(size_t i = 0; i < MAX_RECENT; i++)
         CnfFreezeString(RecentFile[i], "RecentFile_" + std::to_string(i));
@@ -240,6 +246,8 @@ void SolveSpaceUI::ScheduleShowTW() {
 
 void SolveSpaceUI::DoLater() {
     if(later.generateAll) GenerateAll();
+    // And if the shells and meshes are done regenerating, then show them.
+    FinishRegeneration();
     if(later.showTW) TW.Show();
     later = {};
 }
@@ -570,6 +578,8 @@ void SolveSpaceUI::MenuFile(Command id) {
 }
 
 void SolveSpaceUI::MenuAnalyze(Command id) {
+    // We'll need the shells and meshes for the sketch as it is now.
+    SS.FinishRegeneration(/*wait=*/true);
     SS.GW.GroupSelection();
 #define gs (SS.GW.gs)
 
@@ -621,8 +631,12 @@ void SolveSpaceUI::MenuAnalyze(Command id) {
                 "The mesh has naked edges (NOT okay, invalid)." :
                 "The mesh is watertight (okay, valid).";
 
+            int surfaces = g->runningShell.surface.n;
+            for(PartInstance &pi : g->runningInstances) {
+                surfaces += pi.shell->surface.n;
+            }
             std::string cntMsg = ssprintf("\n\nThe model contains %d triangles, from "
-                            "%d surfaces.", g->displayMesh.l.n, g->runningShell.surface.n);
+                            "%d surfaces.", g->displayMesh.l.n, surfaces);
 
             if(SS.nakedEdges.l.n == 0) {
                 Message("%s\n\n%s\n\nZero problematic edges, good.%s",
@@ -637,78 +651,84 @@ void SolveSpaceUI::MenuAnalyze(Command id) {
         case Command::INTERFERENCE: {
             SS.nakedEdges.Clear();
 
-            SMesh *m = &(SK.GetGroup(SS.GW.activeGroup)->displayMesh);
-            SKdNode *root = SKdNode::From(m);
-            bool inters, leaks;
-            root->MakeCertainEdgesInto(&(SS.nakedEdges),
-                EdgeKind::SELF_INTER, /*coplanarIsInter=*/false, &inters, &leaks);
+            Group *g = SK.GetGroup(SS.GW.activeGroup);
+            std::vector<SolidBody> bodies;
+            g->MakeSolidBodiesInto(&bodies);
+
+            // Only bodies whose bounding boxes overlap can interfere, so sweep
+            // across them in x to find those pairs.
+            std::vector<int> order(bodies.size());
+            for(size_t i = 0; i < bodies.size(); i++) order[i] = (int)i;
+            std::sort(order.begin(), order.end(), [&](int a, int b) {
+                return bodies[a].minp.x < bodies[b].minp.x;
+            });
+            std::vector<std::pair<int, int>> pairs;
+            for(size_t i = 0; i < order.size(); i++) {
+                SolidBody *ba = &bodies[order[i]];
+                for(size_t j = i + 1; j < order.size(); j++) {
+                    SolidBody *bb = &bodies[order[j]];
+                    if(bb->minp.x > ba->maxp.x + LENGTH_EPS) break;
+                    if(bb->minp.y > ba->maxp.y + LENGTH_EPS ||
+                       ba->minp.y > bb->maxp.y + LENGTH_EPS ||
+                       bb->minp.z > ba->maxp.z + LENGTH_EPS ||
+                       ba->minp.z > bb->maxp.z + LENGTH_EPS) continue;
+                    pairs.emplace_back(min(order[i], order[j]), max(order[i], order[j]));
+                }
+            }
+            std::sort(pairs.begin(), pairs.end());
+
+            std::vector<double> volume(pairs.size());
+            std::vector<SEdgeList> edges(pairs.size());
+            ParallelFor((int)pairs.size(), [&](int k) {
+                SolidBody *ba = &bodies[pairs[k].first],
+                          *bb = &bodies[pairs[k].second];
+                volume[k] = ba->mesh.InterferenceWith(&(bb->mesh), &edges[k]);
+            });
+            FreeAllTemporary();
+
+            // The volumes are found by subtraction, so allow a little error
+            // in them, relative to the size of the smaller body.
+            std::string msg;
+            int interfering = 0;
+            for(size_t k = 0; k < pairs.size(); k++) {
+                SolidBody *ba = &bodies[pairs[k].first],
+                          *bb = &bodies[pairs[k].second];
+                double smaller = min(fabs(ba->mesh.CalculateVolume()),
+                                     fabs(bb->mesh.CalculateVolume()));
+                if(volume[k] > 1e-6*smaller) {
+                    interfering++;
+                    msg += ssprintf("\n    %s and %s, by %.3f %s^3",
+                                    ba->name.c_str(), bb->name.c_str(),
+                                    volume[k] / pow(SS.MmPerUnit(), 3), SS.UnitName());
+                    for(const SEdge &se : edges[k].l) {
+                        SS.nakedEdges.AddEdge(se.a, se.b);
+                    }
+                }
+                edges[k].Clear();
+            }
+            for(SolidBody &body : bodies) {
+                body.mesh.Clear();
+            }
 
             InvalidateGraphics();
 
-            if(inters) {
-                Error("%d edges interfere with other triangles, bad.",
-                    SS.nakedEdges.l.n);
+            std::string cntMsg = ssprintf("\n\nThe model contains %d solid%s; "
+                            "%d pair%s of those could touch.",
+                            (int)bodies.size(), bodies.size() == 1 ? "" : "s",
+                            (int)pairs.size(), pairs.size() == 1 ? "" : "s");
+            if(interfering > 0) {
+                Error("%d pair%s of solids interfere, bad:\n%s%s",
+                    interfering, interfering == 1 ? "" : "s", msg.c_str(),
+                    cntMsg.c_str());
             } else {
-                Message("The assembly does not interfere, good.");
+                Message("The assembly does not interfere, good.%s", cntMsg.c_str());
             }
             break;
         }
 
         case Command::VOLUME: {
             SMesh *m = &(SK.GetGroup(SS.GW.activeGroup)->displayMesh);
-
-            double vol = 0;
-            int i;
-            for(i = 0; i < m->l.n; i++) {
-                STriangle tr = m->l.elem[i];
-
-                // Translate to place vertex A at (x, y, 0)
-                Vector trans = Vector::From(tr.a.x, tr.a.y, 0);
-                tr.a = (tr.a).Minus(trans);
-                tr.b = (tr.b).Minus(trans);
-                tr.c = (tr.c).Minus(trans);
-
-                // Rotate to place vertex B on the y-axis. Depending on
-                // whether the triangle is CW or CCW, C is either to the
-                // right or to the left of the y-axis. This handles the
-                // sign of our normal.
-                Vector u = Vector::From(-tr.b.y, tr.b.x, 0);
-                u = u.WithMagnitude(1);
-                Vector v = Vector::From(tr.b.x, tr.b.y, 0);
-                v = v.WithMagnitude(1);
-                Vector n = Vector::From(0, 0, 1);
-
-                tr.a = (tr.a).DotInToCsys(u, v, n);
-                tr.b = (tr.b).DotInToCsys(u, v, n);
-                tr.c = (tr.c).DotInToCsys(u, v, n);
-
-                n = tr.Normal().WithMagnitude(1);
-
-                // Triangles on edge don't contribute
-                if(fabs(n.z) < LENGTH_EPS) continue;
-
-                // The plane has equation p dot n = a dot n
-                double d = (tr.a).Dot(n);
-                // nx*x + ny*y + nz*z = d
-                // nz*z = d - nx*x - ny*y
-                double A = -n.x/n.z, B = -n.y/n.z, C = d/n.z;
-
-                double mac = tr.c.y/tr.c.x, mbc = (tr.c.y - tr.b.y)/tr.c.x;
-                double xc = tr.c.x, yb = tr.b.y;
-
-                // I asked Maple for
-                //    int(int(A*x + B*y +C, y=mac*x..(mbc*x + yb)), x=0..xc);
-                double integral =
-                    (1.0/3)*(
-                        A*(mbc-mac)+
-                        (1.0/2)*B*(mbc*mbc-mac*mac)
-                    )*(xc*xc*xc)+
-                    (1.0/2)*(A*yb+B*yb*mbc+C*(mbc-mac))*xc*xc+
-                    C*yb*xc+
-                    (1.0/2)*B*yb*yb*xc;
-
-                vol += integral;
-            }
+            double vol = m->CalculateVolume();
 
             std::string msg = ssprintf("The volume of the solid model is:\n\n""    %.3f %s^3",
                 vol / pow(SS.MmPerUnit(), 3),
@@ -822,6 +842,7 @@ void SolveSpaceUI::MenuHelp(Command id) {
 }
 
 void SolveSpaceUI::Clear() {
+    CancelRegeneration();
     sys.Clear();
     for(int i = 0; i < MAX_UNDO; i++) {
         if(i < undo.cnt) undo.d[i].Clear();
@@ -17,7 +17,11 @@
 #include <math.h>
 #include <limits.h>
 #include <algorithm>
+#include <chrono>
+#include <functional>
+#include <list>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <locale>
 #include <vector>
@@ -133,9 +137,10 @@ std::string Narrow(const std::wstring &s);
 std::wstring Widen(const std::string &s);
 #endif
 
-inline double Random(double vmax) {
-    return (vmax*rand()) / RAND_MAX;
-}
+// Pseudorandom numbers in [0, vmax]; after RestartRandom(), this thread gets
+// the same ones again, whatever other threads are doing.
+void RestartRandom();
+double Random(double vmax);
 
 class Expr;
 class ExprVector;
@@ -154,6 +159,9 @@ enum class ContextCommand : uint32_t;
 
 FILE *ssfopen(const std::string &filename, const char *mode);
 void ssremove(const std::string &filename);
+bool ssstat(const std::string &filename, int64_t *mtime, int64_t *size);
+const void *ssmmap(const std::string &filename, size_t *size);
+void ssmunmap(const void *data, size_t size);
 
 const size_t MAX_RECENT = 8;
 extern std::string RecentFile[MAX_RECENT];
@@ -275,6 +283,8 @@ void SetMousePointerToHand(bool yes);
 void DoMessageBox(const char *str, int rows, int cols, bool error);
 void SetTimerFor(int milliseconds);
 void SetAutosaveTimerFor(int minutes);
+// Arrange for SS.DoLater() to be called on the UI thread; this may be called
+// from any thread.
 void ScheduleLater();
 void ExitNow();
 
@@ -358,7 +368,7 @@ extern "C" { typedef void SSGL_CALLBACK ssglCallbackFptr(); }
 void ssglTesselatePolygon(GLUtesselator *gt, SPolygon *p);
 void ssglFillPolygon(SPolygon *p);
 void ssglFillMesh(bool useSpecColor, RgbaColor color,
-    SMesh *m, uint32_t h, uint32_t s1, uint32_t s2);
+    SMesh *m, SMeshBuffers *mb, uint32_t h, uint32_t s1, uint32_t s2);
 void ssglDebugPolygon(SPolygon *p);
 void ssglDrawEdges(SEdgeList *l, bool endpointsToo, hStyle hs);
 void ssglDrawOutlines(SOutlineList *l, Vector projDir, hStyle hs);
@@ -377,6 +387,9 @@ void ssglStippledLine(Vector a, Vector b, double width,
                       StipplePattern stippleType, double stippleScale, bool maybeFat);
 void ssglStippledLine(Vector a, Vector b, double width,
                       const char *stipplePattern, double stippleScale, bool maybeFat);
+void ssglStippledLine(Vector a, Vector b, StipplePattern stippleType, double stippleScale,
+                      ssglLineFn *fn, void *fndata);
+bool ssglStippleIsViewIndependent(StipplePattern stippleType);
 void ssglFatLine(Vector a, Vector b, double width);
 void ssglUnlockColor();
 void ssglColorRGB(RgbaColor rgb);
@@ -410,6 +423,15 @@ void CnfFreezeBool(bool v, const std::string &name);
 void CnfFreezeColor(RgbaColor v, const std::string &name);
 bool CnfThawBool(bool v, const std::string &name);
 RgbaColor CnfThawColor(RgbaColor v, const std::string &name);
+// Call fn(0) through fn(n-1) on a pool of worker threads, and return once
+// they have all finished. The calls may run concurrently, in any order.
+void ParallelFor(int n, const std::function<void(int)> &fn);
+// Whether the regeneration that this thread is doing has been superseded, so
+// that a long computation can give up early; its result won't be used.
+bool RegenerationCancelled();
+// Swap elements around into a pseudorandom order, by calling swapFn(k, n) for
+// n from count-1 down to 1; the same order each time, whichever thread asks.
+void ShuffleDeterministically(int count, const std::function<void(int, int)> &swapFn);
 
 class System {
 public:
@@ -692,6 +714,68 @@ public:
 #undef ENTITY
 #undef CONSTRAINT
 
+// Scoped timers around the phases of regenerating the sketch, which add up
+// how long each phase took for each group; so that the user can tell which
+// group, and which part of its regeneration, makes a model slow.
+class Profiler {
+public:
+    enum class Phase : uint32_t {
+        NONE            = 0,
+        REGENERATE      = 1,
+        SOLVE           = 2,
+        LOOPS           = 3,
+        SHELL           = 4,
+        BOOLEAN         = 5,
+        TRIANGULATE     = 6,
+        DISPLAY         = 7,
+        FIRST           = REGENERATE,
+        LAST            = DISPLAY
+    };
+    static const char *PhaseName(Phase phase);
+
+    // The time spent in one phase for one group, when nested directly within
+    // the given parent phase; it includes the time spent in its own nested
+    // phases. The phases that concern the whole sketch have a null group.
+    struct Entry {
+        hGroup      group;
+        Phase       parent;
+        Phase       phase;
+        int         calls;
+        double      time; // in milliseconds
+    };
+    std::vector<Entry>  entries;
+    // The threads of a parallel loop add their phases here too, so every
+    // access to the entries holds this.
+    mutable std::mutex  mutex;
+    // The phases in progress on this thread, innermost last; a worker thread
+    // starts each loop with those of the thread that it's working for.
+    static thread_local std::vector<Phase> stack;
+
+    class Scope {
+    public:
+        Scope(Phase phase);
+        Scope(hGroup hg, Phase phase);
+        ~Scope();
+
+        hGroup      hg;
+        Phase       phase;
+        // A phase that's already in progress isn't timed again when it's
+        // re-entered, or its time would get counted twice.
+        bool        reentered;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    void Clear();
+    void Add(hGroup hg, Phase parent, Phase phase, double time);
+    void AddFrom(const Profiler &other);
+    Entry TotalForGroup(hGroup hg, Phase phase) const;
+    Entry TotalForPhase(Phase parent, Phase phase) const;
+    Entry TotalForPhase(Phase phase) const;
+    bool DumpTo(const std::string &filename) const;
+};
+
+class Regeneration;
+
 class SolveSpaceUI {
 public:
     TextWindow                 *pTW;
@@ -821,16 +905,19 @@ public:
         void       *ptr;
     } SaveTable;
     static const SaveTable SAVED[];
-    void SaveUsingTable(int type);
-    void LoadUsingTable(char *key, char *val);
-    struct {
+    struct SaveVariables {
         Group        g;
         Request      r;
         Entity       e;
         Param        p;
         Constraint   c;
         Style        s;
-    } sv;
+    };
+    SaveVariables sv;
+    void SaveUsingTable(int type);
+    void LoadUsingTable(char *key, char *val);
+    static bool LoadUsingTable(const std::function<bool(char *, int)> &readLine,
+                               SaveVariables *sv, char *key, char *val);
     static void MenuFile(Command id);
 	bool Autosave();
     void RemoveAutosave();
@@ -843,8 +930,8 @@ public:
     bool SaveToFile(const std::string &filename);
     bool LoadAutosaveFor(const std::string &filename);
     bool LoadFromFile(const std::string &filename);
-    bool LoadEntitiesFromFile(const std::string &filename, EntityList *le,
-                              SMesh *m, SShell *sh);
+    static bool LoadEntitiesFromFile(const std::string &filename, EntityList *le,
+                                     SMesh *m, SShell *sh);
     bool ReloadAllImported(bool canCancel=false);
     // And the various export options
     void ExportAsPngTo(const std::string &filename);
@@ -897,6 +984,8 @@ public:
     };
     Clipboard clipboard;
 
+    Profiler profiler;
+
     void MarkGroupDirty(hGroup hg);
     void MarkGroupDirtyByEntity(hEntity he);
 
@@ -929,6 +1018,23 @@ public:
     void MarkDraggedParams();
     void ForceReferences();
 
+    // While something is dragged, we solve only the group that it's in, if
+    // nothing else is dirty; the rest of the regeneration waits until the
+    // drag ends, or the mouse stops for a moment.
+    static const int DRAG_PAUSE_MS = 250;
+    bool    solvedForDrag;
+    int64_t solvedForDragAt;
+    void GenerateForDrag();
+    void GenerateAfterDrag(bool onlyIfPaused);
+
+    // The shells and meshes are regenerated in the background, from a copy
+    // of the sketch, unless we need them right away; then the results are
+    // moved into the groups once that's finished.
+    Regeneration *regeneration;
+    void StartRegeneration();
+    void CancelRegeneration();
+    void FinishRegeneration(bool wait = false);
+
     bool ActiveGroupsOkay();
 
     // The system to be solved.
@@ -973,7 +1079,16 @@ void ImportDxf(const std::string &file);
 void ImportDwg(const std::string &file);
 
 extern SolveSpaceUI SS;
-extern Sketch SK;
+
+// The sketch, profiler and naked edges that the code running on this thread
+// works with; those are the ones that belong to the UI, except on a thread
+// that's regenerating a copy of the sketch in the background, or working on
+// a parallel loop for that thread. Likewise the regeneration, if any.
+extern thread_local Sketch       *SketchInUse;
+extern thread_local Profiler     *ProfilerInUse;
+extern thread_local SEdgeList    *NakedEdgesInUse;
+extern thread_local Regeneration *RegenerationInUse;
+#define SK (*SolveSpace::SketchInUse)
 
 }
 
@@ -281,10 +281,10 @@ static void DEBUGEDGELIST(SEdgeList *sel, SSurface *surf) {
         arrow = arrow.WithMagnitude(0.01);
         arrow = arrow.Plus(mid);
 
-        SS.nakedEdges.AddEdge(surf->PointAt(se->a.x, se->a.y),
-                              surf->PointAt(se->b.x, se->b.y));
-        SS.nakedEdges.AddEdge(surf->PointAt(mid.x, mid.y),
-                              surf->PointAt(arrow.x, arrow.y));
+        NakedEdgesInUse->AddEdge(surf->PointAt(se->a.x, se->a.y),
+                                 surf->PointAt(se->b.x, se->b.y));
+        NakedEdgesInUse->AddEdge(surf->PointAt(mid.x, mid.y),
+                                 surf->PointAt(arrow.x, arrow.y));
     }
 }
 
@@ -617,6 +617,10 @@ void SShell::CopySurfacesTrimAgainst(SShell *sha, SShell *shb, SShell *into, SSu
 void SShell::MakeIntersectionCurvesAgainst(SShell *agnst, SShell *into) {
     SSurface *sa;
     for(sa = surface.First(); sa; sa = surface.NextAfter(sa)) {
+        // This is where a Boolean spends most of its time, so check here
+        // whether it's still wanted; our caller checks again after.
+        if(RegenerationCancelled()) break;
+
         SSurface *sb;
         for(sb = agnst->surface.First(); sb; sb = agnst->surface.NextAfter(sb)){
             // Intersect every surface from our shell against every surface
@@ -697,9 +701,49 @@ void SShell::MakeFromAssemblyOf(SShell *a, SShell *b) {
     RewriteSurfaceHandlesForCurves(a, b);
 }
 
+//-----------------------------------------------------------------------------
+// Add a transformed copy of another shell's surfaces and curves to this one,
+// again with new handles. An assembly of many parts can be built up this way,
+// without copying all of the parts that it has so far for each new one.
+// The new handles aren't noted in the parts themselves, since a linked part
+// may be in use on another thread at the same time.
+//-----------------------------------------------------------------------------
+void SShell::AddTransformedCopyOf(SShell *a, Vector t, Quaternion q, double scale) {
+    int i;
+    std::vector<hSCurve> newCurve(a->curve.n);
+    for(i = 0; i < a->curve.n; i++) {
+        SCurve cn = SCurve::FromTransformationOf(&(a->curve.elem[i]), t, q, scale);
+        newCurve[i] = curve.AddAndAssignId(&cn);
+    }
+
+    std::vector<hSSurface> newSurface(a->surface.n);
+    for(i = 0; i < a->surface.n; i++) {
+        SSurface sn = SSurface::FromTransformationOf(&(a->surface.elem[i]), t, q, scale,
+                                                     /*includingTrims=*/true);
+        STrimBy *stb;
+        for(stb = sn.trim.First(); stb; stb = sn.trim.NextAfter(stb)) {
+            stb->curve = newCurve[a->curve.IndexOf(stb->curve)];
+        }
+        newSurface[i] = surface.AddAndAssignId(&sn);
+    }
+
+    for(i = 0; i < a->curve.n; i++) {
+        SCurve *c = &(a->curve.elem[i]),
+               *sc = curve.FindById(newCurve[i]);
+        sc->surfA = newSurface[a->surface.IndexOf(c->surfA)];
+        sc->surfB = newSurface[a->surface.IndexOf(c->surfB)];
+    }
+}
+
 void SShell::MakeFromBoolean(SShell *a, SShell *b, SSurface::CombineAs type) {
     booleanFailed = false;
 
+    // The pieces that the surfaces were split into for intersecting lines
+    // with them might be left over from an earlier regeneration, and so
+    // freed along with the rest of the temporary heap.
+    for(SSurface &ss : a->surface) ss.patch = NULL;
+    for(SSurface &ss : b->surface) ss.patch = NULL;
+
     a->MakeClassifyingBsps(NULL);
     b->MakeClassifyingBsps(NULL);
 
@@ -713,6 +757,17 @@ void SShell::MakeFromBoolean(SShell *a, SShell *b, SSurface::CombineAs type) {
     // the surfaces in B (which is all of the intersection curves).
     a->MakeIntersectionCurvesAgainst(b, this);
 
+    // If this regeneration has been superseded, then give up, and leave an
+    // empty shell; it won't be used anyways.
+    if(RegenerationCancelled()) {
+        a->CleanupAfterBoolean();
+        b->CleanupAfterBoolean();
+        a->bvh.Clear();
+        b->bvh.Clear();
+        Clear();
+        return;
+    }
+
     SCurve *sc;
     for(sc = curve.First(); sc; sc = curve.NextAfter(sc)) {
         SSurface *srfA = sc->GetSurfaceA(a, b),
@@ -743,9 +798,12 @@ void SShell::MakeFromBoolean(SShell *a, SShell *b, SSurface::CombineAs type) {
     // result.
     RewriteSurfaceHandlesForCurves(a, b);
 
-    // And clean up the piecewise linear things we made as a calculation aid
+    // And clean up the piecewise linear things we made as a calculation aid,
+    // and the hierarchies that we used to find surfaces along a line
     a->CleanupAfterBoolean();
     b->CleanupAfterBoolean();
+    a->bvh.Clear();
+    b->bvh.Clear();
 }
 
 //-----------------------------------------------------------------------------
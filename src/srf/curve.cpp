@@ -718,6 +718,22 @@ void SBezierLoopSetSet::AddOpenPath(SBezier *sb) {
     l.Add(&sbls);
 }
 
+void SBezierLoopSetSet::MakeFromCopyOf(SBezierLoopSetSet *src) {
+    for(SBezierLoopSet &sbls : src->l) {
+        SBezierLoopSet sblsn = sbls;
+        sblsn.l = {};
+        for(SBezierLoop &sbl : sbls.l) {
+            SBezierLoop sbln = sbl;
+            sbln.l = {};
+            for(SBezier &sb : sbl.l) {
+                sbln.l.Add(&sb);
+            }
+            sblsn.l.Add(&sbln);
+        }
+        l.Add(&sblsn);
+    }
+}
+
 void SBezierLoopSetSet::Clear() {
     SBezierLoopSet *sbls;
     for(sbls = l.First(); sbls; sbls = l.NextAfter(sbls)) {
@@ -387,6 +387,151 @@ Vector SSurface::NormalAt(double u, double v) const {
     return tu.Cross(tv);
 }
 
+//-----------------------------------------------------------------------------
+// Batched evaluation, for when we need the surface at many points at once,
+// like when triangulating. The basis functions of each degree are evaluated
+// together, once per parameter value instead of once per control point, and
+// the weighted control points are laid out as plain arrays; so the sums are
+// simple loops that the compiler can vectorize.
+//-----------------------------------------------------------------------------
+static void BernsteinBasis(int deg, double t, double *B, double *Bp) {
+    double s = 1 - t;
+    switch(deg) {
+        case 0:
+            B[0] = 1;
+            if(Bp) { Bp[0] = 0; }
+            return;
+
+        case 1:
+            B[0] = s;
+            B[1] = t;
+            if(Bp) { Bp[0] = -1; Bp[1] = 1; }
+            return;
+
+        case 2:
+            B[0] = s*s;
+            B[1] = 2*s*t;
+            B[2] = t*t;
+            if(Bp) { Bp[0] = -2*s; Bp[1] = 2 - 4*t; Bp[2] = 2*t; }
+            return;
+
+        case 3:
+            B[0] = s*s*s;
+            B[1] = 3*s*s*t;
+            B[2] = 3*s*t*t;
+            B[3] = t*t*t;
+            if(Bp) {
+                Bp[0] = -3*s*s;
+                Bp[1] = 3*s*s - 6*s*t;
+                Bp[2] = 6*s*t - 3*t*t;
+                Bp[3] = 3*t*t;
+            }
+            return;
+    }
+    ssassert(false, "Unexpected degree of spline");
+}
+
+// The control points in homogeneous coordinates, as (x*w, y*w, z*w, w); with
+// one array per coordinate, indexed by [i][j] like ctrl.
+struct HomogeneousCtrl {
+    double c[4][4][4];
+
+    HomogeneousCtrl(const SSurface *srf) {
+        for(int i = 0; i <= srf->degm; i++) {
+            for(int j = 0; j <= srf->degn; j++) {
+                double w = srf->weight[i][j];
+                c[0][i][j] = srf->ctrl[i][j].x*w;
+                c[1][i][j] = srf->ctrl[i][j].y*w;
+                c[2][i][j] = srf->ctrl[i][j].z*w;
+                c[3][i][j] = w;
+            }
+        }
+    }
+
+    // Sum along u with the given basis, giving one homogeneous point per j.
+    void SumAlongU(int degm, int degn, const double *B, double out[4][4]) const {
+        for(int k = 0; k < 4; k++) {
+            for(int j = 0; j <= degn; j++) {
+                double sum = 0;
+                for(int i = 0; i <= degm; i++) {
+                    sum += B[i]*c[k][i][j];
+                }
+                out[k][j] = sum;
+            }
+        }
+    }
+};
+
+static void SumAlongV(int degn, const double in[4][4], const double *B, double out[4]) {
+    for(int k = 0; k < 4; k++) {
+        double sum = 0;
+        for(int j = 0; j <= degn; j++) {
+            sum += B[j]*in[k][j];
+        }
+        out[k] = sum;
+    }
+}
+
+void SSurface::PointsAndNormalsAt(const Point2d *puv, int n,
+                                  Vector *points, Vector *normals) const
+{
+    HomogeneousCtrl hc(this);
+
+    for(int p = 0; p < n; p++) {
+        double Bu[4], Bup[4], Bv[4], Bvp[4];
+        BernsteinBasis(degm, puv[p].x, Bu, normals ? Bup : NULL);
+        BernsteinBasis(degn, puv[p].y, Bv, normals ? Bvp : NULL);
+
+        double row[4][4], num[4];
+        hc.SumAlongU(degm, degn, Bu, row);
+        SumAlongV(degn, row, Bv, num);
+
+        Vector pt = Vector::From(num[0], num[1], num[2]);
+        double den = num[3];
+        if(points) points[p] = pt.ScaledBy(1.0/den);
+        if(!normals) continue;
+
+        double rowu[4][4], num_u[4], num_v[4];
+        hc.SumAlongU(degm, degn, Bup, rowu);
+        SumAlongV(degn, rowu, Bv, num_u);
+        SumAlongV(degn, row, Bvp, num_v);
+
+        // quotient rule, as in TangentsAt
+        Vector tu = Vector::From(num_u[0], num_u[1], num_u[2]).ScaledBy(den).Minus(
+                    pt.ScaledBy(num_u[3])),
+               tv = Vector::From(num_v[0], num_v[1], num_v[2]).ScaledBy(den).Minus(
+                    pt.ScaledBy(num_v[3]));
+        tu = tu.ScaledBy(1.0/(den*den));
+        tv = tv.ScaledBy(1.0/(den*den));
+        normals[p] = tu.Cross(tv);
+    }
+}
+
+// Evaluate the points at every combination of nu values of u and nv of v;
+// the result for (us[i], vs[j]) goes in points[i*nv + j].
+void SSurface::PointsOnGrid(const double *us, int nu, const double *vs, int nv,
+                            Vector *points) const
+{
+    HomogeneousCtrl hc(this);
+
+    std::vector<double> Bv(nv*4);
+    for(int j = 0; j < nv; j++) {
+        BernsteinBasis(degn, vs[j], &Bv[j*4], NULL);
+    }
+
+    for(int i = 0; i < nu; i++) {
+        double Bu[4], row[4][4];
+        BernsteinBasis(degm, us[i], Bu, NULL);
+        hc.SumAlongU(degm, degn, Bu, row);
+
+        for(int j = 0; j < nv; j++) {
+            double num[4];
+            SumAlongV(degn, row, &Bv[j*4], num);
+            points[i*nv + j] = Vector::From(num[0], num[1], num[2]).ScaledBy(1.0/num[3]);
+        }
+    }
+}
+
 void SSurface::ClosestPointTo(Vector p, Point2d *puv, bool mustConverge) {
     ClosestPointTo(p, &(puv->x), &(puv->y), mustConverge);
 }
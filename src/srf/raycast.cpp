@@ -180,45 +180,58 @@ void SSurface::SplitInHalf(bool byU, SSurface *sa, SSurface *sb) {
     UnWeightControlPoints();
 }
 
+SPatch *SPatch::From(SSurface *srf) {
+    SPatch *sp = (SPatch *)AllocTemporary(sizeof(SPatch));
+    srf->GetAxisAlignedBounding(&(sp->amax), &(sp->amin));
+    if(srf->DepartureFromCoplanar() < 0.2*SS.ChordTolMm()) {
+        int degm = srf->degm, degn = srf->degn;
+        sp->flat = true;
+        sp->center = (srf->ctrl[0   ][0   ]).Plus(
+                      srf->ctrl[0   ][degn]).Plus(
+                      srf->ctrl[degm][0   ]).Plus(
+                      srf->ctrl[degm][degn]).ScaledBy(0.25);
+        FreeTemporary(srf);
+    } else {
+        sp->srf = srf;
+    }
+    return sp;
+}
+
 //-----------------------------------------------------------------------------
 // Find all points where the indicated finite (if segment) or infinite (if not
-// segment) line intersects our surface. Report them in uv space in the list.
-// We first do a bounding box check; if the line doesn't intersect, then we're
-// done. If it does, then we check how small our surface is. If it's big,
-// then we subdivide into quarters and recurse. If it's small, then we refine
+// segment) line intersects the original surface sorig, within this piece of
+// it. Report them in uv space in the list. We first do a bounding box check;
+// if the line doesn't intersect, then we're done. If it does, then we check
+// whether our piece is flat. If not, then we split it in half (if that wasn't
+// already done for some earlier line) and recurse. If it is, then we refine
 // by Newton's method and record the point.
 //-----------------------------------------------------------------------------
-void SSurface::AllPointsIntersectingUntrimmed(Vector a, Vector b,
-                                              int *cnt, int *level,
-                                              List<Inter> *l, bool asSegment,
-                                              SSurface *sorig)
+void SPatch::AllPointsIntersecting(Vector a, Vector b, int *cnt, int level,
+                                   List<SSurface::Inter> *l, bool asSegment,
+                                   SSurface *sorig)
 {
     // Test if the line intersects our axis-aligned bounding box; if no, then
-    // no possibility of an intersection
-    if(LineEntirelyOutsideBbox(a, b, asSegment)) return;
+    // no possibility of an intersection. The line segment could fail to
+    // intersect the bbox, but lie entirely within it and intersect the surface.
+    if(!Vector::BoundingBoxIntersectsLine(amax, amin, a, b, asSegment) &&
+       a.OutsideAndNotOn(amax, amin) && b.OutsideAndNotOn(amax, amin))
+    {
+        return;
+    }
 
     if(*cnt > 2000) {
-        dbp("!!! too many subdivisions (level=%d)!", *level);
-        dbp("degm = %d degn = %d", degm, degn);
+        dbp("!!! too many subdivisions (level=%d)!", level);
+        dbp("degm = %d degn = %d", sorig->degm, sorig->degn);
         return;
     }
     (*cnt)++;
 
-    // If we might intersect, and the surface is small, then switch to Newton
+    // If we might intersect, and the piece is flat, then switch to Newton
     // iterations.
-    if(DepartureFromCoplanar() < 0.2*SS.ChordTolMm()) {
-        Vector p = (ctrl[0   ][0   ]).Plus(
-                    ctrl[0   ][degn]).Plus(
-                    ctrl[degm][0   ]).Plus(
-                    ctrl[degm][degn]).ScaledBy(0.25);
-        Inter inter;
-        sorig->ClosestPointTo(p, &(inter.p.x), &(inter.p.y), /*mustConverge=*/false);
+    if(flat) {
+        SSurface::Inter inter;
+        sorig->ClosestPointTo(center, &(inter.p.x), &(inter.p.y), /*mustConverge=*/false);
         if(sorig->PointIntersectingLine(a, b, &(inter.p.x), &(inter.p.y))) {
-            Vector p = sorig->PointAt(inter.p.x, inter.p.y);
-            // Debug check, verify that the point lies in both surfaces
-            // (which it ought to, since the surfaces should be coincident)
-            double u, v;
-            ClosestPointTo(p, &u, &v);
             l->Add(&inter);
         } else {
             // Might not converge if line is almost tangent to surface...
@@ -226,15 +239,20 @@ void SSurface::AllPointsIntersectingUntrimmed(Vector a, Vector b,
         return;
     }
 
-    // But the surface is big, so split it, alternating by u and v
-    SSurface surf0, surf1;
-    SplitInHalf((*level & 1) == 0, &surf0, &surf1);
+    // But the piece is big, so split it, alternating by u and v
+    if(srf) {
+        SSurface *sa = (SSurface *)AllocTemporary(sizeof(SSurface)),
+                 *sb = (SSurface *)AllocTemporary(sizeof(SSurface));
+        srf->SplitInHalf((level & 1) == 0, sa, sb);
+        FreeTemporary(srf);
+        srf = NULL;
+
+        half[0] = SPatch::From(sa);
+        half[1] = SPatch::From(sb);
+    }
 
-    int nextLevel = (*level) + 1;
-    (*level) = nextLevel;
-    surf0.AllPointsIntersectingUntrimmed(a, b, cnt, level, l, asSegment, sorig);
-    (*level) = nextLevel;
-    surf1.AllPointsIntersectingUntrimmed(a, b, cnt, level, l, asSegment, sorig);
+    half[0]->AllPointsIntersecting(a, b, cnt, level + 1, l, asSegment, sorig);
+    half[1]->AllPointsIntersecting(a, b, cnt, level + 1, l, asSegment, sorig);
 }
 
 //-----------------------------------------------------------------------------
@@ -333,8 +351,13 @@ void SSurface::AllPointsIntersecting(Vector a, Vector b,
         }
     } else {
         // General numerical solution by subdivision, fallback
-        int cnt = 0, level = 0;
-        AllPointsIntersectingUntrimmed(a, b, &cnt, &level, &inters, asSegment, this);
+        if(!patch) {
+            SSurface *srf = (SSurface *)AllocTemporary(sizeof(SSurface));
+            *srf = *this;
+            patch = SPatch::From(srf);
+        }
+        int cnt = 0;
+        patch->AllPointsIntersecting(a, b, &cnt, /*level=*/0, &inters, asSegment, this);
     }
 
     // Remove duplicate intersection points
@@ -379,15 +402,132 @@ void SSurface::AllPointsIntersecting(Vector a, Vector b,
     inters.Clear();
 }
 
+void SShellBvh::Clear() {
+    node.Clear();
+    srf.Clear();
+}
+
+void SShellBvh::Build(const SShell *shell) {
+    Clear();
+    if(shell->surface.n == 0) return;
+
+    std::vector<Vector> amax, amin, center;
+    for(int i = 0; i < shell->surface.n; i++) {
+        Vector smax, smin;
+        shell->surface.elem[i].GetAxisAlignedBounding(&smax, &smin);
+        amax.push_back(smax);
+        amin.push_back(smin);
+        center.push_back((smax.Plus(smin)).ScaledBy(0.5));
+        srf.Add(&i);
+    }
+    BuildNode(&amax[0], &amin[0], &center[0], 0, shell->surface.n);
+}
+
+// Split the surfaces at the median of the centers of their bounding boxes,
+// along the axis in which those are spread the most, until few enough are
+// left for a leaf.
+int SShellBvh::BuildNode(const Vector *amax, const Vector *amin, const Vector *center,
+                         int first, int count) {
+    Node n = {};
+    n.first = first;
+    n.count = count;
+    n.amax = Vector::From(VERY_NEGATIVE, VERY_NEGATIVE, VERY_NEGATIVE);
+    n.amin = Vector::From(VERY_POSITIVE, VERY_POSITIVE, VERY_POSITIVE);
+    Vector cmax = n.amax,
+           cmin = n.amin;
+    for(int i = first; i < first + count; i++) {
+        int j = srf.elem[i];
+        amax[j].MakeMaxMin(&n.amax, &n.amin);
+        amin[j].MakeMaxMin(&n.amax, &n.amin);
+        center[j].MakeMaxMin(&cmax, &cmin);
+    }
+    // The bounding box tests have some slop, so make sure that a line that
+    // just passes the test for one surface passes it for the node too.
+    Vector eps = Vector::From(LENGTH_EPS, LENGTH_EPS, LENGTH_EPS);
+    n.amax = n.amax.Plus(eps);
+    n.amin = n.amin.Minus(eps);
+
+    int h = node.n;
+    node.Add(&n);
+    if(count <= MAX_LEAF_SURFACES) return h;
+
+    Vector extent = cmax.Minus(cmin);
+    int axis = (extent.x > extent.y) ? 0 : 1;
+    if(extent.z > extent.Element(axis)) axis = 2;
+
+    int half = count / 2;
+    std::nth_element(&srf.elem[first], &srf.elem[first + half], &srf.elem[first + count],
+        [&](int a, int b) {
+            return center[a].Element(axis) < center[b].Element(axis);
+        });
+
+    // The list of nodes may get reallocated as we recurse, so don't hold
+    // a pointer into it.
+    int left  = BuildNode(amax, amin, center, first, half),
+        right = BuildNode(amax, amin, center, first + half, count - half);
+    node.elem[h].count    = 0;
+    node.elem[h].child[0] = left;
+    node.elem[h].child[1] = right;
+    return h;
+}
+
+// Add the index of every surface whose node the line might intersect, in
+// no particular order; the caller still has to test each surface's own
+// bounding box.
+void SShellBvh::SurfacesNearLine(Vector a, Vector b, bool asSegment, List<int> *l) const {
+    if(node.n == 0) return;
+
+    std::vector<int> stack;
+    stack.push_back(0);
+    while(!stack.empty()) {
+        const Node *nd = &(node.elem[stack.back()]);
+        stack.pop_back();
+
+        if(!Vector::BoundingBoxIntersectsLine(nd->amax, nd->amin, a, b, asSegment) &&
+           a.OutsideAndNotOn(nd->amax, nd->amin) && b.OutsideAndNotOn(nd->amax, nd->amin))
+        {
+            continue;
+        }
+        if(nd->count == 0) {
+            stack.push_back(nd->child[0]);
+            stack.push_back(nd->child[1]);
+            continue;
+        }
+        for(int i = nd->first; i < nd->first + nd->count; i++) {
+            l->Add(&(srf.elem[i]));
+        }
+    }
+}
+
+//-----------------------------------------------------------------------------
+// Find the surfaces of our shell that the line might intersect, in the same
+// order as they appear in the shell, so that the results don't depend on
+// how the hierarchy happened to split them.
+//-----------------------------------------------------------------------------
+void SShell::SurfacesNearLine(Vector a, Vector b, bool asSegment, List<SSurface *> *l) {
+    if(bvh.node.n == 0) bvh.Build(this);
+
+    List<int> nearby = {};
+    bvh.SurfacesNearLine(a, b, asSegment, &nearby);
+    if(nearby.n > 0) std::sort(&nearby.elem[0], &nearby.elem[nearby.n]);
+    for(int i = 0; i < nearby.n; i++) {
+        SSurface *ss = &(surface.elem[nearby.elem[i]]);
+        l->Add(&ss);
+    }
+    nearby.Clear();
+}
+
 void SShell::AllPointsIntersecting(Vector a, Vector b,
                                    List<SInter> *il,
                                    bool asSegment, bool trimmed, bool inclTangent)
 {
-    SSurface *ss;
-    for(ss = surface.First(); ss; ss = surface.NextAfter(ss)) {
-        ss->AllPointsIntersecting(a, b, il,
+    List<SSurface *> nearby = {};
+    SurfacesNearLine(a, b, asSegment, &nearby);
+    for(int i = 0; i < nearby.n; i++) {
+        nearby.elem[i]->AllPointsIntersecting(a, b, il,
             asSegment, trimmed, inclTangent);
     }
+    nearby.Clear();
 }
 
 
@@ -428,13 +568,16 @@ bool SShell::ClassifyEdge(Class *indir, Class *outdir,
 {
     List<SInter> l = {};
 
-    srand(0);
+    RestartRandom();
 
     // First, check for edge-on-edge
     int edge_inters = 0;
     Vector inter_surf_n[2], inter_edge_n[2];
+    List<SSurface *> nearby = {};
+    SurfacesNearLine(ea, eb, /*asSegment=*/true, &nearby);
     SSurface *srf;
-    for(srf = surface.First(); srf; srf = surface.NextAfter(srf)) {
+    for(int i = 0; i < nearby.n; i++) {
+        srf = nearby.elem[i];
         if(srf->LineEntirelyOutsideBbox(ea, eb, /*asSegment=*/true)) continue;
 
         SEdgeList *sel = &(srf->edges);
@@ -463,6 +606,8 @@ bool SShell::ClassifyEdge(Class *indir, Class *outdir,
     }
 
     if(edge_inters == 2) {
+        nearby.Clear();
+
         // TODO, make this use the appropriate curved normals
         double dotp[2];
         for(int i = 0; i < 2; i++) {
@@ -519,7 +664,8 @@ bool SShell::ClassifyEdge(Class *indir, Class *outdir,
     // are on surface) and for numerical stability, so we don't pick up
     // the additional error from the line intersection.
 
-    for(srf = surface.First(); srf; srf = surface.NextAfter(srf)) {
+    for(int i = 0; i < nearby.n; i++) {
+        srf = nearby.elem[i];
         if(srf->LineEntirelyOutsideBbox(ea, eb, /*asSegment=*/true)) continue;
 
         Point2d puv;
@@ -541,8 +687,10 @@ bool SShell::ClassifyEdge(Class *indir, Class *outdir,
 
         *indir  = ClassifyRegion(edge_n_in,  surf_n_in,  surf_n);
         *outdir = ClassifyRegion(edge_n_out, surf_n_out, surf_n);
+        nearby.Clear();
         return true;
     }
+    nearby.Clear();
 
     // Edge is not on face or on edge; so it's either inside or outside
     // the shell, and we'll determine which by raycasting.
@@ -603,7 +751,7 @@ bool SShell::ClassifyEdge(Class *indir, Class *outdir,
         if(cnt++ > 5) {
             dbp("can't find a ray that doesn't hit on edge!");
             dbp("on edge = %d, edge_inters = %d", onEdge, edge_inters);
-            SS.nakedEdges.AddEdge(ea, eb);
+            NakedEdgesInUse->AddEdge(ea, eb);
             break;
         }
     }
@@ -420,16 +420,45 @@ void SSurface::TriangulateInto(SShell *shell, SMesh *sm) {
             poly.UvGridTriangulateInto(sm, this);
         }
 
+        // The triangles share most of their vertices, so find the distinct
+        // points in uv, and evaluate the surface at each of those just once.
+        int n = sm->l.n - start;
+        std::vector<Point2d> uv(3*n);
+        for(i = 0; i < n; i++) {
+            STriangle *st = &(sm->l.elem[start + i]);
+            uv[3*i + 0] = Point2d::From(st->a.x, st->a.y);
+            uv[3*i + 1] = Point2d::From(st->b.x, st->b.y);
+            uv[3*i + 2] = Point2d::From(st->c.x, st->c.y);
+        }
+        std::vector<int> order(3*n);
+        for(i = 0; i < 3*n; i++) order[i] = i;
+        std::sort(order.begin(), order.end(), [&](int a, int b) {
+            if(uv[a].x != uv[b].x) return uv[a].x < uv[b].x;
+            return uv[a].y < uv[b].y;
+        });
+        std::vector<Point2d> distinct;
+        std::vector<int> which(3*n);
+        for(i = 0; i < 3*n; i++) {
+            Point2d p = uv[order[i]];
+            if(distinct.empty() || !(distinct.back().x == p.x && distinct.back().y == p.y)) {
+                distinct.push_back(p);
+            }
+            which[order[i]] = (int)distinct.size() - 1;
+        }
+        std::vector<Vector> points(distinct.size()), normals(distinct.size());
+        PointsAndNormalsAt(distinct.data(), (int)distinct.size(),
+                           points.data(), normals.data());
+
         STriMeta meta = { face, color };
-        for(i = start; i < sm->l.n; i++) {
-            STriangle *st = &(sm->l.elem[i]);
+        for(i = 0; i < n; i++) {
+            STriangle *st = &(sm->l.elem[start + i]);
             st->meta = meta;
-            st->an = NormalAt(st->a.x, st->a.y);
-            st->bn = NormalAt(st->b.x, st->b.y);
-            st->cn = NormalAt(st->c.x, st->c.y);
-            st->a = PointAt(st->a.x, st->a.y);
-            st->b = PointAt(st->b.x, st->b.y);
-            st->c = PointAt(st->c.x, st->c.y);
+            st->an = normals[which[3*i + 0]];
+            st->bn = normals[which[3*i + 1]];
+            st->cn = normals[which[3*i + 2]];
+            st->a = points[which[3*i + 0]];
+            st->b = points[which[3*i + 1]];
+            st->c = points[which[3*i + 2]];
             // Works out that my chosen contour direction is inconsistent with
             // the triangle direction, sigh.
             st->FlipNormal();
@@ -448,6 +477,8 @@ void SSurface::TriangulateInto(SShell *shell, SMesh *sm) {
 // coordinates change, but trim curves are stored as xyz so nothing happens
 //-----------------------------------------------------------------------------
 void SSurface::Reverse() {
+    patch = NULL;
+
     int i, j;
     for(i = 0; i < (degm+1)/2; i++) {
         for(j = 0; j <= degn; j++) {
@@ -464,6 +495,8 @@ void SSurface::Reverse() {
 }
 
 void SSurface::ScaleSelfBy(double s) {
+    patch = NULL;
+
     int i, j;
     for(i = 0; i <= degm; i++) {
         for(j = 0; j <= degn; j++) {
@@ -850,10 +883,25 @@ void SShell::MakeSectionEdgesInto(Vector n, double d, SEdgeList *sel, SBezierLis
     }
 }
 
+//-----------------------------------------------------------------------------
+// Triangulate each surface into a mesh of its own; the surfaces don't depend
+// on each other, so we can do that on many threads at once. Then append the
+// meshes in surface order, so we get the same triangles however that went.
+// Once a background regeneration is cancelled, its mesh doesn't matter, so
+// we stop triangulating.
+//-----------------------------------------------------------------------------
 void SShell::TriangulateInto(SMesh *sm) {
-    SSurface *s;
-    for(s = surface.First(); s; s = surface.NextAfter(s)) {
-        s->TriangulateInto(this, sm);
+    std::vector<SMesh> meshes(surface.n);
+    ParallelFor(surface.n, [&](int i) {
+        if(RegenerationCancelled()) return;
+        surface.elem[i].TriangulateInto(this, &meshes[i]);
+    });
+
+    for(SMesh &m : meshes) {
+        for(const STriangle &tr : m.l) {
+            sm->AddTriangle(&tr);
+        }
+        m.Clear();
     }
 }
 
@@ -873,5 +921,7 @@ void SShell::Clear() {
         c->Clear();
     }
     curve.Clear();
+
+    bvh.Clear();
 }
 
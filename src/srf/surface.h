@@ -20,6 +20,7 @@ double BernsteinDerivative(int k, int deg, double t);
 
 class SSurface;
 class SCurvePt;
+class SPatch;
 
 // Utility data structure, a two-dimensional BSP to accelerate polygon
 // operations.
@@ -174,6 +175,7 @@ public:
                             bool *allCoplanar, Vector *notCoplanarAt,
                             SBezierList *openContours);
     void AddOpenPath(SBezier *sb);
+    void MakeFromCopyOf(SBezierLoopSetSet *src);
     void Clear();
 };
 
@@ -281,6 +283,10 @@ public:
     // a point into our surface.
     Point2d         cached;
 
+    // For intersecting lines with our surface, the pieces that we've split
+    // it into so far; on the temporary heap, like the bsp.
+    SPatch          *patch;
+
     static SSurface FromExtrusionOf(SBezier *spc, Vector t0, Vector t1);
     static SSurface FromRevolutionOf(SBezier *sb, Vector pt, Vector axis,
                                         double thetas, double thetaf);
@@ -318,10 +324,6 @@ public:
     void AllPointsIntersecting(Vector a, Vector b,
                                List<SInter> *l,
                                bool asSegment, bool trimmed, bool inclTangent);
-    void AllPointsIntersectingUntrimmed(Vector a, Vector b,
-                                        int *cnt, int *level,
-                                        List<Inter> *l, bool asSegment,
-                                        SSurface *sorig);
 
     void ClosestPointTo(Vector p, Point2d *puv, bool mustConverge=true);
     void ClosestPointTo(Vector p, double *u, double *v, bool mustConverge=true);
@@ -335,6 +337,10 @@ public:
     void TangentsAt(double u, double v, Vector *tu, Vector *tv) const;
     Vector NormalAt(Point2d puv) const;
     Vector NormalAt(double u, double v) const;
+    void PointsAndNormalsAt(const Point2d *puv, int n,
+                            Vector *points, Vector *normals) const;
+    void PointsOnGrid(const double *us, int nu, const double *vs, int nv,
+                      Vector *points) const;
     bool LineEntirelyOutsideBbox(Vector a, Vector b, bool asSegment) const;
     void GetAxisAlignedBounding(Vector *ptMax, Vector *ptMin) const;
     bool CoincidentWithPlane(Vector n, double d) const;
@@ -361,12 +367,61 @@ public:
     double ChordToleranceForEdge(Vector a, Vector b) const;
     void MakeTriangulationGridInto(List<double> *l, double vs, double vf,
                                     bool swapped) const;
-    Vector PointAtMaybeSwapped(double u, double v, bool swapped) const;
 
     void Reverse();
     void Clear();
 };
 
+// A piece of a surface, from splitting it in half alternately by u and v
+// until the pieces are flat enough that Newton's method will converge on
+// any intersection with a line. We keep the pieces once we've made them,
+// since we intersect many lines with the same surfaces during a Boolean;
+// but we split a piece only when some line first reaches its bounding box.
+class SPatch {
+public:
+    // The bounding box of our control points.
+    Vector      amax, amin;
+    bool        flat;
+    // For a flat piece, the average of its corners.
+    Vector      center;
+    // For a piece that isn't flat, the piece itself until we split it, and
+    // then the two halves.
+    SSurface    *srf;
+    SPatch      *half[2];
+
+    static SPatch *From(SSurface *srf);
+
+    void AllPointsIntersecting(Vector a, Vector b, int *cnt, int level,
+                               List<SSurface::Inter> *l, bool asSegment,
+                               SSurface *sorig);
+};
+
+// A bounding volume hierarchy over the surfaces of a shell, so that we can
+// find the surfaces that a line might intersect without testing the bounding
+// box of every one of them.
+class SShellBvh {
+public:
+    enum { MAX_LEAF_SURFACES = 4 };
+
+    class Node {
+    public:
+        Vector  amax, amin;
+        // A leaf owns count surfaces, listed in srf starting at first; any
+        // other node has two children.
+        int     first, count;
+        int     child[2];
+    };
+
+    List<Node>  node;
+    List<int>   srf;
+
+    void Clear();
+    void Build(const SShell *shell);
+    int BuildNode(const Vector *amax, const Vector *amin, const Vector *center,
+                  int first, int count);
+    void SurfacesNearLine(Vector a, Vector b, bool asSegment, List<int> *l) const;
+};
+
 class SShell {
 public:
     IdList<SCurve,hSCurve>      curve;
@@ -374,6 +429,10 @@ public:
 
     bool                        booleanFailed;
 
+    // Built the first time that we intersect a line with the shell during
+    // a Boolean, and discarded at the end of it.
+    SShellBvh                   bvh;
+
     void MakeFromExtrusionOf(SBezierLoopSet *sbls, Vector t0, Vector t1,
                              RgbaColor color);
     void MakeFromRevolutionOf(SBezierLoopSet *sbls, Vector pt, Vector axis,
@@ -386,6 +445,7 @@ public:
     void CopySurfacesTrimAgainst(SShell *sha, SShell *shb, SShell *into, SSurface::CombineAs type);
     void MakeIntersectionCurvesAgainst(SShell *against, SShell *into);
     void MakeClassifyingBsps(SShell *useCurvesFrom);
+    void SurfacesNearLine(Vector a, Vector b, bool asSegment, List<SSurface *> *l);
     void AllPointsIntersecting(Vector a, Vector b, List<SInter> *il,
                                 bool asSegment, bool trimmed, bool inclTangent);
     void MakeCoincidentEdgesInto(SSurface *proto, bool sameNormal,
@@ -415,6 +475,7 @@ public:
     void MakeFromTransformationOf(SShell *a,
                                   Vector trans, Quaternion q, double scale);
     void MakeFromAssemblyOf(SShell *a, SShell *b);
+    void AddTransformedCopyOf(SShell *a, Vector t, Quaternion q, double scale);
     void MergeCoincidentSurfaces();
 
     void TriangulateInto(SMesh *sm);
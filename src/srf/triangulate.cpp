@@ -213,14 +213,124 @@ haveEdge:
     return true;
 }
 
-bool SContour::IsEar(int bp, double scaledEps) const {
-    int ap = WRAP(bp-1, l.n),
-        cp = WRAP(bp+1, l.n);
+//-----------------------------------------------------------------------------
+// The state of an ear-clipping triangulation of one contour. Clipped points
+// stay where they are in the contour, and the points that are left are linked
+// in order through prev and next, so clipping an ear doesn't move anything.
+// An ear can only contain a point that isn't convex, so those are kept in a
+// grid in uv to test ears against; and the ears are kept sorted, in the order
+// that we want to clip them, so we never have to scan the contour for one.
+//-----------------------------------------------------------------------------
+class EarClipper {
+public:
+    SContour            *sc;
+    SSurface            *srf;
+    double              scaledEps;
+    // On a curved surface, an ear whose chord tolerance is better than this
+    // is as good as any other; we clip those in order around the contour.
+    double              goodChordTol;
+
+    int                 n;
+    int                 first, last;
+    std::vector<int>    prev, next;
+    std::vector<bool>   clipped;
+    std::vector<bool>   reflex, inGrid;
+    std::vector<double> chordTol;
+
+    std::set<int>                    goodEars;
+    std::set<std::pair<double, int>> otherEars;
+
+    Point2d             gridMin;
+    double              cellSize;
+    int                 gridW, gridH;
+    std::vector<std::vector<int>> grid;
+
+    void Init(SContour *sc, SSurface *srf, double scaledEps);
+    void CellFor(Vector p, int *i, int *j) const;
+    STriangle TriangleAt(int bp) const;
+    bool IsReflex(int bp) const;
+    bool IsEar(int bp) const;
+    void Update(int bp);
+    int NextEar(bool fromLast) const;
+    void ClipEarInto(SMesh *m, int bp);
+};
+
+void EarClipper::Init(SContour *sc, SSurface *srf, double scaledEps) {
+    this->sc = sc;
+    this->srf = srf;
+    this->scaledEps = scaledEps;
+    goodChordTol = (srf->degm == 1 && srf->degn == 1) ? VERY_POSITIVE :
+                                                        0.1*SS.ChordTolMm();
+
+    n = sc->l.n;
+    first = 0;
+    last = n - 1;
+    prev.resize(n);
+    next.resize(n);
+    int i;
+    for(i = 0; i < n; i++) {
+        prev[i] = WRAP(i - 1, n);
+        next[i] = WRAP(i + 1, n);
+    }
+    clipped.assign(n, false);
+    reflex.assign(n, false);
+    inGrid.assign(n, false);
+    chordTol.assign(n, 0);
+
+    // Size the grid for about one point per cell.
+    Vector maxv = sc->l.elem[0].p, minv = maxv;
+    for(i = 1; i < n; i++) {
+        (sc->l.elem[i].p).MakeMaxMin(&maxv, &minv);
+    }
+    double w = maxv.x - minv.x, h = maxv.y - minv.y;
+    gridMin = Point2d::From(minv.x, minv.y);
+    cellSize = max(sqrt(w*h/n), max(w, h)/n);
+    if(cellSize <= 0) cellSize = 1;
+    gridW = (int)(w/cellSize) + 1;
+    gridH = (int)(h/cellSize) + 1;
+    grid.assign(gridW*gridH, std::vector<int>());
+
+    // Every point that isn't convex must be in the grid before we test any
+    // ears against it.
+    for(i = 0; i < n; i++) {
+        sc->l.elem[i].ear = EarType::UNKNOWN;
+        reflex[i] = IsReflex(i);
+        if(reflex[i]) {
+            int gi, gj;
+            CellFor(sc->l.elem[i].p, &gi, &gj);
+            grid[gj*gridW + gi].push_back(i);
+            inGrid[i] = true;
+        }
+    }
+    for(i = 0; i < n; i++) {
+        Update(i);
+    }
+}
+
+void EarClipper::CellFor(Vector p, int *i, int *j) const {
+    *i = max(0, min(gridW - 1, (int)floor((p.x - gridMin.x)/cellSize)));
+    *j = max(0, min(gridH - 1, (int)floor((p.y - gridMin.y)/cellSize)));
+}
 
+STriangle EarClipper::TriangleAt(int bp) const {
     STriangle tr = {};
-    tr.a = l.elem[ap].p;
-    tr.b = l.elem[bp].p;
-    tr.c = l.elem[cp].p;
+    tr.a = sc->l.elem[prev[bp]].p;
+    tr.b = sc->l.elem[bp].p;
+    tr.c = sc->l.elem[next[bp]].p;
+    return tr;
+}
+
+bool EarClipper::IsReflex(int bp) const {
+    STriangle tr = TriangleAt(bp);
+    // Reflex, or between two collinear edges.
+    return (tr.Normal()).Dot(Vector::From(0, 0, -1)) < scaledEps;
+}
+
+bool EarClipper::IsEar(int bp) const {
+    int ap = prev[bp],
+        cp = next[bp];
+
+    STriangle tr = TriangleAt(bp);
 
     if((tr.a).Equals(tr.c)) {
         // This is two coincident and anti-parallel edges. Zero-area, so
@@ -229,46 +339,113 @@ bool SContour::IsEar(int bp, double scaledEps) const {
     }
 
     Vector n = Vector::From(0, 0, -1);
-    if((tr.Normal()).Dot(n) < scaledEps) {
+    if(reflex[bp]) {
         // This vertex is reflex, or between two collinear edges; either way,
         // it's not an ear.
         return false;
     }
 
-    // Accelerate with an axis-aligned bounding box test
     Vector maxv = tr.a, minv = tr.a;
     (tr.b).MakeMaxMin(&maxv, &minv);
     (tr.c).MakeMaxMin(&maxv, &minv);
 
-    int i;
-    for(i = 0; i < l.n; i++) {
-        if(i == ap || i == bp || i == cp) continue;
-
-        Vector p = l.elem[i].p;
-        if(p.OutsideAndNotOn(maxv, minv)) continue;
-
-        // A point on the edge of the triangle is considered to be inside,
-        // and therefore makes it a non-ear; but a point on the vertex is
-        // "outside", since that's necessary to make bridges work.
-        if(p.EqualsExactly(tr.a)) continue;
-        if(p.EqualsExactly(tr.b)) continue;
-        if(p.EqualsExactly(tr.c)) continue;
+    int i0, j0, i1, j1;
+    Vector eps = Vector::From(LENGTH_EPS, LENGTH_EPS, 0);
+    CellFor(minv.Minus(eps), &i0, &j0);
+    CellFor(maxv.Plus(eps), &i1, &j1);
 
-        if(tr.ContainsPointProjd(n, p)) {
-            return false;
+    int i, j;
+    for(i = i0; i <= i1; i++) {
+        for(j = j0; j <= j1; j++) {
+            for(int k : grid[j*gridW + i]) {
+                if(clipped[k] || !reflex[k]) continue;
+                if(k == ap || k == bp || k == cp) continue;
+
+                Vector p = sc->l.elem[k].p;
+                if(p.OutsideAndNotOn(maxv, minv)) continue;
+
+                // A point on the edge of the triangle is considered to be
+                // inside, and therefore makes it a non-ear; but a point on
+                // the vertex is "outside", since that's necessary to make
+                // bridges work.
+                if(p.EqualsExactly(tr.a)) continue;
+                if(p.EqualsExactly(tr.b)) continue;
+                if(p.EqualsExactly(tr.c)) continue;
+
+                if(tr.ContainsPointProjd(n, p)) {
+                    return false;
+                }
+            }
         }
     }
     return true;
 }
 
-void SContour::ClipEarInto(SMesh *m, int bp, double scaledEps) {
-    int ap = WRAP(bp-1, l.n),
-        cp = WRAP(bp+1, l.n);
+// Work out whether the point at bp is reflex and whether it's an ear, since
+// either may have changed when its neighbors did.
+void EarClipper::Update(int bp) {
+    SPoint *pt = &(sc->l.elem[bp]);
+    if(pt->ear == EarType::EAR) {
+        goodEars.erase(bp);
+        otherEars.erase(std::make_pair(chordTol[bp], bp));
+    }
+
+    reflex[bp] = IsReflex(bp);
+    if(reflex[bp] && !inGrid[bp]) {
+        int i, j;
+        CellFor(pt->p, &i, &j);
+        grid[j*gridW + i].push_back(bp);
+        inGrid[bp] = true;
+    }
+
+    if(!IsEar(bp)) {
+        pt->ear = EarType::NOT_EAR;
+        return;
+    }
+    pt->ear = EarType::EAR;
+    if(goodChordTol == VERY_POSITIVE) {
+        // This is a plane; any ear is a good ear.
+        goodEars.insert(bp);
+        return;
+    }
+    // If we are triangulating a curved surface, then try to clip ears that
+    // have a small chord tolerance from the surface.
+    chordTol[bp] = srf->ChordToleranceForEdge(sc->l.elem[prev[bp]].p,
+                                              sc->l.elem[next[bp]].p);
+    if(chordTol[bp] < goodChordTol) {
+        goodEars.insert(bp);
+    } else {
+        otherEars.insert(std::make_pair(chordTol[bp], bp));
+    }
+}
+
+// Pick the first good ear going around the contour, starting either from the
+// beginning or from the last point; or, if there's none, the ear with the
+// best chord tolerance, where ears within scaledEps of that count as ties and
+// go to the first one around the contour too. Returns -1 if there are no
+// ears at all.
+int EarClipper::NextEar(bool fromLast) const {
+    if(!goodEars.empty()) {
+        if(fromLast && *goodEars.rbegin() == last) return last;
+        return *goodEars.begin();
+    }
+    if(otherEars.empty()) return -1;
+
+    double bestChordTol = otherEars.begin()->first;
+    int bestEar = -1;
+    for(const auto &e : otherEars) {
+        if(e.first > bestChordTol + scaledEps) break;
+        if(fromLast && e.second == last) return last;
+        if(bestEar < 0 || e.second < bestEar) bestEar = e.second;
+    }
+    return bestEar;
+}
 
-    STriangle tr = {};
-    tr.a = l.elem[ap].p;
-    tr.b = l.elem[bp].p;
-    tr.c = l.elem[cp].p;
+void EarClipper::ClipEarInto(SMesh *m, int bp) {
+    int ap = prev[bp],
+        cp = next[bp];
+
+    STriangle tr = TriangleAt(bp);
     if(tr.Normal().MagSquared() < scaledEps*scaledEps) {
         // A vertex with more than two edges will cause us to generate
         // zero-area triangles, which must be culled.
@@ -276,14 +453,19 @@ void SContour::ClipEarInto(SMesh *m, int bp, double scaledEps) {
         m->AddTriangle(&tr);
     }
 
+    goodEars.erase(bp);
+    otherEars.erase(std::make_pair(chordTol[bp], bp));
+    clipped[bp] = true;
+    next[ap] = cp;
+    prev[cp] = ap;
+    if(bp == first) first = cp;
+    if(bp == last) last = ap;
+    n--;
+
     // By deleting the point at bp, we may change the ear-ness of the points
     // on either side.
-    l.elem[ap].ear = EarType::UNKNOWN;
-    l.elem[cp].ear = EarType::UNKNOWN;
-
-    l.ClearTags();
-    l.elem[bp].tag = 1;
-    l.RemoveTagged();
+    Update(ap);
+    Update(cp);
 }
 
 void SContour::UvTriangulateInto(SMesh *m, SSurface *srf) {
@@ -304,106 +486,78 @@ void SContour::UvTriangulateInto(SMesh *m, SSurface *srf) {
         }
     }
     l.RemoveTagged();
+    if(l.n < 3) return;
 
     // Now calculate the ear-ness of each vertex
-    for(i = 0; i < l.n; i++) {
-        (l.elem[i]).ear = IsEar(i, scaledEps) ? EarType::EAR : EarType::NOT_EAR;
-    }
+    EarClipper ec = {};
+    ec.Init(this, srf, scaledEps);
 
     bool toggle = false;
-    while(l.n > 3) {
-        // Some points may have changed ear-ness, so recalculate
-        for(i = 0; i < l.n; i++) {
-            if(l.elem[i].ear == EarType::UNKNOWN) {
-                (l.elem[i]).ear = IsEar(i, scaledEps) ?
-                                        EarType::EAR : EarType::NOT_EAR;
-            }
-        }
-
-        int bestEar = -1;
-        double bestChordTol = VERY_POSITIVE;
+    while(ec.n > 3) {
         // Alternate the starting position so we generate strip-like
         // triangulations instead of fan-like
         toggle = !toggle;
-        int offset = toggle ? -1 : 0;
-        for(i = 0; i < l.n; i++) {
-            int ear = WRAP(i+offset, l.n);
-            if(l.elem[ear].ear == EarType::EAR) {
-                if(srf->degm == 1 && srf->degn == 1) {
-                    // This is a plane; any ear is a good ear.
-                    bestEar = ear;
-                    break;
-                }
-                // If we are triangulating a curved surface, then try to
-                // clip ears that have a small chord tolerance from the
-                // surface.
-                Vector prev = l.elem[WRAP((i+offset-1), l.n)].p,
-                       next = l.elem[WRAP((i+offset+1), l.n)].p;
-                double tol = srf->ChordToleranceForEdge(prev, next);
-                if(tol < bestChordTol - scaledEps) {
-                    bestEar = ear;
-                    bestChordTol = tol;
-                }
-                if(bestChordTol < 0.1*SS.ChordTolMm()) {
-                    break;
-                }
-            }
-        }
+        int bestEar = ec.NextEar(/*fromLast=*/toggle);
         if(bestEar < 0) {
             dbp("couldn't find an ear! fail");
             return;
         }
-        ClipEarInto(m, bestEar, scaledEps);
+        ec.ClipEarInto(m, bestEar);
     }
 
-    ClipEarInto(m, 0, scaledEps); // add the last triangle
+    ec.ClipEarInto(m, ec.first); // add the last triangle
 }
 
 double SSurface::ChordToleranceForEdge(Vector a, Vector b) const {
-    Vector as = PointAt(a.x, a.y), bs = PointAt(b.x, b.y);
+    // The two endpoints, and three points evenly spaced between them.
+    Point2d puv[5];
+    Vector pts[5];
+    int i;
+    for(i = 0; i < 4; i++) {
+        Vector p = a.Plus((b.Minus(a)).ScaledBy(i/4.0));
+        puv[i] = Point2d::From(p.x, p.y);
+    }
+    puv[4] = Point2d::From(b.x, b.y);
+    PointsAndNormalsAt(puv, 5, pts, NULL);
 
+    Vector as = pts[0], bs = pts[4];
     double worst = VERY_NEGATIVE;
-    int i;
     for(i = 1; i <= 3; i++) {
-        Vector p  = a. Plus((b. Minus(a )).ScaledBy(i/4.0)),
-               ps = as.Plus((bs.Minus(as)).ScaledBy(i/4.0));
-
-        Vector pps = PointAt(p.x, p.y);
-        worst = max(worst, (pps.Minus(ps)).MagSquared());
+        Vector ps = as.Plus((bs.Minus(as)).ScaledBy(i/4.0));
+        worst = max(worst, (pts[i].Minus(ps)).MagSquared());
     }
     return sqrt(worst);
 }
 
-Vector SSurface::PointAtMaybeSwapped(double u, double v, bool swapped) const {
-    if(swapped) {
-        return PointAt(v, u);
-    } else {
-        return PointAt(u, v);
-    }
-}
-
 void SSurface::MakeTriangulationGridInto(List<double> *l, double vs, double vf,
                                          bool swapped) const
 {
     double worst = 0;
 
     // Try piecewise linearizing four curves, at u = 0, 1/3, 2/3, 1; choose
-    // the worst chord tolerance of any of those.
+    // the worst chord tolerance of any of those. All sixteen points lie on
+    // a grid, so evaluate them together.
+    double us[4] = { 0, 1/3.0, 2/3.0, 1 },
+           vm[4] = { vs, (2*vs + vf) / 3, (vs + 2*vf) / 3, vf };
+    Vector pts[16];
+    if(swapped) {
+        PointsOnGrid(vm, 4, us, 4, pts);
+    } else {
+        PointsOnGrid(us, 4, vm, 4, pts);
+    }
+
     int i;
     for(i = 0; i <= 3; i++) {
-        double u = i/3.0;
+        // The points along the curve at us[i], in the order of vm.
+        auto at = [&](int k) { return swapped ? pts[k*4 + i] : pts[i*4 + k]; };
 
         // This chord test should be identical to the one in SBezier::MakePwl
         // to make the piecewise linear edges line up with the grid more or
         // less.
-        Vector ps = PointAtMaybeSwapped(u, vs, swapped),
-               pf = PointAtMaybeSwapped(u, vf, swapped);
-
-        double vm1 = (2*vs + vf) / 3,
-               vm2 = (vs + 2*vf) / 3;
-
-        Vector pm1 = PointAtMaybeSwapped(u, vm1, swapped),
-               pm2 = PointAtMaybeSwapped(u, vm2, swapped);
+        Vector ps  = at(0),
+               pm1 = at(1),
+               pm2 = at(2),
+               pf  = at(3);
 
         worst = max(worst, pm1.DistanceToLine(ps, pf.Minus(ps)));
         worst = max(worst, pm2.DistanceToLine(ps, pf.Minus(ps)));
@@ -441,30 +595,109 @@ void SPolygon::UvGridTriangulateInto(SMesh *mesh, SSurface *srf) {
     // Now iterate over each quad in the grid. If it's outside the polygon,
     // or if it intersects the polygon, then we discard it. Otherwise we
     // generate two triangles in the mesh, and cut it out of our polygon.
+    //
+    // A trim edge can only cross the sides of a quad that its bounding box
+    // touches, so file each edge under those quads, and test each quad
+    // against just its own edges. The quads with no edges at all form
+    // connected regions that must lie entirely inside or entirely outside
+    // the polygon; so test just one point in each region, too.
     int i, j;
-    for(i = 0; i < (li.n - 1); i++) {
-        for(j = 0; j < (lj.n - 1); j++) {
-            double us = li.elem[i], uf = li.elem[i+1],
-                   vs = lj.elem[j], vf = lj.elem[j+1];
+    int ni = li.n - 1, nj = lj.n - 1;
+    std::vector<std::vector<int>> edgesIn(ni*nj);
+    auto firstCell = [](const List<double> &lines, double x) {
+        int k = (int)(std::lower_bound(lines.elem + 1, lines.elem + lines.n, x) -
+                      (lines.elem + 1));
+        return min(k, lines.n - 2);
+    };
+    auto lastCell = [](const List<double> &lines, double x) {
+        int k = (int)(std::upper_bound(lines.elem, lines.elem + lines.n - 1, x) -
+                      lines.elem) - 1;
+        return max(k, 0);
+    };
+    for(int k = 0; k < orig.l.n; k++) {
+        SEdge *se = &(orig.l.elem[k]);
+        double eps = 10*LENGTH_EPS;
+        int i0 = firstCell(li, min(se->a.x, se->b.x) - eps),
+            i1 = lastCell (li, max(se->a.x, se->b.x) + eps),
+            j0 = firstCell(lj, min(se->a.y, se->b.y) - eps),
+            j1 = lastCell (lj, max(se->a.y, se->b.y) + eps);
+        for(i = i0; i <= i1; i++) {
+            for(j = j0; j <= j1; j++) {
+                edgesIn[i*nj + j].push_back(k);
+            }
+        }
+    }
 
-            Vector a = Vector::From(us, vs, 0),
-                   b = Vector::From(us, vf, 0),
-                   c = Vector::From(uf, vf, 0),
-                   d = Vector::From(uf, vs, 0);
+    std::vector<int> region(ni*nj, -1);
+    std::vector<bool> regionInside;
+    std::vector<int> stack;
+    for(int cell = 0; cell < ni*nj; cell++) {
+        if(region[cell] >= 0 || !edgesIn[cell].empty()) continue;
+
+        int r = (int)regionInside.size();
+        Vector p = Vector::From(li.elem[cell / nj], lj.elem[cell % nj], 0);
+        regionInside.push_back(this->ContainsPoint(p));
+
+        region[cell] = r;
+        stack.push_back(cell);
+        while(!stack.empty()) {
+            int at = stack.back();
+            stack.pop_back();
+            int ai = at / nj, aj = at % nj;
+            int nbr[4][2] = { { ai-1, aj }, { ai+1, aj }, { ai, aj-1 }, { ai, aj+1 } };
+            for(auto &n : nbr) {
+                if(n[0] < 0 || n[0] >= ni || n[1] < 0 || n[1] >= nj) continue;
+                int next = n[0]*nj + n[1];
+                if(region[next] >= 0 || !edgesIn[next].empty()) continue;
+                region[next] = r;
+                stack.push_back(next);
+            }
+        }
+    }
 
-            if(orig.AnyEdgeCrossings(a, b, NULL) ||
-               orig.AnyEdgeCrossings(b, c, NULL) ||
-               orig.AnyEdgeCrossings(c, d, NULL) ||
-               orig.AnyEdgeCrossings(d, a, NULL))
-            {
+    std::vector<bool> keep(ni*nj, false);
+    for(i = 0; i < ni; i++) {
+        for(j = 0; j < nj; j++) {
+            int cell = i*nj + j;
+            if(region[cell] >= 0) {
+                keep[cell] = regionInside[region[cell]];
                 continue;
             }
 
+            Vector a = Vector::From(li.elem[i],   lj.elem[j],   0),
+                   b = Vector::From(li.elem[i],   lj.elem[j+1], 0),
+                   c = Vector::From(li.elem[i+1], lj.elem[j+1], 0),
+                   d = Vector::From(li.elem[i+1], lj.elem[j],   0);
+
+            bool crosses = false;
+            for(int k : edgesIn[cell]) {
+                SEdge *se = &(orig.l.elem[k]);
+                if(se->EdgeCrosses(a, b) || se->EdgeCrosses(b, c) ||
+                   se->EdgeCrosses(c, d) || se->EdgeCrosses(d, a))
+                {
+                    crosses = true;
+                    break;
+                }
+            }
+            if(crosses) continue;
+
             // There's no intersections, so it doesn't matter which point
             // we decide to test.
-            if(!this->ContainsPoint(a)) {
-                continue;
-            }
+            keep[cell] = this->ContainsPoint(a);
+        }
+    }
+
+    for(i = 0; i < ni; i++) {
+        for(j = 0; j < nj; j++) {
+            if(!keep[i*nj + j]) continue;
+
+            double us = li.elem[i], uf = li.elem[i+1],
+                   vs = lj.elem[j], vf = lj.elem[j+1];
+
+            Vector a = Vector::From(us, vs, 0),
+                   b = Vector::From(us, vf, 0),
+                   c = Vector::From(uf, vf, 0),
+                   d = Vector::From(uf, vs, 0);
 
             // Add the quad to our mesh
             STriangle tr = {};
@@ -477,10 +710,12 @@ void SPolygon::UvGridTriangulateInto(SMesh *mesh, SSurface *srf) {
             tr.c = d;
             mesh->AddTriangle(&tr);
 
-            holes.AddEdge(a, b);
-            holes.AddEdge(b, c);
-            holes.AddEdge(c, d);
-            holes.AddEdge(d, a);
+            // and cut it out of our polygon, except where it meets another
+            // quad that we're cutting out too.
+            if(i == 0      || !keep[(i-1)*nj + j]) holes.AddEdge(a, b);
+            if(j == nj - 1 || !keep[i*nj + j+1])   holes.AddEdge(b, c);
+            if(i == ni - 1 || !keep[(i+1)*nj + j]) holes.AddEdge(c, d);
+            if(j == 0      || !keep[i*nj + j-1])   holes.AddEdge(d, a);
         }
     }
 
@@ -140,6 +140,8 @@ void TextWindow::ShowListOfGroups() {
         &(TextWindow::ScreenShowListOfStyles),
         &(TextWindow::ScreenShowEditView),
         &(TextWindow::ScreenShowConfiguration));
+    Printf(false, "  %Fl%Ls%fregeneration profile%E",
+        &(TextWindow::ScreenShowProfile));
 }
 
 
@@ -214,6 +216,8 @@ void TextWindow::ScreenChangeGroupOption(int link, uint32_t v) {
         case 'd': g->allDimsReference = !(g->allDimsReference); break;
 
         case 'f': g->forceToMesh = !(g->forceToMesh); break;
+
+        case 'm': g->cutMeshes = !(g->cutMeshes); break;
     }
 
     SS.MarkGroupDirty(g->h);
@@ -394,13 +398,19 @@ void TextWindow::ShowGroupInfo() {
         g->visible ? CHECK_TRUE : CHECK_FALSE);
 
     Group *pg; pg = g->PreviousGroup();
-    if(pg && pg->runningMesh.IsEmpty() && g->thisMesh.IsEmpty()) {
+    bool canBeNurbs; canBeNurbs = pg && pg->runningMesh.IsEmpty() && g->thisMesh.IsEmpty();
+    if(canBeNurbs) {
         Printf(false, " %f%Lf%Fd%s  force NURBS surfaces to triangle mesh",
             &TextWindow::ScreenChangeGroupOption,
             g->forceToMesh ? CHECK_TRUE : CHECK_FALSE);
     } else {
         Printf(false, " (model already forced to triangle mesh)");
     }
+    if(g->forceToMesh || !canBeNurbs) {
+        Printf(false, " %f%Lm%Fd%s  cut meshes where they intersect, not by BSP",
+            &TextWindow::ScreenChangeGroupOption,
+            g->cutMeshes ? CHECK_TRUE : CHECK_FALSE);
+    }
 
     Printf(true, " %f%Lr%Fd%s  relax constraints and dimensions",
         &TextWindow::ScreenChangeGroupOption,
@@ -420,6 +430,12 @@ void TextWindow::ShowGroupInfo() {
         Printf(false, "possible to fix the problem by choosing ");
         Printf(false, "'force NURBS surfaces to triangle mesh'.");
     }
+    if(g->meshCutFailed) {
+        Printf(false, "");
+        Printf(false, "The meshes couldn't be cut where they ");
+        Printf(false, "intersect, so they were combined by BSP ");
+        Printf(false, "instead.");
+    }
 
 list_items:
     Printf(false, "");
@@ -530,6 +546,87 @@ void TextWindow::ShowGroupSolveInfo() {
     }
 }
 
+//-----------------------------------------------------------------------------
+// The screen that shows how long each phase of regeneration took, added up
+// over every regeneration since the profile was last reset; first as a tree
+// of the phases nested within each other, and then for each group.
+//-----------------------------------------------------------------------------
+void TextWindow::ScreenShowProfile(int link, uint32_t v) {
+    SS.TW.GoToScreen(Screen::PROFILE);
+}
+void TextWindow::ScreenResetProfile(int link, uint32_t v) {
+    SS.profiler.Clear();
+}
+void TextWindow::ScreenSaveProfile(int link, uint32_t v) {
+    std::string exportFile;
+    if(!GetSaveFile(&exportFile, "", CsvFileFilter)) return;
+
+    if(!SS.profiler.DumpTo(exportFile)) {
+        Error("Couldn't write to '%s'", exportFile.c_str());
+    }
+}
+static void ShowProfilePhases(TextWindow *tw, Profiler::Phase parent, int depth, int *row) {
+    // The same phase may be nested within different parents, so limit the
+    // depth in case those ever form a loop.
+    if(depth > (int)Profiler::Phase::LAST) return;
+
+    for(uint32_t p = (uint32_t)Profiler::Phase::FIRST;
+        p <= (uint32_t)Profiler::Phase::LAST; p++)
+    {
+        Profiler::Entry e = SS.profiler.TotalForPhase(parent, (Profiler::Phase)p);
+        if(e.calls == 0) continue;
+
+        std::string name = std::string(2 * depth, ' ') + Profiler::PhaseName(e.phase);
+        tw->Printf(false, "%Bp %s", (*row & 1) ? 'd' : 'a',
+            ssprintf("%-24s%7d%11.1f", name.c_str(), e.calls, e.time).c_str());
+        (*row)++;
+
+        ShowProfilePhases(tw, e.phase, depth + 1, row);
+    }
+}
+void TextWindow::ShowProfile() {
+    Printf(true, "%FtREGENERATION PROFILE%E (time in ms)");
+
+    Printf(true, "%Ft phase                     calls       time%E");
+    int row = 0;
+    ShowProfilePhases(this, Profiler::Phase::NONE, 0, &row);
+    if(row == 0) {
+        Printf(false, "%Ba   (nothing regenerated yet)");
+    }
+
+    Printf(true, "%Ft group             solve  loops  shell   disp%E");
+    row = 0;
+    for(int i = 0; i < SK.groupOrder.n; i++) {
+        Group *g = SK.GetGroup(SK.groupOrder.elem[i]);
+
+        double time[4] = {};
+        const Profiler::Phase phases[4] = {
+            Profiler::Phase::SOLVE, Profiler::Phase::LOOPS,
+            Profiler::Phase::SHELL, Profiler::Phase::DISPLAY,
+        };
+        bool any = false;
+        for(int j = 0; j < 4; j++) {
+            Profiler::Entry e = SS.profiler.TotalForGroup(g->h, phases[j]);
+            time[j] = e.time;
+            if(e.calls > 0) any = true;
+        }
+        if(!any) continue;
+
+        std::string name = g->DescriptionString();
+        if(name.length() > 16) name = name.substr(0, 15) + "~";
+        Printf(false, "%Bp %Fl%Ll%D%f%s%E%s",
+            (row & 1) ? 'd' : 'a',
+            g->h.v, (&TextWindow::ScreenSelectGroup), name.c_str(),
+            ssprintf("%*s%7.1f%7.1f%7.1f%7.1f", 16 - (int)name.length(), "",
+                     time[0], time[1], time[2], time[3]).c_str());
+        row++;
+    }
+
+    Printf(true, "  %Fl%Ll%freset%E / %Fl%Ll%fsave as CSV%E",
+        &(TextWindow::ScreenResetProfile),
+        &(TextWindow::ScreenSaveProfile));
+}
+
 //-----------------------------------------------------------------------------
 // When we're stepping a dimension. User specifies the finish value, and
 // how many steps to take in between current and finish, re-solving each
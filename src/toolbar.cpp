@@ -248,6 +248,10 @@ bool GraphicsWindow::ToolbarDrawOrHitTest(int mx, int my,
 }
 
 void GraphicsWindow::TimerCallback() {
+    // The same timer tells us when the mouse has stopped during a drag.
+    SS.GenerateAfterDrag(/*onlyIfPaused=*/true);
+
+    if(SS.GW.toolbarTooltipped == SS.GW.toolbarHovered) return;
     SS.GW.toolbarTooltipped = SS.GW.toolbarHovered;
     PaintGraphics();
 }
@@ -41,10 +41,6 @@ extern "C" const char *ft_error_string(int err) {
 
 #include "solvespace.h"
 
-//-----------------------------------------------------------------------------
-// Get the list of available font filenames, and load the name for each of
-// them. Only that, though, not the glyphs too.
-//-----------------------------------------------------------------------------
 TtfFontList::TtfFontList() {
     FT_Init_FreeType(&fontLibrary);
 }
@@ -53,19 +49,112 @@ TtfFontList::~TtfFontList() {
     FT_Done_FreeType(fontLibrary);
 }
 
+//-----------------------------------------------------------------------------
+// The names of the fonts are remembered between runs, along with the
+// modification time and size of the file they came from, since opening
+// every font on the system just to read its name takes a while. Fonts that
+// couldn't be loaded are remembered too, with an empty name.
+//-----------------------------------------------------------------------------
+struct FontIndexEntry {
+    int64_t     mtime;
+    int64_t     size;
+    std::string name;
+};
+
+static std::map<std::string, FontIndexEntry> ReadFontIndex() {
+    std::map<std::string, FontIndexEntry> index;
+
+    std::string data = CnfThawString("", "FontIndex");
+    size_t pos = 0;
+    while(pos < data.size()) {
+        size_t eol = data.find('\n', pos);
+        if(eol == std::string::npos) eol = data.size();
+        std::string line = data.substr(pos, eol - pos);
+        pos = eol + 1;
+
+        // mtime, size, filename and font name, separated by tabs
+        long long mtime, size;
+        int start;
+        if(sscanf(line.c_str(), "%lld\t%lld\t%n", &mtime, &size, &start) != 2) continue;
+        size_t tab = line.find('\t', start);
+        if(tab == std::string::npos) continue;
+
+        FontIndexEntry *fie = &index[line.substr(start, tab - start)];
+        fie->mtime = mtime;
+        fie->size  = size;
+        fie->name  = line.substr(tab + 1);
+    }
+    return index;
+}
+
+static void WriteFontIndex(const std::map<std::string, FontIndexEntry> &index) {
+    std::string data;
+    for(const auto &it : index) {
+        const std::string &fontFile = it.first;
+        const FontIndexEntry &fie = it.second;
+        if(fontFile.find_first_of("\t\n") != std::string::npos ||
+           fie.name.find('\n') != std::string::npos) continue;
+
+        data += ssprintf("%lld\t%lld\t", (long long)fie.mtime, (long long)fie.size);
+        data += fontFile + "\t" + fie.name + "\n";
+    }
+    CnfFreezeString(data, "FontIndex");
+}
+
+//-----------------------------------------------------------------------------
+// Get the list of available font filenames, and load the name for each of
+// them. Only that, though, not the glyphs too.
+//-----------------------------------------------------------------------------
 void TtfFontList::LoadAll() {
     if(loaded) return;
 
+    std::map<std::string, FontIndexEntry> oldIndex = ReadFontIndex(), newIndex;
+    bool indexChanged = false;
+
+    // Fonts that were already found by FindFont stay where they are, since
+    // they may have a face and glyphs loaded.
+    int found = l.n;
     for(const std::string &font : GetFontFiles()) {
-        TtfFont tf = {};
-        tf.fontFile = font;
-        if(tf.LoadFromFile(fontLibrary))
-            l.Add(&tf);
+        FontIndexEntry fie = {};
+        if(!ssstat(font, &fie.mtime, &fie.size)) continue;
+
+        auto it = oldIndex.find(font);
+        if(it != oldIndex.end() &&
+           it->second.mtime == fie.mtime && it->second.size == fie.size) {
+            fie.name = it->second.name;
+        } else {
+            TtfFont tf = {};
+            tf.fontFile = font;
+            if(tf.LoadFromFile(fontLibrary))
+                fie.name = tf.name;
+            indexChanged = true;
+        }
+        newIndex[font] = fie;
+        if(fie.name.empty()) continue;
+
+        TtfFont *tf = std::find_if(&l.elem[0], &l.elem[found],
+            [&](const TtfFont &tf) { return tf.fontFile == font; });
+        if(tf != &l.elem[found]) {
+            tf->name = fie.name;
+        } else {
+            TtfFont ntf = {};
+            ntf.fontFile = font;
+            ntf.name     = fie.name;
+            l.Add(&ntf);
+        }
+    }
+    if(indexChanged || newIndex.size() != oldIndex.size()) {
+        WriteFontIndex(newIndex);
     }
 
-    // Sort fonts according to their actual name, not filename.
+    // Sort fonts according to their actual name, not filename. Among fonts
+    // with the same name, the ones already in use go first, so that those
+    // are the ones kept below.
     std::sort(&l.elem[0], &l.elem[l.n],
-        [](const TtfFont &a, const TtfFont &b) { return a.name < b.name; });
+        [](const TtfFont &a, const TtfFont &b) {
+            if(a.name != b.name) return a.name < b.name;
+            return a.fontFace != NULL && b.fontFace == NULL;
+        });
 
     // Filter out fonts with the same family and style name. This is not
     // strictly necessarily the exact same font, but it will almost always be.
@@ -79,16 +168,33 @@ void TtfFontList::LoadAll() {
     loaded = true;
 }
 
-void TtfFontList::PlotString(const std::string &font, const std::string &str,
-                             SBezierList *sbl, Vector origin, Vector u, Vector v)
-{
-    LoadAll();
-
+//-----------------------------------------------------------------------------
+// Find a font by the basename of its file. That doesn't need the names of
+// the fonts, so if those aren't loaded yet, just look for the file.
+//-----------------------------------------------------------------------------
+TtfFont *TtfFontList::FindFont(const std::string &font) {
     TtfFont *tf = std::find_if(&l.elem[0], &l.elem[l.n],
         [&](const TtfFont &tf) { return tf.FontFileBaseName() == font; });
+    if(tf != &l.elem[l.n]) return tf;
+    if(loaded) return NULL;
 
-    if(!str.empty() && tf != &l.elem[l.n]) {
-        tf->LoadFromFile(fontLibrary, /*nameOnly=*/false);
+    for(const std::string &fontFile : GetFontFiles()) {
+        TtfFont ntf = {};
+        ntf.fontFile = fontFile;
+        if(ntf.FontFileBaseName() != font) continue;
+
+        l.Add(&ntf);
+        return &l.elem[l.n - 1];
+    }
+    return NULL;
+}
+
+void TtfFontList::PlotString(const std::string &font, const std::string &str,
+                             SBezierList *sbl, Vector origin, Vector u, Vector v)
+{
+    TtfFont *tf = FindFont(font);
+    if(!str.empty() && tf != NULL &&
+       (tf->fontFace != NULL || tf->LoadFromFile(fontLibrary, /*nameOnly=*/false))) {
         tf->PlotString(str, sbl, origin, u, v);
     } else {
         // No text or no font; so draw a big X for an error marker.
@@ -128,6 +234,7 @@ bool TtfFont::LoadFromFile(FT_Library fontLibrary, bool nameOnly) {
     if(int fterr = FT_Open_Face(fontLibrary, &args, 0, &fontFace)) {
         dbp("freetype: loading font from file '%s' failed: %s",
             fontFile.c_str(), ft_error_string(fterr));
+        fontFace = NULL;
         return false;
     }
 
@@ -135,6 +242,7 @@ bool TtfFont::LoadFromFile(FT_Library fontLibrary, bool nameOnly) {
         dbp("freetype: loading unicode CMap for file '%s' failed: %s",
             fontFile.c_str(), ft_error_string(fterr));
         FT_Done_Face(fontFace);
+        fontFace = NULL;
         return false;
     }
 
@@ -150,18 +258,12 @@ bool TtfFont::LoadFromFile(FT_Library fontLibrary, bool nameOnly) {
 }
 
 typedef struct OutlineData {
-    Vector       origin, u, v; // input parameters
-    SBezierList *beziers;      // output bezier list
-    float        factor;       // ratio between freetype and solvespace coordinates
-    FT_Pos       bx;           // x offset of the current glyph
-    FT_Pos       px, py;       // current point
+    std::vector<SBezier> *beziers; // output bezier list
+    FT_Pos                px, py;  // current point
 } OutlineData;
 
-static Vector Transform(OutlineData *data, FT_Pos x, FT_Pos y) {
-    Vector r = data->origin;
-    r = r.Plus(data->u.ScaledBy((float)(data->bx + x) * data->factor));
-    r = r.Plus(data->v.ScaledBy((float)y * data->factor));
-    return r;
+static Vector Point(FT_Pos x, FT_Pos y) {
+    return Vector::From((double)x, (double)y, 0.0);
 }
 
 static int MoveTo(const FT_Vector *p, void *cc)
@@ -175,10 +277,9 @@ static int MoveTo(const FT_Vector *p, void *cc)
 static int LineTo(const FT_Vector *p, void *cc)
 {
     OutlineData *data = (OutlineData *) cc;
-    SBezier sb = SBezier::From(
-        Transform(data, data->px, data->py),
-        Transform(data, p->x,     p->y));
-    data->beziers->l.Add(&sb);
+    data->beziers->push_back(SBezier::From(
+        Point(data->px, data->py),
+        Point(p->x,     p->y)));
     data->px = p->x;
     data->py = p->y;
     return 0;
@@ -187,11 +288,10 @@ static int LineTo(const FT_Vector *p, void *cc)
 static int ConicTo(const FT_Vector *c, const FT_Vector *p, void *cc)
 {
     OutlineData *data = (OutlineData *) cc;
-    SBezier sb = SBezier::From(
-        Transform(data, data->px, data->py),
-        Transform(data, c->x,     c->y),
-        Transform(data, p->x,     p->y));
-    data->beziers->l.Add(&sb);
+    data->beziers->push_back(SBezier::From(
+        Point(data->px, data->py),
+        Point(c->x,     c->y),
+        Point(p->x,     p->y)));
     data->px = p->x;
     data->py = p->y;
     return 0;
@@ -200,12 +300,11 @@ static int ConicTo(const FT_Vector *c, const FT_Vector *p, void *cc)
 static int CubicTo(const FT_Vector *c1, const FT_Vector *c2, const FT_Vector *p, void *cc)
 {
     OutlineData *data = (OutlineData *) cc;
-    SBezier sb = SBezier::From(
-        Transform(data, data->px, data->py),
-        Transform(data, c1->x,    c1->y),
-        Transform(data, c2->x,    c2->y),
-        Transform(data, p->x,     p->y));
-    data->beziers->l.Add(&sb);
+    data->beziers->push_back(SBezier::From(
+        Point(data->px, data->py),
+        Point(c1->x,    c1->y),
+        Point(c2->x,    c2->y),
+        Point(p->x,     p->y)));
     data->px = p->x;
     data->py = p->y;
     return 0;
@@ -215,11 +314,69 @@ static const FT_Outline_Funcs outline_funcs = {
     MoveTo, LineTo, ConicTo, CubicTo, 0, 0
 };
 
+//-----------------------------------------------------------------------------
+// Get the outline of a glyph, in font units. It's only decomposed through
+// FreeType the first time; after that it comes from the cache.
+//-----------------------------------------------------------------------------
+const TtfGlyph *TtfFont::LoadGlyph(uint32_t gid) {
+    auto it = glyphs.find(gid);
+    if(it != glyphs.end()) return &it->second;
+
+    FT_F26Dot6 scale = fontFace->units_per_EM;
+    if(int fterr = FT_Set_Char_Size(fontFace, scale, scale, 72, 72)) {
+        dbp("freetype: cannot set character size: %s",
+            ft_error_string(fterr));
+        return NULL;
+    }
+
+    /*
+     * Stupid hacks:
+     *  - if we want fake-bold, use FT_Outline_Embolden(). This actually looks
+     *    quite good.
+     *  - if we want fake-italic, apply a shear transform [1 s s 1 0 0] here using
+     *    FT_Set_Transform. This looks decent at small font sizes and bad at larger
+     *    ones, antialiasing mitigates this considerably though.
+     */
+    if(int fterr = FT_Load_Glyph(fontFace, gid, FT_LOAD_NO_BITMAP | FT_LOAD_NO_HINTING)) {
+        dbp("freetype: cannot load glyph (gid %d): %s",
+            gid, ft_error_string(fterr));
+        return NULL;
+    }
+
+    /* There's no point in getting the glyph BBox here - not only can it be
+     * needlessly slow sometimes, but because we're about to render a single glyph,
+     * what we want actually *is* the CBox.
+     */
+    FT_BBox cbox;
+    FT_Outline_Get_CBox(&fontFace->glyph->outline, &cbox);
+
+    TtfGlyph glyph = {};
+    glyph.xMin     = cbox.xMin;
+    // Yes, this is what FreeType calls left-side bearing.
+    // Then interchangeably uses that with "left-side bearing". Sigh.
+    glyph.bearingX = fontFace->glyph->metrics.horiBearingX;
+    glyph.advanceX = fontFace->glyph->advance.x;
+
+    OutlineData data = {};
+    data.beziers = &glyph.outline;
+    if(int fterr = FT_Outline_Decompose(&fontFace->glyph->outline, &outline_funcs, &data)) {
+        dbp("freetype: bezier decomposition failed (gid %d): %s",
+            gid, ft_error_string(fterr));
+    }
+
+    TtfGlyph *cached = &glyphs[gid];
+    *cached = std::move(glyph);
+    return cached;
+}
+
 void TtfFont::PlotString(const std::string &str,
                          SBezierList *sbl, Vector origin, Vector u, Vector v)
 {
     ssassert(fontFace != NULL, "Expected font face to be loaded");
 
+    // Ratio between freetype and solvespace coordinates.
+    float factor = 1.0f/(float)fontFace->units_per_EM;
+
     FT_Pos dx = 0;
     for(char32_t chr : ReadUTF8(str)) {
         uint32_t gid = FT_Get_Char_Index(fontFace, chr);
@@ -228,61 +385,35 @@ void TtfFont::PlotString(const std::string &str,
                 chr, ft_error_string(gid));
         }
 
-        FT_F26Dot6 scale = fontFace->units_per_EM;
-        if(int fterr = FT_Set_Char_Size(fontFace, scale, scale, 72, 72)) {
-            dbp("freetype: cannot set character size: %s",
-                ft_error_string(fterr));
-            return;
-        }
-
-        /*
-         * Stupid hacks:
-         *  - if we want fake-bold, use FT_Outline_Embolden(). This actually looks
-         *    quite good.
-         *  - if we want fake-italic, apply a shear transform [1 s s 1 0 0] here using
-         *    FT_Set_Transform. This looks decent at small font sizes and bad at larger
-         *    ones, antialiasing mitigates this considerably though.
-         */
-        if(int fterr = FT_Load_Glyph(fontFace, gid, FT_LOAD_NO_BITMAP | FT_LOAD_NO_HINTING)) {
-            dbp("freetype: cannot load glyph (gid %d): %s",
-                gid, ft_error_string(fterr));
-            return;
-        }
+        const TtfGlyph *glyph = LoadGlyph(gid);
+        if(glyph == NULL) return;
 
         /* A point that has x = xMin should be plotted at (dx0 + lsb); fix up
          * our x-position so that the curve-generating code will put stuff
          * at the right place.
          *
-         * There's no point in getting the glyph BBox here - not only can it be
-         * needlessly slow sometimes, but because we're about to render a single glyph,
-         * what we want actually *is* the CBox.
-         *
          * This is notwithstanding that this makes extremely little sense, this
          * looks like a workaround for either mishandling the start glyph on a line,
          * or as a really hacky pseudo-track-kerning (in which case it works better than
          * one would expect! especially since most fonts don't set track kerning).
          */
-        FT_BBox cbox;
-        FT_Outline_Get_CBox(&fontFace->glyph->outline, &cbox);
-        FT_Pos bx = dx - cbox.xMin;
-        // Yes, this is what FreeType calls left-side bearing.
-        // Then interchangeably uses that with "left-side bearing". Sigh.
-        bx += fontFace->glyph->metrics.horiBearingX;
-
-        OutlineData data = {};
-        data.origin  = origin;
-        data.u       = u;
-        data.v       = v;
-        data.beziers = sbl;
-        data.factor  = 1.0f/(float)scale;
-        data.bx      = bx;
-        if(int fterr = FT_Outline_Decompose(&fontFace->glyph->outline, &outline_funcs, &data)) {
-            dbp("freetype: bezier decomposition failed (gid %d): %s",
-                gid, ft_error_string(fterr));
+        FT_Pos bx = dx - glyph->xMin + glyph->bearingX;
+
+        for(const SBezier &gsb : glyph->outline) {
+            SBezier sb = gsb;
+            for(int i = 0; i <= sb.deg; i++) {
+                FT_Pos x = (FT_Pos)gsb.ctrl[i].x,
+                       y = (FT_Pos)gsb.ctrl[i].y;
+                Vector r = origin;
+                r = r.Plus(u.ScaledBy((float)(bx + x) * factor));
+                r = r.Plus(v.ScaledBy((float)y * factor));
+                sb.ctrl[i] = r;
+            }
+            sbl->l.Add(&sb);
         }
 
         // And we're done, so advance our position by the requested advance
         // width, plus the user-requested extra advance.
-        dx += fontFace->glyph->advance.x;
+        dx += glyph->advanceX;
     }
 }
@@ -9,14 +9,29 @@
 #ifndef __TTF_H
 #define __TTF_H
 
+// The outline of a single glyph, in font units and relative to the glyph
+// origin, along with the metrics needed to place it on the baseline.
+class TtfGlyph {
+public:
+    std::vector<SBezier> outline;
+    long                 xMin;
+    long                 bearingX;
+    long                 advanceX;
+};
+
 class TtfFont {
 public:
     std::string     fontFile;
     std::string     name;
     FT_FaceRec_    *fontFace;
 
+    // Decomposed outlines, by glyph index, so that plotting the same text
+    // again doesn't have to go through FreeType.
+    std::map<uint32_t, TtfGlyph> glyphs;
+
     std::string FontFileBaseName() const;
     bool LoadFromFile(FT_LibraryRec_ *fontLibrary, bool nameOnly = true);
+    const TtfGlyph *LoadGlyph(uint32_t gid);
 
     void PlotString(const std::string &str,
                     SBezierList *sbl, Vector origin, Vector u, Vector v);
@@ -32,6 +47,7 @@ public:
     ~TtfFontList();
 
     void LoadAll();
+    TtfFont *FindFont(const std::string &font);
 
     void PlotString(const std::string &font, const std::string &str,
                     SBezierList *sbl, Vector origin, Vector u, Vector v);
@@ -248,7 +248,8 @@ public:
         STYLE_INFO          = 6,
         PASTE_TRANSFORMED   = 7,
         EDIT_VIEW           = 8,
-        TANGENT_ARC         = 9
+        TANGENT_ARC         = 9,
+        PROFILE             = 10
     };
     typedef struct {
         Screen  screen;
@@ -366,6 +367,7 @@ public:
     void ShowPasteTransformed();
     void ShowEditView();
     void ShowTangentArc();
+    void ShowProfile();
     // Special screen, based on selection
     void DescribeSelection();
 
@@ -410,6 +412,9 @@ public:
     static void ScreenShowConfiguration(int link, uint32_t v);
     static void ScreenShowEditView(int link, uint32_t v);
     static void ScreenGoToWebsite(int link, uint32_t v);
+    static void ScreenShowProfile(int link, uint32_t v);
+    static void ScreenResetProfile(int link, uint32_t v);
+    static void ScreenSaveProfile(int link, uint32_t v);
 
     static void ScreenChangeFixExportColors(int link, uint32_t v);
     static void ScreenChangeBackFaces(int link, uint32_t v);
@@ -533,6 +538,37 @@ public:
         double  scale;
     }       cached;
 
+    // A uniform grid over the screen, that lists in each cell the entities
+    // and constraints whose screen bounding box, grown by the selection
+    // radius, overlaps that cell. Hit testing then measures the distance
+    // only to what's listed in the cell under the mouse, and to everything
+    // that has no bounding box at all.
+    class HitTestGrid {
+    public:
+        enum { CELL_SIZE = 32 };
+
+        class Cell {
+        public:
+            std::vector<hEntity>     entities;
+            std::vector<hConstraint> constraints;
+        };
+
+        bool                valid;
+        // Set when the next paint is only to show a new hover, which
+        // doesn't change anything that the grid depends on.
+        bool                paintIsForHover;
+        int                 entityCount;
+        int                 constraintCount;
+        double              left, bottom;
+        int                 cols, rows;
+        std::vector<Cell>   cells;
+        Cell                unbounded;
+
+        void Build(double width, double height);
+        void CellRange(const BBox &box, int *col0, int *row0, int *col1, int *row1);
+        Cell *CellAt(Point2d p);
+    }       hitTestGrid;
+
     // Most recent mouse position, updated every time the mouse moves.
     Point2d currentMousePosition;
 
@@ -613,6 +649,15 @@ public:
     hRequest AddRequest(Request::Type type, bool rememberForUndo);
     hRequest AddRequest(Request::Type type);
 
+    // Import and paste add many requests at once. Within a batch, each new
+    // request's entities are generated on their own as it's added, instead
+    // of by regenerating the whole sketch; that happens once, at the end of
+    // the outermost batch.
+    int         batchDepth;
+    void BeginBatch();
+    void EndBatch();
+    void GenerateNewRequest(hRequest hr);
+
     class ParametricCurve {
     public:
         bool isLine; // else circle
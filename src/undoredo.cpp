@@ -62,9 +62,14 @@ void SolveSpaceUI::PushFromCurrentOnto(UndoStack *uk) {
         dest.runningMesh = {};
         dest.thisShell = {};
         dest.runningShell = {};
+        dest.runningInstances = {};
         dest.displayMesh = {};
+        dest.displayBuffers = {};
+        dest.displayBvh = {};
         dest.displayEdges = {};
         dest.displayOutlines = {};
+        dest.displayEntities = {};
+        dest.displayHiddenEntities = {};
 
         dest.remap = {};
         src->remap.DeepCopyInto(&(dest.remap));
@@ -5,6 +5,10 @@
 // Copyright 2008-2013 Jonathan Westhues.
 //-----------------------------------------------------------------------------
 #include "solvespace.h"
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 std::string SolveSpace::ssprintf(const char *fmt, ...)
 {
@@ -171,6 +175,163 @@ bool SolveSpace::CnfThawBool(bool v, const std::string &name)
 RgbaColor SolveSpace::CnfThawColor(RgbaColor v, const std::string &name)
     { return RgbaColor::FromPackedInt(CnfThawInt(v.ToPackedInt(), name)); }
 
+//-----------------------------------------------------------------------------
+// A pool of worker threads, started the first time that it's needed and kept
+// for the life of the process. It runs one loop at a time; the thread that
+// asks for the loop takes a share of the iterations too. A loop started from
+// within another one, or while another thread's loop has the pool, just runs
+// on the calling thread, rather than waiting for the pool.
+//-----------------------------------------------------------------------------
+namespace {
+class WorkerPool {
+public:
+    std::mutex                      loopMutex;
+    std::mutex                      mutex;
+    std::condition_variable         started, finished;
+    std::vector<std::thread>        threads;
+
+    const std::function<void(int)> *fn;
+    int                             n;
+    std::atomic<int>                next;
+    int                             running;
+    unsigned                        loop;
+
+    // Whatever the thread that started the loop works on, so that the
+    // worker threads work on the same.
+    Sketch                         *sketch;
+#ifndef LIBRARY
+    Profiler                       *profiler;
+    std::vector<Profiler::Phase>    phases;
+    SEdgeList                      *nakedEdges;
+    Regeneration                   *regeneration;
+#endif
+
+    WorkerPool() : fn(NULL), n(0), next(0), running(0), loop(0), sketch(NULL) {
+        unsigned cpus = std::thread::hardware_concurrency();
+        for(unsigned i = 1; i < cpus; i++) {
+            threads.emplace_back([this] { Work(); });
+            threads.back().detach();
+        }
+    }
+
+    void RunIterations(const std::function<void(int)> &f, int count) {
+        int i;
+        while((i = next++) < count) f(i);
+    }
+
+    void Work();
+    void Run(int count, const std::function<void(int)> &f);
+};
+}
+
+static thread_local bool InParallelFor = false;
+
+void WorkerPool::Work() {
+    InParallelFor = true;
+    unsigned seen = 0;
+    for(;;) {
+        std::unique_lock<std::mutex> lock(mutex);
+        started.wait(lock, [&] { return loop != seen; });
+        seen = loop;
+        const std::function<void(int)> *f = fn;
+        int count = n;
+        SketchInUse       = sketch;
+#ifndef LIBRARY
+        ProfilerInUse     = profiler;
+        Profiler::stack   = phases;
+        NakedEdgesInUse   = nakedEdges;
+        RegenerationInUse = regeneration;
+#endif
+        lock.unlock();
+
+        RunIterations(*f, count);
+
+        lock.lock();
+        if(--running == 0) finished.notify_one();
+    }
+}
+
+void WorkerPool::Run(int count, const std::function<void(int)> &f) {
+    std::unique_lock<std::mutex> loopLock(loopMutex, std::try_to_lock);
+    if(!loopLock.owns_lock()) {
+        for(int i = 0; i < count; i++) f(i);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        fn           = &f;
+        n            = count;
+        next         = 0;
+        running      = (int)threads.size();
+        sketch       = SketchInUse;
+#ifndef LIBRARY
+        profiler     = ProfilerInUse;
+        phases       = Profiler::stack;
+        nakedEdges   = NakedEdgesInUse;
+        regeneration = RegenerationInUse;
+#endif
+        loop++;
+    }
+    started.notify_all();
+
+    InParallelFor = true;
+    RunIterations(f, count);
+    InParallelFor = false;
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [&] { return running == 0; });
+}
+
+void SolveSpace::ParallelFor(int n, const std::function<void(int)> &fn) {
+    static WorkerPool *Pool = new WorkerPool();
+    if(n <= 1 || InParallelFor || Pool->threads.empty()) {
+        for(int i = 0; i < n; i++) fn(i);
+        return;
+    }
+    Pool->Run(n, fn);
+}
+
+//-----------------------------------------------------------------------------
+// Everything that wants pseudorandom numbers wants the same ones every time,
+// so it starts again from the beginning of the sequence that rand() gives
+// after srand(0). We keep what we've drawn of that sequence, and each thread
+// reads it from its own place, so that one thread starting again doesn't
+// disturb another that's halfway through.
+//-----------------------------------------------------------------------------
+static std::mutex          RandomMutex;
+static std::vector<int>    RandomSequence;
+static thread_local size_t RandomNext;
+
+// Call with RandomMutex held.
+static int RandomAt(size_t i) {
+    if(RandomSequence.empty()) srand(0);
+    while(RandomSequence.size() <= i) {
+        RandomSequence.push_back(rand());
+    }
+    return RandomSequence[i];
+}
+
+void SolveSpace::RestartRandom() {
+    RandomNext = 0;
+}
+
+double SolveSpace::Random(double vmax) {
+    std::lock_guard<std::mutex> lock(RandomMutex);
+    return (vmax*RandomAt(RandomNext++)) / RAND_MAX;
+}
+
+void SolveSpace::ShuffleDeterministically(int count,
+                                          const std::function<void(int, int)> &swapFn) {
+    std::lock_guard<std::mutex> lock(RandomMutex);
+    int n = count;
+    size_t i = 0;
+    while(n > 1) {
+        int k = RandomAt(i++) % n;
+        n--;
+        swapFn(k, n);
+    }
+}
+
 //-----------------------------------------------------------------------------
 // Solve a mostly banded matrix. In a given row, there are LEFT_OF_DIAG
 // elements to the left of the diagonal element, and RIGHT_OF_DIAG elements to